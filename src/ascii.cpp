@@ -0,0 +1,160 @@
+#include "vendor.h"
+#include "ascii.h"
+#include "simd.h"
+
+namespace php {
+	// 批量函数: 返回已处理的输入长度
+	typedef std::size_t (*ascii_case_fn)(char* dst, const char* src, std::size_t len, bool upper);
+	typedef std::size_t (*ascii_iequal_fn)(const char* a, const char* b, std::size_t len);
+
+	static inline char ascii_lower_char(char c) {
+		return static_cast<unsigned char>(c - 'A') < 26 ? c | 0x20 : c;
+	}
+	static inline char ascii_upper_char(char c) {
+		return static_cast<unsigned char>(c - 'a') < 26 ? c & ~0x20 : c;
+	}
+	// 8 字节一组转为小写: 仅最高位为 0 且位于 'A' ~ 'Z' 的字节置位 0x20
+	static inline std::uint64_t ascii_lower_word(std::uint64_t w) {
+		const std::uint64_t high = 0x8080808080808080ull;
+		std::uint64_t b = w & ~high;
+		std::uint64_t ge_a = b + 0x0101010101010101ull * (0x80 - 'A');
+		std::uint64_t gt_z = b + 0x0101010101010101ull * (0x80 - 'Z' - 1);
+		return w | (((ge_a ^ gt_z) & ~w & high) >> 2);
+	}
+	static std::size_t ascii_case_none(char* dst, const char* src, std::size_t len, bool upper) {
+		return 0;
+	}
+	static std::size_t ascii_iequal_none(const char* a, const char* b, std::size_t len) {
+		return 0;
+	}
+#ifdef PHPEXT_SIMD_X86
+	// 字母字节的掩码: c - first 落在 [0, 26) 即 c + (0x80 - first) 在有符号比较中小于 -128 + 26
+	PHPEXT_TARGET("sse2")
+	static inline __m128i ascii_alpha_sse2(__m128i c, char first) {
+		return _mm_cmplt_epi8(_mm_add_epi8(c, _mm_set1_epi8(static_cast<char>(0x80 - first))), _mm_set1_epi8(-128 + 26));
+	}
+	PHPEXT_TARGET("sse2")
+	static std::size_t ascii_case_sse2(char* dst, const char* src, std::size_t len, bool upper) {
+		const __m128i bit = _mm_set1_epi8(0x20);
+		std::size_t n = 0;
+		for(; len - n >= 16; n += 16) {
+			__m128i c = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + n));
+			c = _mm_xor_si128(c, _mm_and_si128(ascii_alpha_sse2(c, upper ? 'a' : 'A'), bit));
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(dst + n), c);
+		}
+		return n;
+	}
+	PHPEXT_TARGET("sse2")
+	static std::size_t ascii_iequal_sse2(const char* a, const char* b, std::size_t len) {
+		const __m128i bit = _mm_set1_epi8(0x20);
+		std::size_t n = 0;
+		for(; len - n >= 16; n += 16) {
+			__m128i x = _mm_loadu_si128(reinterpret_cast<const __m128i*>(a + n));
+			__m128i y = _mm_loadu_si128(reinterpret_cast<const __m128i*>(b + n));
+			x = _mm_or_si128(x, _mm_and_si128(ascii_alpha_sse2(x, 'A'), bit));
+			y = _mm_or_si128(y, _mm_and_si128(ascii_alpha_sse2(y, 'A'), bit));
+			if(_mm_movemask_epi8(_mm_cmpeq_epi8(x, y)) != 0xffff) break;
+		}
+		return n;
+	}
+	PHPEXT_TARGET("avx2")
+	static inline __m256i ascii_alpha_avx2(__m256i c, char first) {
+		return _mm256_cmpgt_epi8(_mm256_set1_epi8(-128 + 26), _mm256_add_epi8(c, _mm256_set1_epi8(static_cast<char>(0x80 - first))));
+	}
+	PHPEXT_TARGET("avx2")
+	static std::size_t ascii_case_avx2(char* dst, const char* src, std::size_t len, bool upper) {
+		const __m256i bit = _mm256_set1_epi8(0x20);
+		std::size_t n = 0;
+		for(; len - n >= 32; n += 32) {
+			__m256i c = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + n));
+			c = _mm256_xor_si256(c, _mm256_and_si256(ascii_alpha_avx2(c, upper ? 'a' : 'A'), bit));
+			_mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + n), c);
+		}
+		return n + ascii_case_sse2(dst + n, src + n, len - n, upper);
+	}
+	PHPEXT_TARGET("avx2")
+	static std::size_t ascii_iequal_avx2(const char* a, const char* b, std::size_t len) {
+		const __m256i bit = _mm256_set1_epi8(0x20);
+		std::size_t n = 0;
+		for(; len - n >= 32; n += 32) {
+			__m256i x = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(a + n));
+			__m256i y = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(b + n));
+			x = _mm256_or_si256(x, _mm256_and_si256(ascii_alpha_avx2(x, 'A'), bit));
+			y = _mm256_or_si256(y, _mm256_and_si256(ascii_alpha_avx2(y, 'A'), bit));
+			if(static_cast<std::uint32_t>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(x, y))) != 0xffffffffu) return n;
+		}
+		return n + ascii_iequal_sse2(a + n, b + n, len - n);
+	}
+#endif
+	static ascii_case_fn ascii_case_select() {
+#ifdef PHPEXT_SIMD_X86
+		if(cpu_support(cpu_feature::AVX2)) return ascii_case_avx2;
+		if(cpu_support(cpu_feature::SSE2)) return ascii_case_sse2;
+#endif
+		return ascii_case_none;
+	}
+	static ascii_iequal_fn ascii_iequal_select() {
+#ifdef PHPEXT_SIMD_X86
+		if(cpu_support(cpu_feature::AVX2)) return ascii_iequal_avx2;
+		if(cpu_support(cpu_feature::SSE2)) return ascii_iequal_sse2;
+#endif
+		return ascii_iequal_none;
+	}
+	void ascii_lower_to(char* dst, const char* src, std::size_t len) {
+		static ascii_case_fn fn = ascii_case_select();
+		for(std::size_t i = fn(dst, src, len, false); i < len; ++i) dst[i] = ascii_lower_char(src[i]);
+	}
+	void ascii_upper_to(char* dst, const char* src, std::size_t len) {
+		static ascii_case_fn fn = ascii_case_select();
+		for(std::size_t i = fn(dst, src, len, true); i < len; ++i) dst[i] = ascii_upper_char(src[i]);
+	}
+	void ascii_lower_inplace(char* str, std::size_t len) {
+		ascii_lower_to(str, str, len);
+	}
+	void ascii_upper_inplace(char* str, std::size_t len) {
+		ascii_upper_to(str, str, len);
+	}
+	php::string ascii_lower(const char* str, std::size_t len) {
+		php::string s(len);
+		ascii_lower_to(s.data(), str, len);
+		return s;
+	}
+	php::string ascii_upper(const char* str, std::size_t len) {
+		php::string s(len);
+		ascii_upper_to(s.data(), str, len);
+		return s;
+	}
+	bool ascii_iequal(const char* a, const char* b, std::size_t len) {
+		static ascii_iequal_fn fn = ascii_iequal_select();
+		for(std::size_t i = fn(a, b, len); i < len; ++i) {
+			if(ascii_lower_char(a[i]) != ascii_lower_char(b[i])) return false;
+		}
+		return true;
+	}
+	bool ascii_iequal(const char* a, std::size_t alen, const char* b, std::size_t blen) {
+		return alen == blen && ascii_iequal(a, b, alen);
+	}
+	zend_ulong ascii_ihash(const char* str, std::size_t len) {
+		// hash = hash * 33 + c 按 8 字节展开: hash * 33^8 + Σ c[i] * 33^(7-i), 缩短依赖链
+		// 同 zend_inline_hash_func(), 字节以 char 参与运算 (x86 等 char 有符号的平台上 0x80 以上的字节符号扩展)
+		zend_ulong hash = 5381;
+		std::size_t i = 0;
+		for(; len - i >= 8; i += 8) {
+			std::uint64_t w;
+			std::memcpy(&w, str + i, 8);
+			w = ascii_lower_word(w);
+			char c[8];
+			std::memcpy(c, &w, 8);
+			hash = hash * 1406408618241ull
+				+ c[0] * 42618442977ull + c[1] * 1291467969ull + c[2] * 39135393ull + c[3] * 1185921ull
+				+ c[4] * 35937ull + c[5] * 1089ull + c[6] * 33ull + c[7];
+		}
+		for(; i < len; ++i) hash = hash * 33 + ascii_lower_char(str[i]);
+		// 同 zend_inline_hash_func(): 最高位置 1, 保证结果非 0
+#if SIZEOF_ZEND_LONG == 8
+		return hash | 0x8000000000000000ull;
+#else
+		return hash | 0x80000000ul;
+#endif
+	}
+}
@@ -0,0 +1,19 @@
+#pragma once
+
+#include "string.h"
+
+namespace php {
+	// 仅转换 ASCII 字母 (与区域设置无关, 同 zend_str_tolower), 其余字节不变; 写入 dst (至少 len 空间, 允许 dst == src)
+	void ascii_lower_to(char* dst, const char* src, std::size_t len);
+	void ascii_upper_to(char* dst, const char* src, std::size_t len);
+	void ascii_lower_inplace(char* str, std::size_t len);
+	void ascii_upper_inplace(char* str, std::size_t len);
+	string ascii_lower(const char* str, std::size_t len);
+	string ascii_upper(const char* str, std::size_t len);
+	// 忽略 ASCII 大小写的相等比较
+	bool ascii_iequal(const char* a, const char* b, std::size_t len);
+	bool ascii_iequal(const char* a, std::size_t alen, const char* b, std::size_t blen);
+	// 忽略 ASCII 大小写的哈希: 等于小写形式的 zend_inline_hash_func() (DJBX33A),
+	// 可直接与类名、函数名等以小写键存储的 HashTable 哈希值比较
+	zend_ulong ascii_ihash(const char* str, std::size_t len);
+}
@@ -0,0 +1,419 @@
+#include "vendor.h"
+#include "base64.h"
+#include "exception.h"
+#include "simd.h"
+
+namespace php {
+	static const char base64_table[2][65] = {
+		"ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/",
+		"ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789-_",
+	};
+	// 反查表: -1 空白字符, -2 非法字符 (与 PHP base64_reverse_table 一致)
+	struct base64_reverse {
+		signed char t[2][256];
+		base64_reverse() {
+			for(int k=0;k<2;++k) {
+				std::memset(t[k], -2, 256);
+				t[k]['\t'] = t[k]['\n'] = t[k]['\r'] = t[k][' '] = -1;
+				for(int i=0;i<64;++i) {
+					t[k][static_cast<unsigned char>(base64_table[k][i])] = i;
+				}
+			}
+		}
+	};
+	static const base64_reverse& base64_reverse_tables() {
+		static base64_reverse table;
+		return table;
+	}
+	// 批量编码 (块) 函数: 返回已消费的输入字节数 (3 的倍数), 输出长度为其 4/3
+	typedef std::size_t (*base64_encode_fn)(char* dst, const unsigned char* src, std::size_t len, int url);
+	// 批量解码 (块) 函数: 遇到非字母表字符即停止, 返回已消费的输入字符数 (4 的倍数), 输出长度为其 3/4
+	typedef std::size_t (*base64_decode_fn)(char* dst, const unsigned char* src, std::size_t len, int url);
+
+	static std::size_t base64_encode_none(char* dst, const unsigned char* src, std::size_t len, int url) {
+		return 0;
+	}
+	static std::size_t base64_decode_none(char* dst, const unsigned char* src, std::size_t len, int url) {
+		return 0;
+	}
+#ifdef PHPEXT_SIMD_X86
+	// 参考: Wojciech Muła, Daniel Lemire "Faster Base64 Encoding and Decoding using AVX2 Instructions"
+	PHPEXT_TARGET("ssse3")
+	static inline __m128i base64_enc_reshuffle(__m128i in) {
+		in = _mm_shuffle_epi8(in, _mm_set_epi8(10, 11, 9, 10, 7, 8, 6, 7, 4, 5, 3, 4, 1, 2, 0, 1));
+		__m128i t0 = _mm_and_si128(in, _mm_set1_epi32(0x0fc0fc00));
+		__m128i t1 = _mm_mulhi_epu16(t0, _mm_set1_epi32(0x04000040));
+		__m128i t2 = _mm_and_si128(in, _mm_set1_epi32(0x003f03f0));
+		__m128i t3 = _mm_mullo_epi16(t2, _mm_set1_epi32(0x01000010));
+		return _mm_or_si128(t1, t3);
+	}
+	PHPEXT_TARGET("ssse3")
+	static inline __m128i base64_enc_translate(__m128i in, __m128i lut) {
+		__m128i idx = _mm_subs_epu8(in, _mm_set1_epi8(51));
+		idx = _mm_sub_epi8(idx, _mm_cmpgt_epi8(in, _mm_set1_epi8(25)));
+		return _mm_add_epi8(in, _mm_shuffle_epi8(lut, idx));
+	}
+	PHPEXT_TARGET("ssse3")
+	static std::size_t base64_encode_ssse3(char* dst, const unsigned char* src, std::size_t len, int url) {
+		// 各区段偏移: A-Z a-z 0-9 以及 62/63 两个字符
+		const __m128i lut = url
+			? _mm_setr_epi8(65, 71, -4, -4, -4, -4, -4, -4, -4, -4, -4, -4, -17, 32, 0, 0)
+			: _mm_setr_epi8(65, 71, -4, -4, -4, -4, -4, -4, -4, -4, -4, -4, -19, -16, 0, 0);
+		std::size_t n = 0;
+		// 每次读取 16 字节仅使用 12 字节
+		for(; len - n >= 16; n += 12, dst += 16) {
+			__m128i in = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + n));
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(dst), base64_enc_translate(base64_enc_reshuffle(in), lut));
+		}
+		return n;
+	}
+	PHPEXT_TARGET("avx2")
+	static std::size_t base64_encode_avx2(char* dst, const unsigned char* src, std::size_t len, int url) {
+		const __m256i shuf = _mm256_setr_epi8(
+			1, 0, 2, 1, 4, 3, 5, 4, 7, 6, 8, 7, 10, 9, 11, 10,
+			1, 0, 2, 1, 4, 3, 5, 4, 7, 6, 8, 7, 10, 9, 11, 10);
+		const __m256i lut = url
+			? _mm256_setr_epi8(65, 71, -4, -4, -4, -4, -4, -4, -4, -4, -4, -4, -17, 32, 0, 0,
+				65, 71, -4, -4, -4, -4, -4, -4, -4, -4, -4, -4, -17, 32, 0, 0)
+			: _mm256_setr_epi8(65, 71, -4, -4, -4, -4, -4, -4, -4, -4, -4, -4, -19, -16, 0, 0,
+				65, 71, -4, -4, -4, -4, -4, -4, -4, -4, -4, -4, -19, -16, 0, 0);
+		std::size_t n = 0;
+		// 两个 128 位通道各处理 12 字节 (读取 16 字节)
+		for(; len - n >= 28; n += 24, dst += 32) {
+			__m256i in = _mm256_inserti128_si256(_mm256_castsi128_si256(
+				_mm_loadu_si128(reinterpret_cast<const __m128i*>(src + n))),
+				_mm_loadu_si128(reinterpret_cast<const __m128i*>(src + n + 12)), 1);
+			in = _mm256_shuffle_epi8(in, shuf);
+			__m256i t0 = _mm256_and_si256(in, _mm256_set1_epi32(0x0fc0fc00));
+			__m256i t1 = _mm256_mulhi_epu16(t0, _mm256_set1_epi32(0x04000040));
+			__m256i t2 = _mm256_and_si256(in, _mm256_set1_epi32(0x003f03f0));
+			__m256i t3 = _mm256_mullo_epi16(t2, _mm256_set1_epi32(0x01000010));
+			in = _mm256_or_si256(t1, t3);
+			__m256i idx = _mm256_subs_epu8(in, _mm256_set1_epi8(51));
+			idx = _mm256_sub_epi8(idx, _mm256_cmpgt_epi8(in, _mm256_set1_epi8(25)));
+			in = _mm256_add_epi8(in, _mm256_shuffle_epi8(lut, idx));
+			_mm256_storeu_si256(reinterpret_cast<__m256i*>(dst), in);
+		}
+		// 剩余部分交由 SSSE3 处理
+		return n + base64_encode_ssse3(dst, src + n, len - n, url);
+	}
+	// URL 字母表转换为标准字母表 ("-_" -> "+/"), 原 "+/" 转换为非法字符
+	PHPEXT_TARGET("ssse3")
+	static inline __m128i base64_dec_url(__m128i str) {
+		const __m128i bad = _mm_or_si128(
+			_mm_cmpeq_epi8(str, _mm_set1_epi8('+')),
+			_mm_cmpeq_epi8(str, _mm_set1_epi8('/')));
+		const __m128i dash = _mm_cmpeq_epi8(str, _mm_set1_epi8('-'));
+		const __m128i line = _mm_cmpeq_epi8(str, _mm_set1_epi8('_'));
+		str = _mm_or_si128(_mm_andnot_si128(bad, str), _mm_and_si128(bad, _mm_set1_epi8(-1)));
+		str = _mm_or_si128(_mm_andnot_si128(dash, str), _mm_and_si128(dash, _mm_set1_epi8('+')));
+		return _mm_or_si128(_mm_andnot_si128(line, str), _mm_and_si128(line, _mm_set1_epi8('/')));
+	}
+	PHPEXT_TARGET("ssse3")
+	static std::size_t base64_decode_ssse3(char* dst, const unsigned char* src, std::size_t len, int url) {
+		const __m128i lut_lo = _mm_setr_epi8(
+			0x15, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11,
+			0x11, 0x11, 0x13, 0x1A, 0x1B, 0x1B, 0x1B, 0x1A);
+		const __m128i lut_hi = _mm_setr_epi8(
+			0x10, 0x10, 0x01, 0x02, 0x04, 0x08, 0x04, 0x08,
+			0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10);
+		const __m128i lut_roll = _mm_setr_epi8(
+			0, 16, 19, 4, -65, -65, -71, -71, 0, 0, 0, 0, 0, 0, 0, 0);
+		const __m128i mask_2f = _mm_set1_epi8(0x2f);
+		std::size_t n = 0;
+		// 每次写入 16 字节仅有 12 字节有效, 保留足够的输出空间余量
+		for(; len - n >= 28; n += 16, dst += 12) {
+			__m128i str = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + n));
+			if(url) str = base64_dec_url(str);
+			const __m128i hi_nibbles = _mm_and_si128(_mm_srli_epi32(str, 4), mask_2f);
+			const __m128i lo_nibbles = _mm_and_si128(str, mask_2f);
+			const __m128i hi = _mm_shuffle_epi8(lut_hi, hi_nibbles);
+			const __m128i lo = _mm_shuffle_epi8(lut_lo, lo_nibbles);
+			// 存在非字母表字符 (含填充、空白), 交由逐字节处理
+			if(_mm_movemask_epi8(_mm_cmpgt_epi8(_mm_and_si128(lo, hi), _mm_setzero_si128())) != 0) {
+				break;
+			}
+			const __m128i eq_2f = _mm_cmpeq_epi8(str, mask_2f);
+			const __m128i roll = _mm_shuffle_epi8(lut_roll, _mm_add_epi8(eq_2f, hi_nibbles));
+			str = _mm_add_epi8(str, roll);
+			str = _mm_maddubs_epi16(str, _mm_set1_epi32(0x01400140));
+			str = _mm_madd_epi16(str, _mm_set1_epi32(0x00011000));
+			str = _mm_shuffle_epi8(str, _mm_setr_epi8(2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1));
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(dst), str);
+		}
+		return n;
+	}
+	PHPEXT_TARGET("avx2")
+	static std::size_t base64_decode_avx2(char* dst, const unsigned char* src, std::size_t len, int url) {
+		const __m256i lut_lo = _mm256_setr_epi8(
+			0x15, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x13, 0x1A, 0x1B, 0x1B, 0x1B, 0x1A,
+			0x15, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x13, 0x1A, 0x1B, 0x1B, 0x1B, 0x1A);
+		const __m256i lut_hi = _mm256_setr_epi8(
+			0x10, 0x10, 0x01, 0x02, 0x04, 0x08, 0x04, 0x08, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10,
+			0x10, 0x10, 0x01, 0x02, 0x04, 0x08, 0x04, 0x08, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10);
+		const __m256i lut_roll = _mm256_setr_epi8(
+			0, 16, 19, 4, -65, -65, -71, -71, 0, 0, 0, 0, 0, 0, 0, 0,
+			0, 16, 19, 4, -65, -65, -71, -71, 0, 0, 0, 0, 0, 0, 0, 0);
+		const __m256i shuf = _mm256_setr_epi8(
+			2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1,
+			2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1);
+		const __m256i mask_2f = _mm256_set1_epi8(0x2f);
+		std::size_t n = 0;
+		for(; len - n >= 44; n += 32, dst += 24) {
+			__m256i str = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + n));
+			if(url) {
+				str = _mm256_inserti128_si256(_mm256_castsi128_si256(
+					base64_dec_url(_mm256_castsi256_si128(str))),
+					base64_dec_url(_mm256_extracti128_si256(str, 1)), 1);
+			}
+			const __m256i hi_nibbles = _mm256_and_si256(_mm256_srli_epi32(str, 4), mask_2f);
+			const __m256i lo_nibbles = _mm256_and_si256(str, mask_2f);
+			const __m256i hi = _mm256_shuffle_epi8(lut_hi, hi_nibbles);
+			const __m256i lo = _mm256_shuffle_epi8(lut_lo, lo_nibbles);
+			if(_mm256_movemask_epi8(_mm256_cmpgt_epi8(_mm256_and_si256(lo, hi), _mm256_setzero_si256())) != 0) {
+				break;
+			}
+			const __m256i eq_2f = _mm256_cmpeq_epi8(str, mask_2f);
+			const __m256i roll = _mm256_shuffle_epi8(lut_roll, _mm256_add_epi8(eq_2f, hi_nibbles));
+			str = _mm256_add_epi8(str, roll);
+			str = _mm256_maddubs_epi16(str, _mm256_set1_epi32(0x01400140));
+			str = _mm256_madd_epi16(str, _mm256_set1_epi32(0x00011000));
+			str = _mm256_shuffle_epi8(str, shuf);
+			// 两个通道各 12 字节有效
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(dst), _mm256_castsi256_si128(str));
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(dst + 12), _mm256_extracti128_si256(str, 1));
+		}
+		return n + base64_decode_ssse3(dst, src + n, len - n, url);
+	}
+#endif
+	static base64_encode_fn base64_encode_select() {
+#ifdef PHPEXT_SIMD_X86
+		if(cpu_support(cpu_feature::AVX2)) return base64_encode_avx2;
+		if(cpu_support(cpu_feature::SSSE3)) return base64_encode_ssse3;
+#endif
+		return base64_encode_none;
+	}
+	static base64_decode_fn base64_decode_select() {
+#ifdef PHPEXT_SIMD_X86
+		if(cpu_support(cpu_feature::AVX2)) return base64_decode_avx2;
+		if(cpu_support(cpu_feature::SSSE3)) return base64_decode_ssse3;
+#endif
+		return base64_decode_none;
+	}
+	// 编码完整的 3 字节组, 返回输出长度 (剩余 len % 3 字节未处理)
+	static std::size_t base64_encode_blocks(char* dst, const unsigned char* src, std::size_t len, int flags) {
+		static base64_encode_fn fn = base64_encode_select();
+		const char* table = base64_table[flags & BASE64_URL ? 1 : 0];
+		std::size_t n = fn(dst, src, len, flags & BASE64_URL);
+		char* out = dst + n / 3 * 4;
+		for(; len - n >= 3; n += 3) {
+			std::uint32_t v = (src[n] << 16) | (src[n + 1] << 8) | src[n + 2];
+			*out++ = table[(v >> 18) & 0x3f];
+			*out++ = table[(v >> 12) & 0x3f];
+			*out++ = table[(v >>  6) & 0x3f];
+			*out++ = table[ v        & 0x3f];
+		}
+		return out - dst;
+	}
+	// 编码结尾不足 3 字节的数据 (len = 0, 1, 2)
+	static std::size_t base64_encode_tail(char* dst, const unsigned char* src, std::size_t len, int flags) {
+		const char* table = base64_table[flags & BASE64_URL ? 1 : 0];
+		char* out = dst;
+		if(len == 0) return 0;
+		std::uint32_t v = src[0] << 16;
+		if(len > 1) v |= src[1] << 8;
+		*out++ = table[(v >> 18) & 0x3f];
+		*out++ = table[(v >> 12) & 0x3f];
+		if(len > 1) *out++ = table[(v >> 6) & 0x3f];
+		if(!(flags & BASE64_NO_PAD)) {
+			*out++ = '=';
+			if(len == 1) *out++ = '=';
+		}
+		return out - dst;
+	}
+	// 分段解码: 跨调用保持状态, 返回输出长度
+	static std::size_t base64_decode_update(base64_decoder::state& s, char* dst, const char* src, std::size_t len, int flags) {
+		static base64_decode_fn fn = base64_decode_select();
+		const signed char* table = base64_reverse_tables().t[flags & BASE64_URL ? 1 : 0];
+		const unsigned char* p = reinterpret_cast<const unsigned char*>(src);
+		const bool strict = flags & BASE64_STRICT;
+		char* out = dst;
+		std::size_t i = 0;
+		while(i < len) {
+			// 对齐到 4 字符组边界时尝试批量解码
+			if((s.count & 3) == 0 && !(strict && s.padding)) {
+				std::size_t n = fn(out, p + i, len - i, flags & BASE64_URL);
+				out += n / 4 * 3;
+				i += n;
+				// 批量解码以 4 字符组为单位, 不影响计数对齐
+				if(i >= len) break;
+			}
+			// 逐字节处理 (直到再次对齐)
+			do {
+				unsigned char c = p[i++];
+				if(c == '=') {
+					++s.padding;
+					continue;
+				}
+				int v = table[c];
+				if(v < 0) {
+					// 非严格模式跳过全部非字母表字符, 严格模式仅跳过空白
+					if(!strict || v == -1) continue;
+					throw php::exception(zend_ce_error, "invalid base64 string");
+				}
+				if(strict && s.padding) {
+					throw php::exception(zend_ce_error, "invalid base64 string");
+				}
+				s.bits = (s.bits << 6) | v;
+				if((++s.count & 3) == 0) {
+					*out++ = static_cast<char>(s.bits >> 16);
+					*out++ = static_cast<char>(s.bits >> 8);
+					*out++ = static_cast<char>(s.bits);
+					s.bits = 0;
+				}
+			} while(i < len && (s.count & 3) != 0);
+		}
+		return out - dst;
+	}
+	// 结束解码: 输出不完整组中的剩余字节, 返回输出长度
+	static std::size_t base64_decode_finalize(base64_decoder::state& s, char* dst, int flags) {
+		std::uint32_t r = s.count & 3, padding = s.padding;
+		std::uint32_t bits = s.bits;
+		s.bits = 0;
+		s.count = 0;
+		s.padding = 0;
+		if(flags & BASE64_STRICT) {
+			// 与 php_base64_decode_ex(strict = 1) 相同的校验规则
+			if(r == 1 || (padding && (padding > 2 || (r + padding) % 4 != 0))) {
+				throw php::exception(zend_ce_error, "invalid base64 string");
+			}
+		}
+		if(r == 2) {
+			dst[0] = static_cast<char>(bits >> 4);
+			return 1;
+		}else if(r == 3) {
+			dst[0] = static_cast<char>(bits >> 10);
+			dst[1] = static_cast<char>(bits >> 2);
+			return 2;
+		}
+		return 0;
+	}
+	std::size_t base64_encode_length(std::size_t len, int flags) {
+		return (flags & BASE64_NO_PAD) ? (len * 4 + 2) / 3 : (len + 2) / 3 * 4;
+	}
+	std::size_t base64_decode_length(std::size_t len) {
+		return len / 4 * 3 + 3;
+	}
+	std::size_t base64_encode_to(char* dst, const unsigned char* src, std::size_t len, int flags) {
+		std::size_t n = base64_encode_blocks(dst, src, len, flags);
+		return n + base64_encode_tail(dst + n, src + len / 3 * 3, len % 3, flags);
+	}
+	void base64_encode_to(buffer& dst, const unsigned char* src, std::size_t len, int flags) {
+		char* p = dst.prepare(base64_encode_length(len, flags));
+		dst.commit(base64_encode_to(p, src, len, flags));
+	}
+	void base64_encode_to(stream_buffer& dst, const unsigned char* src, std::size_t len, int flags) {
+		char* p = dst.prepare(base64_encode_length(len, flags));
+		dst.commit(base64_encode_to(p, src, len, flags));
+	}
+	std::size_t base64_decode_to(char* dst, const char* src, std::size_t len, int flags) {
+		base64_decoder::state s {0, 0, 0};
+		std::size_t n = base64_decode_update(s, dst, src, len, flags);
+		return n + base64_decode_finalize(s, dst + n, flags);
+	}
+	void base64_decode_to(buffer& dst, const char* src, std::size_t len, int flags) {
+		char* p = dst.prepare(base64_decode_length(len));
+		dst.commit(base64_decode_to(p, src, len, flags));
+	}
+	void base64_decode_to(stream_buffer& dst, const char* src, std::size_t len, int flags) {
+		char* p = dst.prepare(base64_decode_length(len));
+		dst.commit(base64_decode_to(p, src, len, flags));
+	}
+	php::string base64_encode(const unsigned char* str, std::size_t len, int flags) {
+		php::string s(base64_encode_length(len, flags));
+		base64_encode_to(s.data(), str, len, flags);
+		return s;
+	}
+	php::string base64_decode(const unsigned char* str, std::size_t len, int flags) {
+		php::string s(base64_decode_length(len));
+		s.shrink(base64_decode_to(s.data(), reinterpret_cast<const char*>(str), len, flags));
+		return s;
+	}
+	// ---------------------------------------------------------------------
+	base64_encoder::base64_encoder(int flags)
+	: flags_(flags)
+	, size_(0) {
+
+	}
+	template <class BUFFER>
+	void base64_encoder::update_to(BUFFER& dst, const unsigned char* src, std::size_t len) {
+		char* p = dst.prepare(base64_encode_length(size_ + len, flags_));
+		std::size_t n = 0;
+		// 补齐上次剩余的不完整组
+		if(size_ > 0) {
+			while(size_ < 2 && len > 0) {
+				tail_[size_++] = *src++;
+				--len;
+			}
+			if(len == 0) {
+				dst.commit(0);
+				return;
+			}
+			unsigned char group[3] = {tail_[0], tail_[1], *src++};
+			--len;
+			size_ = 0;
+			n = base64_encode_blocks(p, group, 3, flags_);
+		}
+		n += base64_encode_blocks(p + n, src, len, flags_);
+		for(std::size_t r = len % 3, i = 0; i < r; ++i) {
+			tail_[size_++] = src[len - r + i];
+		}
+		dst.commit(n);
+	}
+	template <class BUFFER>
+	void base64_encoder::finalize_to(BUFFER& dst) {
+		char* p = dst.prepare(4);
+		dst.commit(base64_encode_tail(p, tail_, size_, flags_));
+		size_ = 0;
+	}
+	void base64_encoder::update(buffer& dst, const unsigned char* src, std::size_t len) {
+		update_to(dst, src, len);
+	}
+	void base64_encoder::update(stream_buffer& dst, const unsigned char* src, std::size_t len) {
+		update_to(dst, src, len);
+	}
+	void base64_encoder::finalize(buffer& dst) {
+		finalize_to(dst);
+	}
+	void base64_encoder::finalize(stream_buffer& dst) {
+		finalize_to(dst);
+	}
+	// ---------------------------------------------------------------------
+	base64_decoder::base64_decoder(int flags)
+	: flags_(flags)
+	, state_({0, 0, 0}) {
+
+	}
+	template <class BUFFER>
+	void base64_decoder::update_to(BUFFER& dst, const char* src, std::size_t len) {
+		char* p = dst.prepare(base64_decode_length(len));
+		dst.commit(base64_decode_update(state_, p, src, len, flags_));
+	}
+	template <class BUFFER>
+	void base64_decoder::finalize_to(BUFFER& dst) {
+		char* p = dst.prepare(2);
+		dst.commit(base64_decode_finalize(state_, p, flags_));
+	}
+	void base64_decoder::update(buffer& dst, const char* src, std::size_t len) {
+		update_to(dst, src, len);
+	}
+	void base64_decoder::update(stream_buffer& dst, const char* src, std::size_t len) {
+		update_to(dst, src, len);
+	}
+	void base64_decoder::finalize(buffer& dst) {
+		finalize_to(dst);
+	}
+	void base64_decoder::finalize(stream_buffer& dst) {
+		finalize_to(dst);
+	}
+}
@@ -0,0 +1,72 @@
+#pragma once
+
+#include "string.h"
+#include "buffer.h"
+#include "stream_buffer.h"
+
+namespace php {
+	enum base64_flag {
+		BASE64_URL    = 0x01, // 使用 URL 安全字母表 "-_" 替代 "+/"
+		BASE64_NO_PAD = 0x02, // 编码时不输出 '=' 填充
+		BASE64_STRICT = 0x04, // 解码时严格校验 (非法字符、填充错误时抛出异常), 与 base64_decode($str, true) 一致
+	};
+	// 编码结果长度
+	std::size_t base64_encode_length(std::size_t len, int flags = 0);
+	// 解码结果长度上限
+	std::size_t base64_decode_length(std::size_t len);
+	// 编码写入 dst (至少 base64_encode_length() 空间), 返回写入长度
+	std::size_t base64_encode_to(char* dst, const unsigned char* src, std::size_t len, int flags = 0);
+	// 编码追加到缓冲区尾部
+	void base64_encode_to(buffer& dst, const unsigned char* src, std::size_t len, int flags = 0);
+	void base64_encode_to(stream_buffer& dst, const unsigned char* src, std::size_t len, int flags = 0);
+	// 解码写入 dst (至少 base64_decode_length() 空间), 返回写入长度
+	std::size_t base64_decode_to(char* dst, const char* src, std::size_t len, int flags = 0);
+	// 解码追加到缓冲区尾部
+	void base64_decode_to(buffer& dst, const char* src, std::size_t len, int flags = 0);
+	void base64_decode_to(stream_buffer& dst, const char* src, std::size_t len, int flags = 0);
+	string base64_encode(const unsigned char* str, std::size_t len, int flags = 0);
+	string base64_decode(const unsigned char* str, std::size_t len, int flags = 0);
+	// 分段编码: 跨调用保留不足 3 字节的剩余数据
+	class base64_encoder {
+	public:
+		base64_encoder(int flags = 0);
+		void update(buffer& dst, const unsigned char* src, std::size_t len);
+		void update(stream_buffer& dst, const unsigned char* src, std::size_t len);
+		// 输出剩余数据及填充, 之后可继续用于新的编码
+		void finalize(buffer& dst);
+		void finalize(stream_buffer& dst);
+	private:
+		int           flags_;
+		unsigned char tail_[2];
+		std::size_t   size_;
+
+		template <class BUFFER>
+		void update_to(BUFFER& dst, const unsigned char* src, std::size_t len);
+		template <class BUFFER>
+		void finalize_to(BUFFER& dst);
+	};
+	// 分段解码: 跨调用保留不完整的 4 字符组
+	class base64_decoder {
+	public:
+		// 解码状态 (内部使用)
+		struct state {
+			std::uint32_t bits;    // 未输出的累积位
+			std::uint32_t count;   // 已处理的有效字符数
+			std::uint32_t padding; // 已读取的填充字符数
+		};
+		base64_decoder(int flags = 0);
+		void update(buffer& dst, const char* src, std::size_t len);
+		void update(stream_buffer& dst, const char* src, std::size_t len);
+		// 输出不完整组中剩余的数据 (严格模式下数据或填充不完整时抛出异常), 之后可继续用于新的解码
+		void finalize(buffer& dst);
+		void finalize(stream_buffer& dst);
+	private:
+		int   flags_;
+		state state_;
+
+		template <class BUFFER>
+		void update_to(BUFFER& dst, const char* src, std::size_t len);
+		template <class BUFFER>
+		void finalize_to(BUFFER& dst);
+	};
+}
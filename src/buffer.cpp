@@ -3,7 +3,7 @@
 
 #include "value.h"
 #include "string.h"
-#include "util.h"
+#include "json.h"
 
 namespace php {
 	void buffer::append(const php::value& v) {
@@ -0,0 +1,123 @@
+#include "vendor.h"
+#include "class_entry.h"
+#include "callable.h"
+
+namespace php {
+	// 小写类名 -> 延迟声明的类
+	static std::map<std::string, class_entry_base*>& class_entry_lazy() {
+		static std::map<std::string, class_entry_base*> entries;
+		return entries;
+	}
+	// 已在请求中完成声明的延迟类
+	static std::vector<class_entry_base*> class_entry_required;
+	static std::size_t                    class_entry_pending = 0;
+	static zend_internal_function         class_entry_loader;
+#ifdef ZTS
+	static std::recursive_mutex           class_entry_mutex;
+#endif
+
+	static value class_entry_autoload(parameters& params) {
+		if(params.size() < 1 || !params[0].type_of(TYPE::STRING)) return nullptr;
+		string name = params[0];
+		class_entry_base::require(name.c_str(), name.size());
+		return nullptr;
+	}
+	void class_entry_base::declare_lazy() {
+		// 模块启动阶段 EG(current_module) 为当前模块 (引擎复制后的 zend_module_entry)
+		module_ = EG(current_module);
+		reserve();
+		const string& n = name();
+		std::string key(n.c_str(), n.size());
+		ascii_lower_inplace(&key[0], key.size());
+		class_entry_lazy()[key] = this;
+		++class_entry_pending;
+		if(!class_entry_loader.handler) {
+			class_entry_loader.type          = ZEND_INTERNAL_FUNCTION;
+			class_entry_loader.function_name = zend_new_interned_string(zend_string_init("{class_entry_autoload}", 22, 1));
+			class_entry_loader.handler       = function_delegate<class_entry_autoload>;
+		}
+	}
+	zend_class_entry* class_entry_base::require() {
+#ifdef ZTS
+		std::lock_guard<std::recursive_mutex> lock(class_entry_mutex);
+#endif
+		zend_class_entry** ce = target();
+		if(*ce) {
+			if(key_ && !zend_hash_exists(CG(class_table), key_)) {
+#ifdef ZTS
+				++(*ce)->refcount; // 各线程类表分别持有
+#endif
+				zend_hash_add_ptr(CG(class_table), key_, *ce);
+				// 请求结束时保留类表中的内部类 (同 dl()), 否则在其之前声明的用户类可能残留
+				EG(full_tables_cleanup) = 1;
+			}
+			return *ce;
+		}
+		zend_module_entry* m = EG(current_module);
+		EG(current_module) = module_;
+		try {
+			declare();
+		}catch(...) {
+			EG(current_module) = m;
+			throw;
+		}
+		EG(current_module) = m;
+		--class_entry_pending;
+		// 模块启动阶段声明的类由引擎持久保留, 无需再次加入类表
+		if(m) return *ce;
+		// 与引擎使用相同的 interned 键 (已在模块启动阶段生成)
+		key_ = zend_new_interned_string(zend_string_tolower_ex((*ce)->name, 1));
+		class_entry_required.push_back(this);
+#ifdef ZTS
+		++(*ce)->refcount; // 线程结束时不释放
+#endif
+		EG(full_tables_cleanup) = 1;
+		return *ce;
+	}
+	zend_class_entry* class_entry_base::require(const char* name, std::size_t len) {
+		if(len > 0 && name[0] == '\\') {
+			++name;
+			--len;
+		}
+		std::string key(name, len);
+		ascii_lower_inplace(&key[0], key.size());
+		auto i = class_entry_lazy().find(key);
+		if(i == class_entry_lazy().end()) return nullptr;
+		return i->second->require();
+	}
+	void class_entry_base::require(zend_class_entry** ce) {
+		if(*ce) return;
+		for(auto i=class_entry_lazy().begin(); i!=class_entry_lazy().end(); ++i) {
+			if(i->second->target() == ce) {
+				i->second->require();
+				return;
+			}
+		}
+	}
+	std::size_t class_entry_base::pending() {
+		return class_entry_pending;
+	}
+	void class_entry_base::activate() {
+		{
+#ifdef ZTS
+			std::lock_guard<std::recursive_mutex> lock(class_entry_mutex);
+#endif
+			// 请求开始时类表中尚无用户类, 无需 full_tables_cleanup
+			for(auto i=class_entry_required.begin(); i!=class_entry_required.end(); ++i) {
+				zend_class_entry* ce = *(*i)->target();
+				if(zend_hash_exists(CG(class_table), (*i)->key_)) continue;
+#ifdef ZTS
+				++ce->refcount;
+#endif
+				zend_hash_add_ptr(CG(class_table), (*i)->key_, ce);
+			}
+		}
+		if(class_entry_pending == 0) return;
+		// 优先于用户注册的自动加载函数
+		zval loader;
+		zend_create_fake_closure(&loader, reinterpret_cast<zend_function*>(&class_entry_loader), nullptr, nullptr, nullptr);
+		value cb(&loader);
+		zval_ptr_dtor(&loader);
+		callable("spl_autoload_register").call({cb, true, true});
+	}
+}
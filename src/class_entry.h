@@ -7,12 +7,37 @@
 #include "arguments.h"
 #include "delegate.h"
 #include "class_base.h"
+#include "ascii.h"
 
 namespace php {
 	class class_entry_base {
 	public:
+		class_entry_base()
+		: module_(nullptr)
+		, key_(nullptr) {}
 		virtual ~class_entry_base() {}
 		virtual void declare() = 0;
+		// 延迟声明 (须在模块启动阶段调用): 仅登记类名, 首次查找该类 (自动加载) 或调用 class_entry<T>::entry() 时完成声明;
+		// 声明前 class_exists($name, false)、get_declared_classes() 等不可见
+		void declare_lazy();
+		// 按类名完成延迟声明, 非延迟声明的类返回 nullptr
+		static zend_class_entry* require(const char* name, std::size_t len);
+		// 完成 *ce 所属类的延迟声明 (父类、接口等依赖), 非延迟声明的类无操作
+		static void require(zend_class_entry** ce);
+		// 尚未完成声明的延迟类数量
+		static std::size_t pending();
+		// 请求开始时调用: 已声明的延迟类重新加入类表 (请求中加入类表的内部类可能在请求结束时被移出), 存在未声明的类时注册自动加载
+		static void activate();
+	protected:
+		// 完成声明; 已声明时 (其他请求或 ZTS 其他线程) 仅加入当前类表
+		zend_class_entry* require();
+		// 请求中声明时引擎生成的 interned 字符串于请求结束时释放, 故类名、方法名等须在模块启动阶段预先生成
+		virtual void reserve() = 0;
+		virtual const string& name() const = 0;
+		virtual zend_class_entry** target() = 0;
+	private:
+		zend_module_entry* module_;
+		zend_string*       key_; // 类表中的键 (小写类名)
 	};
 	template <class T>
 	class class_entry: public class_entry_base {
@@ -28,6 +53,7 @@ namespace php {
 
 		static zend_class_entry*     entry_;
 		static zend_object_handlers  entry_handler;
+		static class_entry*          lazy_;
 
 		static zend_object* create_object(zend_class_entry *entry) {
 			assert(entry_ == entry);
@@ -54,7 +80,6 @@ namespace php {
 		class_entry(const std::string& name)
 		: ce_parent(nullptr) {
 			zend_string* n = zend_string_init(name.c_str(), name.size(), 1);
-			php_strtoupper(name_.data(), name_.size());
 			name_ = string(n);
 			std::memcpy(&entry_handler, zend_get_std_object_handlers(), sizeof(zend_object_handlers));
 			entry_handler.offset   = XtOffsetOf(class_wrapper, obj);
@@ -73,6 +98,7 @@ namespace php {
 
 		}
 		static CLASS entry() {
+			if(!entry_ && lazy_) lazy_->require();
 			return entry_;
 		}
 		class_entry& extends(zend_class_entry** c) {
@@ -119,12 +145,18 @@ namespace php {
 		// TODO 优化内部对象定义, 使用封装后的类型?
 		virtual void declare() override {
 			// 防止同名类型重复声明 (其他 function/method/constant/property 均存在类似防止重复的机制)
-			if(zend_hash_find_ptr(CG(class_table), name_) != nullptr) {
+			// class_table 以小写类名为键
+			if(zend_hash_find_ptr(CG(class_table), ascii_lower(name_.c_str(), name_.size())) != nullptr) {
 				char message[256];
 				sprintf(message, "cannot redeclare internal class '%s'", name_.c_str());
 				throw php::exception(zend_ce_type_error, message);
 			}
 
+			// 依赖的父类、接口可能为延迟声明
+			if(ce_parent) class_entry_base::require(ce_parent);
+			for(auto i=ce_interface.begin();i!=ce_interface.end();++i) {
+				class_entry_base::require(*i);
+			}
 			entry_methods.push_back(zend_function_entry{}); // 结束数组条件
 			zend_class_entry ce, *pce = nullptr;
 
@@ -158,10 +190,34 @@ namespace php {
 				entry_properties.clear();
 			}
 		}
+	protected:
+		virtual void reserve() override {
+			lazy_ = this;
+			name_ = string(zend_new_interned_string(zend_string_copy(name_)));
+			zend_new_interned_string(zend_string_tolower_ex(name_, 1));
+			for(auto i=entry_methods.begin();i!=entry_methods.end();++i) {
+				zend_string* fname = zend_new_interned_string(zend_string_init(i->fname, std::strlen(i->fname), 1));
+				zend_new_interned_string(zend_string_tolower_ex(fname, 1));
+			}
+			for(auto i=entry_contants.begin();i!=entry_contants.end();++i) {
+				i->reserve();
+			}
+			for(auto i=entry_properties.begin();i!=entry_properties.end();++i) {
+				i->reserve(name_);
+			}
+		}
+		virtual const string& name() const override {
+			return name_;
+		}
+		virtual zend_class_entry** target() override {
+			return &entry_;
+		}
 	};
 
 	template <class T>
 	zend_object_handlers class_entry<T>::entry_handler;
 	template <class T>
 	zend_class_entry*    class_entry<T>::entry_;
+	template <class T>
+	class_entry<T>*      class_entry<T>::lazy_ = nullptr;
 }
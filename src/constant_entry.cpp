@@ -1,5 +1,6 @@
 #include "vendor.h"
 #include "constant_entry.h"
+#include "persistent.h"
 
 namespace php {
 	constant_entry::constant_entry(const php::string& k, const php::value& v)
@@ -15,12 +16,22 @@ namespace php {
 		case IS_STRING:
 			ZVAL_STR(static_cast<zval*>(val_), zend_string_dup(static_cast<zend_string*>(v), 1));
 			break;
+		case IS_ARRAY:
+			// 一次性深复制为持久不可变数组, 各请求读取时无需复制
+			persistent_copy(static_cast<zval*>(val_), v);
+			break;
 		default:
 			assert(0 && "常量类型受限");
 		}
 	}
 	//
-	void constant_entry::declare(int module) {
+	bool constant_entry::declare(int module) {
+#ifdef ZTS
+		if(Z_TYPE_P(static_cast<zval*>(val_)) == IS_ARRAY) {
+			zend_error(E_CORE_WARNING, "constant_entry: array constant '%s' is not supported in ZTS builds", ZSTR_VAL(static_cast<zend_string*>(key_)));
+			return false;
+		}
+#endif
 		zend_constant c;
 		ZVAL_COPY(&c.value, val_);
 #if PHP_VERSION_ID < 70300
@@ -32,10 +43,15 @@ namespace php {
 		c.name = key_;
 		int r = zend_register_constant(&c);
 		assert(r == SUCCESS && "声明常量失败");
+		return true;
 	}
 	//
 	void constant_entry::declare(zend_class_entry* ce) {
 		int r = zend_declare_class_constant_ex(ce, key_, val_, ZEND_ACC_PUBLIC, nullptr);
 		assert(r == 0 && "声明常量失败");
 	}
+	//
+	void constant_entry::reserve() {
+		key_ = string(zend_new_interned_string(zend_string_copy(key_)));
+	}
 }
@@ -6,9 +6,13 @@
 namespace php {
 	class constant_entry {
 	public:
+		// 值限于 null / bool / 整数 / 浮点数 / 字符串 / 数组; 数组被深复制为持久不可变数组 (见 persistent_copy())
 		constant_entry(const string& k, const value& v);
-		void declare(int module);
+		// ZTS 下不支持模块级数组常量 (各线程复制的常量表共享同一持久数组, 线程退出时引擎无法释放), 返回 false
+		bool declare(int module);
 		void declare(zend_class_entry* ce);
+		// 预先生成 interned 常量名 (延迟声明的类, 见 class_entry_base::declare_lazy())
+		void reserve();
 	private:
 		string key_;
 		value  val_;
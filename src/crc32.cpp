@@ -0,0 +1,180 @@
+#include "vendor.h"
+#include "crc32.h"
+#include "simd.h"
+
+namespace php {
+	// slicing-by-8 查找表 (表 0 即 PHP crc32tab)
+	struct crc32_table {
+		std::uint32_t t[8][256];
+		crc32_table() {
+			for(std::uint32_t i=0;i<256;++i) {
+				std::uint32_t c = i;
+				for(int k=0;k<8;++k) {
+					c = (c & 1) ? (0xEDB88320u ^ (c >> 1)) : (c >> 1);
+				}
+				t[0][i] = c;
+			}
+			for(std::uint32_t i=0;i<256;++i) {
+				for(int k=1;k<8;++k) {
+					t[k][i] = (t[k-1][i] >> 8) ^ t[0][t[k-1][i] & 0xFF];
+				}
+			}
+		}
+	};
+	static const crc32_table& crc32_tables() {
+		static crc32_table table;
+		return table;
+	}
+	// 注意: 以下计算函数的 crc 参数均为未取反的内部状态
+	static std::uint32_t crc32_slice8(std::uint32_t crc, const unsigned char* p, std::size_t n) {
+		const crc32_table& tb = crc32_tables();
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+		for(; n >= 8; n -= 8, p += 8) {
+			std::uint32_t one, two;
+			std::memcpy(&one, p, 4);
+			std::memcpy(&two, p + 4, 4);
+			one ^= crc;
+			crc = tb.t[7][ one        & 0xFF] ^ tb.t[6][(one >>  8) & 0xFF]
+				^ tb.t[5][(one >> 16) & 0xFF] ^ tb.t[4][ one >> 24        ]
+				^ tb.t[3][ two        & 0xFF] ^ tb.t[2][(two >>  8) & 0xFF]
+				^ tb.t[1][(two >> 16) & 0xFF] ^ tb.t[0][ two >> 24        ];
+		}
+#endif
+		for(; n > 0; --n, ++p) {
+			crc = (crc >> 8) ^ tb.t[0][(crc ^ *p) & 0xFF];
+		}
+		return crc;
+	}
+#ifdef PHPEXT_SIMD_X86
+	// PCLMULQDQ 折叠 (Intel "Fast CRC Computation Using PCLMULQDQ Instruction")
+	// 要求 n >= 64 且为 16 的倍数
+	PHPEXT_TARGET("sse4.1,pclmul")
+	static std::uint32_t crc32_fold(std::uint32_t crc, const unsigned char* p, std::size_t n) {
+		// 反射域常量 k1 ~ k5 及 Barrett 约减常量
+		alignas(16) static const std::uint64_t k1k2[] = { 0x0154442bd4, 0x01c6e41596 };
+		alignas(16) static const std::uint64_t k3k4[] = { 0x01751997d0, 0x00ccaa009e };
+		alignas(16) static const std::uint64_t k5k0[] = { 0x0163cd6124, 0x0000000000 };
+		alignas(16) static const std::uint64_t poly[] = { 0x01db710641, 0x01f7011641 };
+		__m128i x0, x1, x2, x3, x4, x5, x6, x7, x8, y5, y6, y7, y8;
+
+		x1 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + 0x00));
+		x2 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + 0x10));
+		x3 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + 0x20));
+		x4 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + 0x30));
+		x1 = _mm_xor_si128(x1, _mm_cvtsi32_si128(crc));
+		x0 = _mm_load_si128(reinterpret_cast<const __m128i*>(k1k2));
+		p += 64;
+		n -= 64;
+		// 4 路并行折叠 64 字节
+		while(n >= 64) {
+			x5 = _mm_clmulepi64_si128(x1, x0, 0x00);
+			x6 = _mm_clmulepi64_si128(x2, x0, 0x00);
+			x7 = _mm_clmulepi64_si128(x3, x0, 0x00);
+			x8 = _mm_clmulepi64_si128(x4, x0, 0x00);
+			x1 = _mm_clmulepi64_si128(x1, x0, 0x11);
+			x2 = _mm_clmulepi64_si128(x2, x0, 0x11);
+			x3 = _mm_clmulepi64_si128(x3, x0, 0x11);
+			x4 = _mm_clmulepi64_si128(x4, x0, 0x11);
+			y5 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + 0x00));
+			y6 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + 0x10));
+			y7 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + 0x20));
+			y8 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + 0x30));
+			x1 = _mm_xor_si128(_mm_xor_si128(x1, x5), y5);
+			x2 = _mm_xor_si128(_mm_xor_si128(x2, x6), y6);
+			x3 = _mm_xor_si128(_mm_xor_si128(x3, x7), y7);
+			x4 = _mm_xor_si128(_mm_xor_si128(x4, x8), y8);
+			p += 64;
+			n -= 64;
+		}
+		// 合并为 128 位
+		x0 = _mm_load_si128(reinterpret_cast<const __m128i*>(k3k4));
+		x5 = _mm_clmulepi64_si128(x1, x0, 0x00);
+		x1 = _mm_clmulepi64_si128(x1, x0, 0x11);
+		x1 = _mm_xor_si128(_mm_xor_si128(x1, x2), x5);
+		x5 = _mm_clmulepi64_si128(x1, x0, 0x00);
+		x1 = _mm_clmulepi64_si128(x1, x0, 0x11);
+		x1 = _mm_xor_si128(_mm_xor_si128(x1, x3), x5);
+		x5 = _mm_clmulepi64_si128(x1, x0, 0x00);
+		x1 = _mm_clmulepi64_si128(x1, x0, 0x11);
+		x1 = _mm_xor_si128(_mm_xor_si128(x1, x4), x5);
+		// 单路折叠剩余 16 字节块
+		while(n >= 16) {
+			x2 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+			x5 = _mm_clmulepi64_si128(x1, x0, 0x00);
+			x1 = _mm_clmulepi64_si128(x1, x0, 0x11);
+			x1 = _mm_xor_si128(_mm_xor_si128(x1, x2), x5);
+			p += 16;
+			n -= 16;
+		}
+		// 128 位 -> 64 位
+		x2 = _mm_clmulepi64_si128(x1, x0, 0x10);
+		x3 = _mm_setr_epi32(~0, 0, ~0, 0);
+		x1 = _mm_srli_si128(x1, 8);
+		x1 = _mm_xor_si128(x1, x2);
+		x0 = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(k5k0));
+		x2 = _mm_srli_si128(x1, 4);
+		x1 = _mm_and_si128(x1, x3);
+		x1 = _mm_clmulepi64_si128(x1, x0, 0x00);
+		x1 = _mm_xor_si128(x1, x2);
+		// Barrett 约减到 32 位
+		x0 = _mm_load_si128(reinterpret_cast<const __m128i*>(poly));
+		x2 = _mm_and_si128(x1, x3);
+		x2 = _mm_clmulepi64_si128(x2, x0, 0x10);
+		x2 = _mm_and_si128(x2, x3);
+		x2 = _mm_clmulepi64_si128(x2, x0, 0x00);
+		x1 = _mm_xor_si128(x1, x2);
+		return _mm_extract_epi32(x1, 1);
+	}
+#endif
+	static std::uint32_t crc32_raw(std::uint32_t crc, const unsigned char* p, std::size_t n) {
+#ifdef PHPEXT_SIMD_X86
+		static bool fold = cpu_support(cpu_feature::PCLMUL) && cpu_support(cpu_feature::SSE41);
+		if(fold && n >= 64) {
+			std::size_t m = n & ~std::size_t(15);
+			crc = crc32_fold(crc, p, m);
+			p += m;
+			n -= m;
+		}
+#endif
+		return crc32_slice8(crc, p, n);
+	}
+	std::uint32_t crc32_update(std::uint32_t crc, const void* data, std::size_t size) {
+		return ~crc32_raw(~crc, reinterpret_cast<const unsigned char*>(data), size);
+	}
+	std::uint32_t crc32(const unsigned char* src, std::size_t len) {
+		return crc32_update(0, src, len);
+	}
+	std::uint32_t crc32(const php::string& str) {
+		return crc32_update(0, str.c_str(), str.size());
+	}
+	std::uint32_t crc32(const buffer& buf) {
+		return buf.size() > 0 ? crc32_update(0, buf.data(), buf.size()) : 0;
+	}
+	std::uint32_t crc32(stream_buffer& buf) {
+		return crc32_update(0, buf.data(), buf.size());
+	}
+	crc32_context::crc32_context(std::uint32_t crc)
+	: crc_(~crc) {
+
+	}
+	crc32_context& crc32_context::update(const void* data, std::size_t size) {
+		crc_ = crc32_raw(crc_, reinterpret_cast<const unsigned char*>(data), size);
+		return *this;
+	}
+	crc32_context& crc32_context::update(const php::string& str) {
+		return update(str.c_str(), str.size());
+	}
+	crc32_context& crc32_context::update(const buffer& buf) {
+		if(buf.size() > 0) update(buf.data(), buf.size());
+		return *this;
+	}
+	crc32_context& crc32_context::update(stream_buffer& buf) {
+		return update(buf.data(), buf.size());
+	}
+	std::uint32_t crc32_context::finalize() const {
+		return ~crc_;
+	}
+	void crc32_context::reset(std::uint32_t crc) {
+		crc_ = ~crc;
+	}
+}
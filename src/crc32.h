@@ -0,0 +1,30 @@
+#pragma once
+
+#include "string.h"
+#include "buffer.h"
+#include "stream_buffer.h"
+
+namespace php {
+	// CRC-32 (IEEE 802.3, 与 PHP crc32() 函数结果一致)
+	// 以 zlib crc32() 的形式在已有校验值基础上继续计算 (首次计算 crc 给 0)
+	std::uint32_t crc32_update(std::uint32_t crc, const void* data, std::size_t size);
+	std::uint32_t crc32(const unsigned char* src, std::size_t len);
+	std::uint32_t crc32(const string& str);
+	std::uint32_t crc32(const buffer& buf);
+	// 计算可读取数据部分，不消费
+	std::uint32_t crc32(stream_buffer& buf);
+	// 增量计算
+	class crc32_context {
+	public:
+		crc32_context(std::uint32_t crc = 0);
+		crc32_context& update(const void* data, std::size_t size);
+		crc32_context& update(const string& str);
+		crc32_context& update(const buffer& buf);
+		crc32_context& update(stream_buffer& buf);
+		// 读取当前校验值 (不影响继续 update)
+		std::uint32_t finalize() const;
+		void reset(std::uint32_t crc = 0);
+	private:
+		std::uint32_t crc_;
+	};
+}
@@ -0,0 +1,183 @@
+#include "vendor.h"
+#include "datetime.h"
+#include "exception.h"
+
+namespace php {
+	// 向下取整的除法 (负数时间)
+	static inline std::int64_t floor_div(std::int64_t a, std::int64_t b) {
+		std::int64_t q = a / b;
+		return (a % b != 0 && (a < 0) != (b < 0)) ? q - 1 : q;
+	}
+	// 公历日期 <-> 1970-01-01 起的天数
+	static std::int64_t days_from_civil(std::int64_t y, int m, int d) {
+		y -= m <= 2;
+		std::int64_t era = (y >= 0 ? y : y - 399) / 400;
+		std::int64_t yoe = y - era * 400;
+		std::int64_t doy = (153 * (m + (m > 2 ? -3 : 9)) + 2) / 5 + d - 1;
+		std::int64_t doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+		return era * 146097 + doe - 719468;
+	}
+	static void civil_from_days(std::int64_t z, std::int64_t& y, int& m, int& d) {
+		z += 719468;
+		std::int64_t era = (z >= 0 ? z : z - 146096) / 146097;
+		std::int64_t doe = z - era * 146097;
+		std::int64_t yoe = (doe - doe / 1460 + doe / 36524 - doe / 146096) / 365;
+		std::int64_t doy = doe - (365 * yoe + yoe / 4 - yoe / 100);
+		std::int64_t mp = (5 * doy + 2) / 153;
+		d = static_cast<int>(doy - (153 * mp + 2) / 5 + 1);
+		m = static_cast<int>(mp < 10 ? mp + 3 : mp - 9);
+		y = yoe + era * 400 + (m <= 2);
+	}
+	static inline int days_in_month(int y, int m) {
+		static const int days[] = {31, 28, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31};
+		return m == 2 && (y % 4 == 0 && (y % 100 != 0 || y % 400 == 0)) ? 29 : days[m - 1];
+	}
+	static inline bool parse_digits(const char* p, int n, int& v) {
+		v = 0;
+		for(int i=0; i<n; ++i) {
+			unsigned c = static_cast<unsigned char>(p[i]) - '0';
+			if(c > 9) return false;
+			v = v * 10 + c;
+		}
+		return true;
+	}
+	bool iso8601_parse(const char* str, std::size_t len, std::int64_t& us, int& offset) {
+		int y, mo, d, h = 0, mi = 0, s = 0, frac = 0, off = 0;
+		if(len < 10 || !parse_digits(str, 4, y) || str[4] != '-' || !parse_digits(str + 5, 2, mo) || str[7] != '-'
+			|| !parse_digits(str + 8, 2, d) || mo < 1 || mo > 12 || d < 1 || d > days_in_month(y, mo)) return false;
+		const char *p = str + 10, *e = str + len;
+		if(p < e) {
+			if(e - p < 9 || (*p != 'T' && *p != 't' && *p != ' ') || !parse_digits(p + 1, 2, h) || p[3] != ':'
+				|| !parse_digits(p + 4, 2, mi) || p[6] != ':' || !parse_digits(p + 7, 2, s)
+				// 允许闰秒 60 (顺延至下一分钟)
+				|| h > 23 || mi > 59 || s > 60) return false;
+			p += 9;
+			if(p < e && (*p == '.' || *p == ',')) {
+				++p;
+				int n = 0;
+				for(; p < e && static_cast<unsigned char>(*p - '0') <= 9; ++p) {
+					if(n < 6) {
+						frac = frac * 10 + (*p - '0');
+						++n;
+					}
+				}
+				if(n == 0) return false;
+				for(; n < 6; ++n) frac *= 10;
+			}
+			if(p < e) {
+				if(*p == 'Z' || *p == 'z') ++p;
+				else if(*p == '+' || *p == '-') {
+					int sign = *p == '-' ? -1 : 1, oh, om = 0;
+					if(e - p < 3 || !parse_digits(p + 1, 2, oh)) return false;
+					p += 3;
+					if(p < e && *p == ':') {
+						if(e - p < 3 || !parse_digits(p + 1, 2, om)) return false;
+						p += 3;
+					}else if(e - p >= 2) {
+						if(!parse_digits(p, 2, om)) return false;
+						p += 2;
+					}
+					if(oh > 23 || om > 59) return false;
+					off = sign * (oh * 3600 + om * 60);
+				}
+				if(p != e) return false;
+			}
+		}
+		us = ((days_from_civil(y, mo, d) * 86400 + h * 3600 + mi * 60 + s) - off) * 1000000 + frac;
+		offset = off;
+		return true;
+	}
+	bool iso8601_parse(const php::string& str, std::int64_t& us, int& offset) {
+		return iso8601_parse(str.c_str(), str.size(), us, offset);
+	}
+	static inline char* format_digits(char* p, std::int64_t v, int n) {
+		for(int i=n-1; i>=0; --i) {
+			p[i] = '0' + v % 10;
+			v /= 10;
+		}
+		return p + n;
+	}
+	std::size_t iso8601_format_to(char* dst, std::int64_t us, int offset, int precision) {
+		std::int64_t local = us + static_cast<std::int64_t>(offset) * 1000000;
+		std::int64_t sec = floor_div(local, 1000000), days = floor_div(sec, 86400), y;
+		int frac = static_cast<int>(local - sec * 1000000), tod = static_cast<int>(sec - days * 86400), m, d;
+		civil_from_days(days, y, m, d);
+		char* p = dst;
+		// 与 DateTime::format("Y") 一致: 至少 4 位, 负数年带符号
+		if(y < 0) {
+			*p++ = '-';
+			y = -y;
+		}
+		int n = 4;
+		for(std::int64_t t = y; t >= 10000; t /= 10) ++n;
+		p = format_digits(p, y, n);
+		*p++ = '-';
+		p = format_digits(p, m, 2);
+		*p++ = '-';
+		p = format_digits(p, d, 2);
+		*p++ = 'T';
+		p = format_digits(p, tod / 3600, 2);
+		*p++ = ':';
+		p = format_digits(p, tod / 60 % 60, 2);
+		*p++ = ':';
+		p = format_digits(p, tod % 60, 2);
+		if(precision > 0) {
+			if(precision > 6) precision = 6;
+			static const int scale[] = {1000000, 100000, 10000, 1000, 100, 10, 1};
+			*p++ = '.';
+			p = format_digits(p, frac / scale[precision], precision);
+		}
+		*p++ = offset < 0 ? '-' : '+';
+		if(offset < 0) offset = -offset;
+		p = format_digits(p, offset / 3600, 2);
+		*p++ = ':';
+		p = format_digits(p, offset / 60 % 60, 2);
+		return p - dst;
+	}
+	php::string iso8601_format(std::int64_t us, int offset, int precision) {
+		char buf[40];
+		return php::string(buf, iso8601_format_to(buf, us, offset, precision));
+	}
+	// 未经 __construct 创建的对象 time 为空, 由此处填充
+	static timelib_time* datetime_time(object& obj) {
+		timelib_time* t = timelib_time_ctor();
+		Z_PHPDATE_P(static_cast<zval*>(obj))->time = t;
+		return t;
+	}
+	object datetime_from_us(std::int64_t us) {
+		object obj {CLASS(php_date_get_date_ce())};
+		timelib_time* t = datetime_time(obj);
+		std::int64_t sec = floor_div(us, 1000000);
+		t->tz_info = get_timezone_info();
+		t->zone_type = TIMELIB_ZONETYPE_ID;
+		timelib_unixtime2local(t, sec);
+		t->us = us - sec * 1000000;
+		return obj;
+	}
+	object datetime_from_us(std::int64_t us, int offset) {
+		object obj {CLASS(php_date_get_date_ce())};
+		timelib_time* t = datetime_time(obj);
+		std::int64_t sec = floor_div(us, 1000000);
+		t->zone_type = TIMELIB_ZONETYPE_OFFSET;
+		t->z = offset;
+		t->dst = 0;
+		timelib_unixtime2local(t, sec);
+		t->us = us - sec * 1000000;
+		return obj;
+	}
+	object datetime_from_iso8601(const php::string& str) {
+		std::int64_t us;
+		int offset;
+		if(!iso8601_parse(str, us, offset)) throw php::exception(zend_ce_error, "invalid ISO-8601 datetime string");
+		return datetime_from_us(us, offset);
+	}
+	std::int64_t datetime_to_us(const object& dt) {
+		if(!dt.instanceof(CLASS(php_date_get_date_ce())) && !dt.instanceof(CLASS(php_date_get_immutable_ce()))) {
+			throw php::exception(zend_ce_type_error, "instance of DateTimeInterface expected");
+		}
+		php_date_obj* obj = Z_PHPDATE_P(static_cast<zval*>(dt));
+		if(obj->time == nullptr) throw php::exception(zend_ce_error, "the DateTime object has not been correctly initialized by its constructor");
+		timelib_update_ts(obj->time, nullptr);
+		return obj->time->sse * 1000000 + obj->time->us;
+	}
+}
@@ -0,0 +1,25 @@
+#pragma once
+
+#include "string.h"
+#include "object.h"
+
+namespace php {
+	// 直接构造 DateTime 对象 (不经过 __construct 的字符串解析), 精确到微秒
+	// 使用默认时区 (date.timezone, 时区数据由 ext/date 按请求缓存)
+	object datetime_from_us(std::int64_t us);
+	// 使用固定偏移时区 (秒, 东为正, 与 DateTime::getOffset() 一致); 偏移为 0 时同 "@..." 构造的 +00:00
+	object datetime_from_us(std::int64_t us, int offset);
+	// 解析 ISO-8601 / RFC-3339 字符串直接构造 (保留其时区偏移), 格式错误时抛出异常
+	object datetime_from_iso8601(const string& str);
+	// DateTime / DateTimeImmutable 对应的 Unix 时间 (微秒)
+	std::int64_t datetime_to_us(const object& dt);
+	// 解析 ISO-8601 扩展格式 / RFC-3339: YYYY-MM-DD[T|t| ]hh:mm:ss[.ffffff][Z|±hh:mm|±hhmm|±hh]
+	// 也接受仅有日期 YYYY-MM-DD; 未标明时区时按 UTC 处理; 小数秒超出 6 位的部分被截断
+	// 成功时写入 Unix 时间 (微秒) 及时区偏移 (秒), 格式错误时返回 false
+	bool iso8601_parse(const char* str, std::size_t len, std::int64_t& us, int& offset);
+	bool iso8601_parse(const string& str, std::int64_t& us, int& offset);
+	// 格式化 Unix 时间 (微秒) 为 YYYY-MM-DDThh:mm:ss[.f...]±hh:mm (同 DATE_RFC3339 / DATE_RFC3339_EXTENDED)
+	// offset 为时区偏移 (秒), precision 为小数秒位数 (0 ~ 6); dst 至少 40 字节, 返回写入长度
+	std::size_t iso8601_format_to(char* dst, std::int64_t us, int offset = 0, int precision = 0);
+	string iso8601_format(std::int64_t us, int offset = 0, int precision = 0);
+}
@@ -0,0 +1,131 @@
+#include "vendor.h"
+#include "deferred.h"
+#include "exception.h"
+
+namespace php {
+	struct deferred_native_t {
+		std::string             name;
+		std::function<void ()>  fn;
+	};
+	struct deferred_php_t {
+		std::string        name;
+		value              cb;
+		std::vector<value> argv;
+	};
+	struct deferred_state_t {
+		std::vector<deferred_native_t> native;
+		std::vector<deferred_php_t>    php;
+		bool                           closed;  // 已不接受 PHP 回调
+		bool                           started; // 已开始执行 (预算计时)
+		std::size_t                    count;
+		std::uint64_t                  start;
+	};
+#ifdef ZTS
+	static thread_local deferred_state_t deferred_state;
+#else
+	static deferred_state_t deferred_state;
+#endif
+	static std::size_t   deferred_count = 0;
+	static std::uint32_t deferred_ms = 0;
+	static std::function<void (const std::string& name, const std::string& error)> deferred_error;
+
+	static std::uint64_t deferred_now() {
+		struct timespec ts;
+		clock_gettime(CLOCK_MONOTONIC, &ts);
+		return ts.tv_sec * 1000ull + ts.tv_nsec / 1000000;
+	}
+	static void deferred_report(const std::string& name, const std::string& error) {
+		if(deferred_error) {
+			try {
+				deferred_error(name, error);
+			}catch(...) {}
+			return;
+		}
+		std::string message = "deferred task '" + name + "': " + error;
+		php_log_err(const_cast<char*>(message.c_str()));
+	}
+	// 预算耗尽后余下任务均被丢弃
+	static bool deferred_exhausted(deferred_state_t& s) {
+		if(!s.started) {
+			s.started = true;
+			s.count   = 0;
+			s.start   = deferred_now();
+		}
+		if(deferred_count > 0 && s.count >= deferred_count) return true;
+		if(deferred_ms > 0 && deferred_now() - s.start >= deferred_ms) return true;
+		return false;
+	}
+	static void deferred_finish_response() {
+		if(!zend_hash_str_exists(EG(function_table), "fastcgi_finish_request", sizeof("fastcgi_finish_request") - 1)) return;
+		try {
+			callable("fastcgi_finish_request").call();
+		}catch(const php::exception& e) {
+			deferred_report("fastcgi_finish_request", e.what());
+		}
+	}
+
+	void deferred::defer(const std::string& name, std::function<void ()> task) {
+		deferred_state.native.push_back({name, task});
+	}
+	void deferred::defer(const std::string& name, const callable& cb, std::vector<value> argv) {
+		if(deferred_state.closed) throw php::exception(zend_ce_error, "deferred: request is shutting down");
+		deferred_state.php.push_back({name, cb, std::move(argv)});
+	}
+	void deferred::budget(std::size_t count, std::uint32_t ms) {
+		deferred_count = count;
+		deferred_ms    = ms;
+	}
+	void deferred::on_error(std::function<void (const std::string& name, const std::string& error)> handler) {
+		deferred_error = handler;
+	}
+	std::size_t deferred::size() {
+		return deferred_state.native.size() + deferred_state.php.size();
+	}
+	void deferred::request_shutdown() {
+		deferred_state_t& s = deferred_state;
+		if(!s.native.empty() || !s.php.empty()) deferred_finish_response();
+		while(!s.php.empty()) {
+			std::vector<deferred_php_t> tasks;
+			tasks.swap(s.php);
+			for(auto i=tasks.begin(); i!=tasks.end(); ++i) {
+				if(deferred_exhausted(s)) {
+					deferred_report(i->name, "budget exceeded");
+					continue;
+				}
+				++s.count;
+				try {
+					callable(i->cb).call(i->argv);
+				}catch(const php::exception& e) {
+					deferred_report(i->name, e.what());
+				}catch(const std::exception& e) {
+					deferred_report(i->name, e.what());
+				}
+			}
+			// PHP 数据须在执行器关闭前释放
+		}
+		s.closed = true;
+	}
+	void deferred::post_deactivate() {
+		deferred_state_t& s = deferred_state;
+		while(!s.native.empty()) {
+			std::vector<deferred_native_t> tasks;
+			tasks.swap(s.native);
+			for(auto i=tasks.begin(); i!=tasks.end(); ++i) {
+				if(deferred_exhausted(s)) {
+					deferred_report(i->name, "budget exceeded");
+					continue;
+				}
+				++s.count;
+				try {
+					i->fn();
+				}catch(const std::exception& e) {
+					deferred_report(i->name, e.what());
+				}catch(...) {
+					deferred_report(i->name, "unknown exception");
+				}
+			}
+		}
+		s.closed  = false;
+		s.started = false;
+	}
+}
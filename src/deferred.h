@@ -0,0 +1,30 @@
+#pragma once
+
+#include "value.h"
+#include "callable.h"
+
+namespace php {
+	// 请求结束后执行的延迟任务 (日志刷新、指标上报、缓存预热等), 不占用响应时间:
+	// 本模块 request shutdown 时 (用户关闭函数、析构、输出刷新均已完成) 若存在任务, 先结束响应 (FPM 下调用 fastcgi_finish_request()), 然后
+	//  - PHP 回调于 request shutdown 中执行 (执行器仍可用)
+	//  - 原生任务于 post_deactivate 阶段执行 (执行器已关闭, 不可访问 PHP 数据)
+	// 任务按加入顺序执行; 执行中加入的任务在同一阶段继续执行; 抛出异常或因超出预算被丢弃的任务逐项报告
+	// 仅可在请求中 (请求线程) 调用
+	class deferred {
+	public:
+		static void defer(const std::string& name, std::function<void ()> task);
+		// request shutdown 之后不再接受 PHP 回调 (抛出异常)
+		static void defer(const std::string& name, const callable& cb, std::vector<value> argv = {});
+		// 每请求预算 (模块启动时设置): 至多执行 count 个任务, 累计耗时超出 ms 毫秒后不再开始新任务; 0 表示不限
+		static void budget(std::size_t count, std::uint32_t ms);
+		// 错误报告 (任务名, 错误信息), 默认写入 PHP 错误日志; 模块启动时设置
+		static void on_error(std::function<void (const std::string& name, const std::string& error)> handler);
+		// 当前请求中待执行的任务数量
+		static std::size_t size();
+	private:
+		// 由 extension_entry 调用
+		static void request_shutdown();
+		static void post_deactivate();
+		friend class extension_entry;
+	};
+}
@@ -0,0 +1,324 @@
+#include "vendor.h"
+#include "digest.h"
+#include "hex.h"
+#include "simd.h"
+
+namespace php {
+	md5_context::md5_context() {
+		reset();
+	}
+	md5_context& md5_context::update(const void* data, std::size_t size) {
+		PHP_MD5Update(&ctx_, data, size);
+		return *this;
+	}
+	md5_context& md5_context::update(const php::string& str) {
+		return update(str.c_str(), str.size());
+	}
+	md5_context& md5_context::update(const buffer& buf) {
+		if(buf.size() > 0) update(buf.data(), buf.size());
+		return *this;
+	}
+	md5_context& md5_context::update(stream_buffer& buf) {
+		return update(buf.data(), buf.size());
+	}
+	void md5_context::finalize(unsigned char digest[16]) const {
+		PHP_MD5_CTX ctx = ctx_;
+		PHP_MD5Final(digest, &ctx);
+	}
+	php::string md5_context::hex() const {
+		unsigned char digest[16];
+		finalize(digest);
+		return bin2hex(digest, sizeof(digest));
+	}
+	void md5_context::reset() {
+		PHP_MD5Init(&ctx_);
+	}
+	sha1_context::sha1_context() {
+		reset();
+	}
+	sha1_context& sha1_context::update(const void* data, std::size_t size) {
+		PHP_SHA1Update(&ctx_, reinterpret_cast<const unsigned char*>(data), size);
+		return *this;
+	}
+	sha1_context& sha1_context::update(const php::string& str) {
+		return update(str.c_str(), str.size());
+	}
+	sha1_context& sha1_context::update(const buffer& buf) {
+		if(buf.size() > 0) update(buf.data(), buf.size());
+		return *this;
+	}
+	sha1_context& sha1_context::update(stream_buffer& buf) {
+		return update(buf.data(), buf.size());
+	}
+	void sha1_context::finalize(unsigned char digest[20]) const {
+		PHP_SHA1_CTX ctx = ctx_;
+		PHP_SHA1Final(digest, &ctx);
+	}
+	php::string sha1_context::hex() const {
+		unsigned char digest[20];
+		finalize(digest);
+		return bin2hex(digest, sizeof(digest));
+	}
+	void sha1_context::reset() {
+		PHP_SHA1Init(&ctx_);
+	}
+	// ---------------------------------------------------------------------
+	// 多缓冲: 每个 32 位向量元素 (lane) 独立处理一个输入, lane 完成后立即换入下一个输入
+	// 压缩函数以 GCC 向量扩展编写一次, 分别在 SSE2 (4 路) / AVX2 (8 路) 目标函数中内联实例化
+#define DIGEST_ROTL(x, s) (((x) << (s)) | ((x) >> (32 - (s))))
+#define DIGEST_INLINE static inline __attribute__((always_inline))
+
+	typedef std::uint32_t digest_u32x4 __attribute__((vector_size(16)));
+	typedef std::uint32_t digest_u32x8 __attribute__((vector_size(32)));
+
+	struct digest_lane {
+		const unsigned char* data;
+		std::size_t          full;   // 输入中完整的块数量
+		std::size_t          block;  // 当前块
+		std::size_t          blocks; // 总块数 (含填充)
+		unsigned char*       out;
+		unsigned char        tail[128]; // 末尾不完整的块及填充
+	};
+	// 准备填充: 0x80, 0..., 64 位长度 (MD5 小端序 / SHA1 大端序)
+	static void digest_lane_init(digest_lane& lane, const unsigned char* data, std::size_t size, unsigned char* out, bool big_endian) {
+		std::size_t rem = size % 64;
+		std::uint64_t bits = static_cast<std::uint64_t>(size) * 8;
+		lane.data = data;
+		lane.full = size / 64;
+		lane.block = 0;
+		lane.out = out;
+		std::size_t pad = rem + 9 <= 64 ? 64 : 128;
+		lane.blocks = lane.full + pad / 64;
+		if(rem > 0) std::memcpy(lane.tail, data + lane.full * 64, rem);
+		lane.tail[rem] = 0x80;
+		std::memset(lane.tail + rem + 1, 0, pad - rem - 1);
+		for(int i=0; i<8; ++i) {
+			lane.tail[pad - 8 + i] = static_cast<unsigned char>(big_endian ? bits >> (56 - i * 8) : bits >> (i * 8));
+		}
+	}
+	static inline const unsigned char* digest_lane_block(const digest_lane& lane) {
+		return lane.block < lane.full ? lane.data + lane.block * 64 : lane.tail + (lane.block - lane.full) * 64;
+	}
+	static inline std::uint32_t digest_load_le(const unsigned char* p) {
+		return p[0] | (p[1] << 8) | (p[2] << 16) | (static_cast<std::uint32_t>(p[3]) << 24);
+	}
+	static inline std::uint32_t digest_load_be(const unsigned char* p) {
+		return (static_cast<std::uint32_t>(p[0]) << 24) | (p[1] << 16) | (p[2] << 8) | p[3];
+	}
+	static inline void digest_store_le(unsigned char* p, std::uint32_t v) {
+		p[0] = v; p[1] = v >> 8; p[2] = v >> 16; p[3] = v >> 24;
+	}
+	static inline void digest_store_be(unsigned char* p, std::uint32_t v) {
+		p[0] = v >> 24; p[1] = v >> 16; p[2] = v >> 8; p[3] = v;
+	}
+	static const std::uint32_t md5_iv[4] = {0x67452301, 0xefcdab89, 0x98badcfe, 0x10325476};
+	static const std::uint32_t sha1_iv[5] = {0x67452301, 0xefcdab89, 0x98badcfe, 0x10325476, 0xc3d2e1f0};
+	// K[i] = floor(|sin(i + 1)| * 2^32) (RFC 1321)
+	struct md5_table {
+		std::uint32_t k[64];
+		md5_table() {
+			for(int i=0; i<64; ++i) k[i] = static_cast<std::uint32_t>(std::floor(std::fabs(std::sin(i + 1.0)) * 4294967296.0));
+		}
+	};
+	static const std::uint32_t* md5_k() {
+		static md5_table table;
+		return table.k;
+	}
+	static const int md5_r[4][4] = {{7, 12, 17, 22}, {5, 9, 14, 20}, {4, 11, 16, 23}, {6, 10, 15, 21}};
+
+	template <class V>
+	DIGEST_INLINE void md5_compress(V* st, const V* m, const std::uint32_t* k) {
+		V a = st[0], b = st[1], c = st[2], d = st[3];
+		for(int i=0; i<64; ++i) {
+			V f;
+			int g;
+			if(i < 16) {
+				f = d ^ (b & (c ^ d));
+				g = i;
+			}else if(i < 32) {
+				f = c ^ (d & (b ^ c));
+				g = (5 * i + 1) & 15;
+			}else if(i < 48) {
+				f = b ^ c ^ d;
+				g = (3 * i + 5) & 15;
+			}else{
+				f = c ^ (b | ~d);
+				g = (7 * i) & 15;
+			}
+			int s = md5_r[i >> 4][i & 3];
+			f = a + f + k[i] + m[g];
+			a = d;
+			d = c;
+			c = b;
+			b = b + DIGEST_ROTL(f, s);
+		}
+		st[0] += a;
+		st[1] += b;
+		st[2] += c;
+		st[3] += d;
+	}
+	template <class V>
+	DIGEST_INLINE void sha1_compress(V* st, const V* m) {
+		V w[80];
+		for(int i=0; i<16; ++i) w[i] = m[i];
+		for(int i=16; i<80; ++i) {
+			V x = w[i - 3] ^ w[i - 8] ^ w[i - 14] ^ w[i - 16];
+			w[i] = DIGEST_ROTL(x, 1);
+		}
+		V a = st[0], b = st[1], c = st[2], d = st[3], e = st[4];
+		for(int i=0; i<80; ++i) {
+			V f;
+			std::uint32_t k;
+			if(i < 20) {
+				f = d ^ (b & (c ^ d));
+				k = 0x5a827999;
+			}else if(i < 40) {
+				f = b ^ c ^ d;
+				k = 0x6ed9eba1;
+			}else if(i < 60) {
+				f = (b & c) | (d & (b | c));
+				k = 0x8f1bbcdc;
+			}else{
+				f = b ^ c ^ d;
+				k = 0xca62c1d6;
+			}
+			V t = DIGEST_ROTL(a, 5) + f + e + k + w[i];
+			e = d;
+			d = c;
+			c = DIGEST_ROTL(b, 30);
+			b = a;
+			a = t;
+		}
+		st[0] += a;
+		st[1] += b;
+		st[2] += c;
+		st[3] += d;
+		st[4] += e;
+	}
+	// 调度: N 路 lane 轮流换入输入, 每轮收集各 lane 当前块并压缩
+	template <class V, int N, bool SHA1>
+	DIGEST_INLINE void digest_lanes(const unsigned char* const* data, const std::size_t* size, std::size_t count, unsigned char* digests) {
+		const int words = SHA1 ? 5 : 4;
+		const std::uint32_t* iv = SHA1 ? sha1_iv : md5_iv;
+		const std::uint32_t* k = SHA1 ? nullptr : md5_k();
+		static const unsigned char zero[64] = {0};
+		digest_lane lanes[N];
+		bool active[N];
+		V st[5], m[16];
+		std::size_t next = 0;
+		int running = 0;
+		for(int l=0; l<N; ++l) {
+			active[l] = next < count;
+			if(!active[l]) continue;
+			digest_lane_init(lanes[l], data[next], size[next], digests + next * (words * 4), SHA1);
+			for(int j=0; j<words; ++j) st[j][l] = iv[j];
+			++next;
+			++running;
+		}
+		while(running > 0) {
+			for(int l=0; l<N; ++l) {
+				const unsigned char* p = active[l] ? digest_lane_block(lanes[l]) : zero;
+				for(int j=0; j<16; ++j) m[j][l] = SHA1 ? digest_load_be(p + j * 4) : digest_load_le(p + j * 4);
+			}
+			if(SHA1) sha1_compress(st, m);
+			else md5_compress(st, m, k);
+			for(int l=0; l<N; ++l) {
+				if(!active[l] || ++lanes[l].block < lanes[l].blocks) continue;
+				for(int j=0; j<words; ++j) {
+					if(SHA1) digest_store_be(lanes[l].out + j * 4, st[j][l]);
+					else digest_store_le(lanes[l].out + j * 4, st[j][l]);
+				}
+				if(next < count) {
+					digest_lane_init(lanes[l], data[next], size[next], digests + next * (words * 4), SHA1);
+					for(int j=0; j<words; ++j) st[j][l] = iv[j];
+					++next;
+				}else{
+					active[l] = false;
+					--running;
+				}
+			}
+		}
+	}
+	typedef void (*digest_batch_fn)(const unsigned char* const* data, const std::size_t* size, std::size_t count, unsigned char* digests);
+
+	static void md5_batch_none(const unsigned char* const* data, const std::size_t* size, std::size_t count, unsigned char* digests) {
+		for(std::size_t i=0; i<count; ++i) {
+			PHP_MD5_CTX ctx;
+			PHP_MD5Init(&ctx);
+			PHP_MD5Update(&ctx, data[i], size[i]);
+			PHP_MD5Final(digests + i * 16, &ctx);
+		}
+	}
+	static void sha1_batch_none(const unsigned char* const* data, const std::size_t* size, std::size_t count, unsigned char* digests) {
+		for(std::size_t i=0; i<count; ++i) {
+			PHP_SHA1_CTX ctx;
+			PHP_SHA1Init(&ctx);
+			PHP_SHA1Update(&ctx, data[i], size[i]);
+			PHP_SHA1Final(digests + i * 20, &ctx);
+		}
+	}
+#ifdef PHPEXT_SIMD_X86
+	PHPEXT_TARGET("sse2")
+	static void md5_batch_sse2(const unsigned char* const* data, const std::size_t* size, std::size_t count, unsigned char* digests) {
+		digest_lanes<digest_u32x4, 4, false>(data, size, count, digests);
+	}
+	PHPEXT_TARGET("avx2")
+	static void md5_batch_avx2(const unsigned char* const* data, const std::size_t* size, std::size_t count, unsigned char* digests) {
+		digest_lanes<digest_u32x8, 8, false>(data, size, count, digests);
+	}
+	PHPEXT_TARGET("sse2")
+	static void sha1_batch_sse2(const unsigned char* const* data, const std::size_t* size, std::size_t count, unsigned char* digests) {
+		digest_lanes<digest_u32x4, 4, true>(data, size, count, digests);
+	}
+	PHPEXT_TARGET("avx2")
+	static void sha1_batch_avx2(const unsigned char* const* data, const std::size_t* size, std::size_t count, unsigned char* digests) {
+		digest_lanes<digest_u32x8, 8, true>(data, size, count, digests);
+	}
+#endif
+	static digest_batch_fn md5_batch_select() {
+#ifdef PHPEXT_SIMD_X86
+		if(cpu_support(cpu_feature::AVX2)) return md5_batch_avx2;
+		if(cpu_support(cpu_feature::SSE2)) return md5_batch_sse2;
+#endif
+		return md5_batch_none;
+	}
+	static digest_batch_fn sha1_batch_select() {
+#ifdef PHPEXT_SIMD_X86
+		if(cpu_support(cpu_feature::AVX2)) return sha1_batch_avx2;
+		if(cpu_support(cpu_feature::SSE2)) return sha1_batch_sse2;
+#endif
+		return sha1_batch_none;
+	}
+	void md5_batch(const unsigned char* const* data, const std::size_t* size, std::size_t count, unsigned char* digests) {
+		static digest_batch_fn fn = md5_batch_select();
+		// 单个输入时多缓冲没有收益
+		if(count < 2) md5_batch_none(data, size, count, digests);
+		else fn(data, size, count, digests);
+	}
+	void sha1_batch(const unsigned char* const* data, const std::size_t* size, std::size_t count, unsigned char* digests) {
+		static digest_batch_fn fn = sha1_batch_select();
+		if(count < 2) sha1_batch_none(data, size, count, digests);
+		else fn(data, size, count, digests);
+	}
+	static std::vector<php::string> digest_batch_hex(const std::vector<php::string>& inputs, std::size_t bytes,
+		void (*batch)(const unsigned char* const*, const std::size_t*, std::size_t, unsigned char*)) {
+		std::vector<const unsigned char*> data(inputs.size());
+		std::vector<std::size_t> size(inputs.size());
+		for(std::size_t i=0; i<inputs.size(); ++i) {
+			data[i] = reinterpret_cast<const unsigned char*>(inputs[i].c_str());
+			size[i] = inputs[i].size();
+		}
+		std::vector<unsigned char> digests(inputs.size() * bytes);
+		batch(data.data(), size.data(), inputs.size(), digests.data());
+		std::vector<php::string> rv;
+		rv.reserve(inputs.size());
+		for(std::size_t i=0; i<inputs.size(); ++i) rv.push_back(bin2hex(digests.data() + i * bytes, bytes));
+		return rv;
+	}
+	std::vector<php::string> md5_batch(const std::vector<php::string>& inputs) {
+		return digest_batch_hex(inputs, 16, md5_batch);
+	}
+	std::vector<php::string> sha1_batch(const std::vector<php::string>& inputs) {
+		return digest_batch_hex(inputs, 20, sha1_batch);
+	}
+}
@@ -0,0 +1,46 @@
+#pragma once
+
+#include "string.h"
+#include "buffer.h"
+#include "stream_buffer.h"
+
+namespace php {
+	// 增量计算 MD5 (结果同 md5())
+	class md5_context {
+	public:
+		md5_context();
+		md5_context& update(const void* data, std::size_t size);
+		md5_context& update(const string& str);
+		md5_context& update(const buffer& buf);
+		// 计算可读取数据部分，不消费
+		md5_context& update(stream_buffer& buf);
+		// 读取当前摘要 (不影响继续 update): 16 字节原始摘要 / 32 字节十六进制
+		void finalize(unsigned char digest[16]) const;
+		string hex() const;
+		void reset();
+	private:
+		PHP_MD5_CTX ctx_;
+	};
+	// 增量计算 SHA1 (结果同 sha1())
+	class sha1_context {
+	public:
+		sha1_context();
+		sha1_context& update(const void* data, std::size_t size);
+		sha1_context& update(const string& str);
+		sha1_context& update(const buffer& buf);
+		sha1_context& update(stream_buffer& buf);
+		// 20 字节原始摘要 / 40 字节十六进制
+		void finalize(unsigned char digest[20]) const;
+		string hex() const;
+		void reset();
+	private:
+		PHP_SHA1_CTX ctx_;
+	};
+	// 批量计算多个独立输入的摘要: 多缓冲 SIMD (AVX2 8 路 / SSE2 4 路) 同时处理, 适用于大量小输入 (签名、ETag 等)
+	// digests 依次写入 count 个 16 (MD5) / 20 (SHA1) 字节原始摘要
+	void md5_batch(const unsigned char* const* data, const std::size_t* size, std::size_t count, unsigned char* digests);
+	void sha1_batch(const unsigned char* const* data, const std::size_t* size, std::size_t count, unsigned char* digests);
+	// 返回十六进制摘要
+	std::vector<string> md5_batch(const std::vector<string>& inputs);
+	std::vector<string> sha1_batch(const std::vector<string>& inputs);
+}
@@ -0,0 +1,759 @@
+#include "vendor.h"
+#include "event_loop.h"
+#include "class_entry.h"
+#include "exception.h"
+
+namespace php {
+	enum {
+		TIMER_WHEEL_BITS   = 6,
+		TIMER_WHEEL_SLOTS  = 1 << TIMER_WHEEL_BITS,
+		TIMER_WHEEL_MASK   = TIMER_WHEEL_SLOTS - 1,
+		TIMER_WHEEL_LEVELS = 5,
+	};
+	struct timer_wheel_node: public timer_wheel_link {
+		std::uint64_t          id;
+		std::uint64_t          expire;
+		std::uint64_t          repeat;
+		bool                   cancelled;
+		std::function<void ()> cb;
+	};
+	static void timer_wheel_unlink(timer_wheel_link* n) {
+		n->prev->next = n->next;
+		n->next->prev = n->prev;
+		n->prev = n->next = n;
+	}
+
+	timer_wheel::timer_wheel(std::uint64_t now)
+	: current_(now)
+	, id_(0)
+	, running_(nullptr) {
+		for(int i=0; i<TIMER_WHEEL_LEVELS; ++i) {
+			for(int j=0; j<TIMER_WHEEL_SLOTS; ++j) slots_[i][j].prev = slots_[i][j].next = &slots_[i][j];
+		}
+	}
+	timer_wheel::~timer_wheel() {
+		clear();
+	}
+	std::uint64_t timer_wheel::add(std::uint64_t expire, std::function<void ()> cb, std::uint64_t repeat) {
+		timer_wheel_node* n = new timer_wheel_node;
+		n->id        = ++id_;
+		n->expire    = std::max(expire, current_ + 1); // 当前 tick 已执行
+		n->repeat    = repeat;
+		n->cancelled = false;
+		n->cb        = std::move(cb);
+		index_[n->id] = n;
+		place(n);
+		return n->id;
+	}
+	// 按距当前 tick 的间隔选择层级, 以到期 tick 在该层的位作为槽位
+	void timer_wheel::place(timer_wheel_node* n) {
+		const std::uint64_t max = (1ull << (TIMER_WHEEL_BITS * TIMER_WHEEL_LEVELS)) - 1;
+		std::uint64_t e = n->expire, d = e - current_;
+		if(d > max) {
+			e = current_ + max;
+			d = max;
+		}
+		int level = 0;
+		while(level < TIMER_WHEEL_LEVELS - 1 && d >= (1ull << (TIMER_WHEEL_BITS * (level + 1)))) ++level;
+		timer_wheel_link* slot = &slots_[level][(e >> (TIMER_WHEEL_BITS * level)) & TIMER_WHEEL_MASK];
+		n->prev = slot->prev;
+		n->next = slot;
+		slot->prev->next = n;
+		slot->prev = n;
+	}
+	// 下放当前 tick 所在的上层槽
+	void timer_wheel::cascade(int level) {
+		timer_wheel_link* slot = &slots_[level][(current_ >> (TIMER_WHEEL_BITS * level)) & TIMER_WHEEL_MASK];
+		timer_wheel_link  list;
+		if(slot->next == slot) return;
+		list.next = slot->next;
+		list.prev = slot->prev;
+		list.next->prev = list.prev->next = &list;
+		slot->prev = slot->next = slot;
+		while(list.next != &list) {
+			timer_wheel_node* n = static_cast<timer_wheel_node*>(list.next);
+			timer_wheel_unlink(n);
+			place(n);
+		}
+	}
+	void timer_wheel::finish(timer_wheel_node* n) {
+		running_ = nullptr;
+		if(n->cancelled || n->repeat == 0) {
+			index_.erase(n->id);
+			delete n;
+		}else{
+			n->expire = current_ + n->repeat;
+			place(n);
+		}
+	}
+	void timer_wheel::advance(std::uint64_t now) {
+		while(current_ < now) {
+			if(index_.empty()) {
+				current_ = now;
+				break;
+			}
+			// 长时间未推进时跳过其间无到期、无下放的 tick
+			if(now - current_ > TIMER_WHEEL_SLOTS) {
+				std::int64_t n = next();
+				if(n > 1) {
+					current_ = std::min<std::uint64_t>(current_ + n - 1, now);
+					continue;
+				}
+			}
+			++current_;
+			for(int i=TIMER_WHEEL_LEVELS-1; i>0; --i) {
+				if((current_ & ((1ull << (TIMER_WHEEL_BITS * i)) - 1)) == 0) cascade(i);
+			}
+			// 回调中添加的定时器不会进入当前槽
+			timer_wheel_link* slot = &slots_[0][current_ & TIMER_WHEEL_MASK];
+			while(slot->next != slot) {
+				timer_wheel_node* n = static_cast<timer_wheel_node*>(slot->next);
+				timer_wheel_unlink(n);
+				running_ = n;
+				try {
+					n->cb();
+				}catch(...) {
+					finish(n);
+					// 当前槽中余下的定时器移至下一 tick
+					while(slot->next != slot) {
+						timer_wheel_node* m = static_cast<timer_wheel_node*>(slot->next);
+						timer_wheel_unlink(m);
+						m->expire = current_ + 1;
+						place(m);
+					}
+					throw;
+				}
+				finish(n);
+			}
+		}
+	}
+	std::int64_t timer_wheel::next() const {
+		if(index_.empty()) return -1;
+		// 各层中最近的非空槽: 底层为到期 tick, 上层为下放 tick (不同时刻放入的定时器, 上层的可能早于底层的到期)
+		std::int64_t r = -1;
+		for(int i=1; i<TIMER_WHEEL_SLOTS; ++i) {
+			const timer_wheel_link* slot = &slots_[0][(current_ + i) & TIMER_WHEEL_MASK];
+			if(slot->next == slot) continue;
+			r = i;
+			break;
+		}
+		for(int l=1; l<TIMER_WHEEL_LEVELS; ++l) {
+			std::uint64_t base = current_ >> (TIMER_WHEEL_BITS * l);
+			for(int i=1; i<=TIMER_WHEEL_SLOTS; ++i) {
+				const timer_wheel_link* slot = &slots_[l][(base + i) & TIMER_WHEEL_MASK];
+				if(slot->next == slot) continue;
+				std::int64_t d = ((base + i) << (TIMER_WHEEL_BITS * l)) - current_;
+				if(r < 0 || d < r) r = d;
+				break;
+			}
+		}
+		return r;
+	}
+	bool timer_wheel::cancel(std::uint64_t id) {
+		auto i = index_.find(id);
+		if(i == index_.end() || i->second->cancelled) return false;
+		timer_wheel_node* n = i->second;
+		if(n == running_) {
+			n->cancelled = true;
+			return true;
+		}
+		timer_wheel_unlink(n);
+		index_.erase(i);
+		delete n;
+		return true;
+	}
+	std::uint64_t timer_wheel::now() const {
+		return current_;
+	}
+	std::size_t timer_wheel::size() const {
+		return running_ && running_->cancelled ? index_.size() - 1 : index_.size();
+	}
+	void timer_wheel::clear() {
+		// 回调可能持有 PHP 数据, 其释放可能再次访问定时器
+		std::vector<timer_wheel_node*> nodes;
+		for(auto i=index_.begin(); i!=index_.end(); ++i) {
+			if(i->second == running_) i->second->cancelled = true;
+			else nodes.push_back(i->second);
+		}
+		for(auto i=nodes.begin(); i!=nodes.end(); ++i) {
+			timer_wheel_unlink(*i);
+			index_.erase((*i)->id);
+		}
+		for(auto i=nodes.begin(); i!=nodes.end(); ++i) delete *i;
+	}
+
+	event_loop::event_loop()
+	: epfd_(epoll_create1(EPOLL_CLOEXEC))
+	, stop_(false)
+	, running_(false)
+	, t0_(std::chrono::steady_clock::now()) {
+		if(epfd_ < 0) throw php::exception(zend_ce_error, std::string("event_loop: epoll_create1 failed: ") + std::strerror(errno));
+	}
+	event_loop::~event_loop() {
+		close();
+	}
+	void event_loop::watch(int fd, std::uint32_t events, std::function<void (std::uint32_t events)> handler) {
+		if(epfd_ < 0) throw php::exception(zend_ce_error, "event_loop: loop closed");
+		epoll_event ev;
+		ev.events  = events;
+		ev.data.fd = fd;
+		int op = watchers_.count(fd) ? EPOLL_CTL_MOD : EPOLL_CTL_ADD;
+		if(epoll_ctl(epfd_, op, fd, &ev) != 0) throw php::exception(zend_ce_error, std::string("event_loop: epoll_ctl failed: ") + std::strerror(errno));
+		watchers_[fd] = std::make_shared<std::function<void (std::uint32_t events)>>(std::move(handler));
+	}
+	void event_loop::modify(int fd, std::uint32_t events) {
+		if(epfd_ < 0 || !watchers_.count(fd)) return;
+		epoll_event ev;
+		ev.events  = events;
+		ev.data.fd = fd;
+		if(epoll_ctl(epfd_, EPOLL_CTL_MOD, fd, &ev) != 0) throw php::exception(zend_ce_error, std::string("event_loop: epoll_ctl failed: ") + std::strerror(errno));
+	}
+	void event_loop::unwatch(int fd) {
+		auto i = watchers_.find(fd);
+		if(i == watchers_.end()) return;
+		// 处理函数可能正在执行 (poll() 持有其副本)
+		std::shared_ptr<std::function<void (std::uint32_t events)>> h = std::move(i->second);
+		watchers_.erase(i);
+		if(epfd_ >= 0) epoll_ctl(epfd_, EPOLL_CTL_DEL, fd, nullptr);
+	}
+	std::uint64_t event_loop::after(std::uint64_t ms, std::function<void ()> cb) {
+		return timers_.add(now() + ms, std::move(cb));
+	}
+	std::uint64_t event_loop::every(std::uint64_t ms, std::function<void ()> cb) {
+		if(ms == 0) ms = 1;
+		return timers_.add(now() + ms, std::move(cb), ms);
+	}
+	bool event_loop::cancel(std::uint64_t id) {
+		return timers_.cancel(id);
+	}
+	// 执行超时 (max_execution_time) 时返回, 由引擎报告错误
+	static bool event_loop_timed_out() {
+		return EG(timed_out);
+	}
+	// 标记执行中 (含异常退出)
+	struct event_loop_running {
+		bool& running;
+		explicit event_loop_running(bool& r)
+		: running(r) {
+			if(running) throw php::exception(zend_ce_error, "event_loop: already running");
+			running = true;
+		}
+		~event_loop_running() {
+			running = false;
+		}
+	};
+	void event_loop::run() {
+		event_loop_running guard(running_);
+		stop_ = false;
+		while(!stop_ && alive() && !event_loop_timed_out()) poll(-1);
+	}
+	bool event_loop::run_until(std::function<bool ()> pred, std::int64_t timeout_ms) {
+		event_loop_running guard(running_);
+		stop_ = false;
+		std::uint64_t deadline = timeout_ms < 0 ? 0 : now() + timeout_ms;
+		while(true) {
+			if(pred()) return true;
+			if(stop_ || !alive() || event_loop_timed_out()) return false;
+			if(timeout_ms < 0) {
+				poll(-1);
+				continue;
+			}
+			std::uint64_t t = now();
+			if(t >= deadline) return false;
+			poll(deadline - t);
+		}
+	}
+	void event_loop::stop() {
+		stop_ = true;
+	}
+	void event_loop::close() {
+		stop_ = true;
+		// 套接字回调持有 PHP 封装对象, 封装对象持有套接字, 须主动结束以关闭 fd
+		while(!sockets_.empty()) {
+			event_socket* s = sockets_.begin()->second;
+			sockets_.erase(sockets_.begin());
+			s->abort();
+		}
+		// 回调释放时可能再次访问 (如套接字析构时 unwatch)
+		std::map<int, std::shared_ptr<std::function<void (std::uint32_t events)>>> watchers;
+		watchers.swap(watchers_);
+		timers_.clear();
+		if(epfd_ >= 0) ::close(epfd_);
+		epfd_ = -1;
+	}
+	std::uint64_t event_loop::now() const {
+		return std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - t0_).count();
+	}
+	bool event_loop::alive() const {
+		return epfd_ >= 0 && (!watchers_.empty() || timers_.size() > 0);
+	}
+	void event_loop::poll(std::int64_t timeout_ms) {
+		std::int64_t wait = timers_.next();
+		if(wait >= 0) {
+			wait = static_cast<std::int64_t>(timers_.now() + wait) - static_cast<std::int64_t>(now());
+			if(wait < 0) wait = 0;
+		}
+		if(timeout_ms >= 0 && (wait < 0 || timeout_ms < wait)) wait = timeout_ms;
+		if(wait > std::numeric_limits<int>::max()) wait = std::numeric_limits<int>::max();
+		epoll_event events[64];
+		int n = epoll_wait(epfd_, events, 64, static_cast<int>(wait));
+		if(n < 0) {
+			if(errno != EINTR) throw php::exception(zend_ce_error, std::string("event_loop: epoll_wait failed: ") + std::strerror(errno));
+			n = 0;
+		}
+		for(int i=0; i<n; ++i) {
+			auto w = watchers_.find(events[i].data.fd);
+			// 已在本轮处理中移除
+			if(w == watchers_.end()) continue;
+			std::shared_ptr<std::function<void (std::uint32_t events)>> h = w->second;
+			(*h)(events[i].events);
+			if(epfd_ < 0) return;
+		}
+		timers_.advance(now());
+	}
+
+	enum {
+		EVENT_SOCKET_CONNECTING,
+		EVENT_SOCKET_CONNECTED,
+		EVENT_SOCKET_LISTENING,
+		EVENT_SOCKET_CLOSED,
+	};
+	static const std::size_t EVENT_SOCKET_CHUNK = 16 * 1024;
+	static std::string event_socket_error(const char* op, int e) {
+		return std::string("event_loop: ") + op + " failed: " + std::strerror(e);
+	}
+	// 解析地址; 返回地址族
+	static int event_socket_resolve(const std::string& address, bool passive, sockaddr_storage& sa, socklen_t& len) {
+		std::memset(&sa, 0, sizeof(sa));
+		if(address.compare(0, 7, "unix://") == 0) {
+			sockaddr_un* un = reinterpret_cast<sockaddr_un*>(&sa);
+			std::string path = address.substr(7);
+			if(path.empty() || path.size() >= sizeof(un->sun_path)) throw php::exception(zend_ce_error, "event_loop: illegal unix socket path '" + path + "'");
+			un->sun_family = AF_UNIX;
+			std::memcpy(un->sun_path, path.c_str(), path.size() + 1);
+			len = offsetof(sockaddr_un, sun_path) + path.size() + 1;
+			return AF_UNIX;
+		}
+		std::string hp = address.compare(0, 6, "tcp://") == 0 ? address.substr(6) : address;
+		std::size_t colon = hp.rfind(':');
+		if(colon == std::string::npos) throw php::exception(zend_ce_error, "event_loop: illegal address '" + address + "' (port required)");
+		std::string host = hp.substr(0, colon), port = hp.substr(colon + 1);
+		if(host.size() >= 2 && host.front() == '[' && host.back() == ']') host = host.substr(1, host.size() - 2);
+		addrinfo hints, *ai = nullptr;
+		std::memset(&hints, 0, sizeof(hints));
+		hints.ai_family   = AF_UNSPEC;
+		hints.ai_socktype = SOCK_STREAM;
+		hints.ai_flags    = AI_NUMERICSERV | (passive ? AI_PASSIVE : 0);
+		int r = getaddrinfo(host.empty() ? nullptr : host.c_str(), port.c_str(), &hints, &ai);
+		if(r != 0) throw php::exception(zend_ce_error, "event_loop: cannot resolve '" + address + "': " + gai_strerror(r));
+		std::memcpy(&sa, ai->ai_addr, ai->ai_addrlen);
+		len = ai->ai_addrlen;
+		freeaddrinfo(ai);
+		return sa.ss_family;
+	}
+	static std::string event_socket_format(const sockaddr_storage& sa, socklen_t len) {
+		char host[INET6_ADDRSTRLEN];
+		if(sa.ss_family == AF_UNIX) {
+			const sockaddr_un* un = reinterpret_cast<const sockaddr_un*>(&sa);
+			if(len <= offsetof(sockaddr_un, sun_path)) return "unix://";
+			return "unix://" + std::string(un->sun_path, strnlen(un->sun_path, len - offsetof(sockaddr_un, sun_path)));
+		}else if(sa.ss_family == AF_INET) {
+			const sockaddr_in* in = reinterpret_cast<const sockaddr_in*>(&sa);
+			inet_ntop(AF_INET, &in->sin_addr, host, sizeof(host));
+			return std::string(host) + ":" + std::to_string(ntohs(in->sin_port));
+		}else if(sa.ss_family == AF_INET6) {
+			const sockaddr_in6* in6 = reinterpret_cast<const sockaddr_in6*>(&sa);
+			inet_ntop(AF_INET6, &in6->sin6_addr, host, sizeof(host));
+			return "[" + std::string(host) + "]:" + std::to_string(ntohs(in6->sin6_port));
+		}
+		return "";
+	}
+
+	event_socket::event_socket(const std::shared_ptr<event_loop>& loop, int fd, int status)
+	: loop_(loop)
+	, fd_(fd)
+	, status_(status)
+	, closing_(false)
+	, events_(0) {}
+	event_socket::~event_socket() {
+		if(fd_ < 0) return;
+		loop_->sockets_.erase(fd_);
+		loop_->unwatch(fd_);
+		::close(fd_);
+		if(!path_.empty()) ::unlink(path_.c_str());
+	}
+	std::shared_ptr<event_socket> event_socket::connect(const std::shared_ptr<event_loop>& loop, const std::string& address) {
+		sockaddr_storage sa;
+		socklen_t        len;
+		int family = event_socket_resolve(address, false, sa, len);
+		int fd = ::socket(family, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+		if(fd < 0) throw php::exception(zend_ce_error, event_socket_error("socket", errno));
+		if(family != AF_UNIX) {
+			int v = 1;
+			setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &v, sizeof(v));
+		}
+		if(::connect(fd, reinterpret_cast<sockaddr*>(&sa), len) != 0 && errno != EINPROGRESS) {
+			int e = errno;
+			::close(fd);
+			throw php::exception(zend_ce_error, event_socket_error("connect", e));
+		}
+		// 立即完成时同样于可写事件中回调
+		std::shared_ptr<event_socket> s(new event_socket(loop, fd, EVENT_SOCKET_CONNECTING));
+		s->attach();
+		return s;
+	}
+	std::shared_ptr<event_socket> event_socket::listen(const std::shared_ptr<event_loop>& loop, const std::string& address, int backlog) {
+		sockaddr_storage sa;
+		socklen_t        len;
+		int family = event_socket_resolve(address, true, sa, len);
+		int fd = ::socket(family, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+		if(fd < 0) throw php::exception(zend_ce_error, event_socket_error("socket", errno));
+		if(family != AF_UNIX) {
+			int v = 1;
+			setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &v, sizeof(v));
+		}
+		if(::bind(fd, reinterpret_cast<sockaddr*>(&sa), len) != 0 || ::listen(fd, backlog) != 0) {
+			int e = errno;
+			::close(fd);
+			throw php::exception(zend_ce_error, event_socket_error("listen", e));
+		}
+		std::shared_ptr<event_socket> s(new event_socket(loop, fd, EVENT_SOCKET_LISTENING));
+		if(family == AF_UNIX) s->path_ = reinterpret_cast<sockaddr_un*>(&sa)->sun_path;
+		s->attach();
+		return s;
+	}
+	void event_socket::on_connect(std::function<void (const std::string& error)> cb) {
+		on_connect_ = std::move(cb);
+	}
+	void event_socket::on_accept(std::function<void (const std::shared_ptr<event_socket>& s)> cb) {
+		on_accept_ = std::move(cb);
+	}
+	void event_socket::on_data(std::function<void (stream_buffer& buf)> cb) {
+		on_data_ = std::move(cb);
+		update();
+	}
+	void event_socket::on_close(std::function<void (const std::string& error)> cb) {
+		on_close_ = std::move(cb);
+	}
+	// 注册至 event_loop (持有自身直至 unwatch)
+	void event_socket::attach() {
+		std::shared_ptr<event_socket> self = shared_from_this();
+		events_ = status_ == EVENT_SOCKET_CONNECTING ? EPOLLOUT : status_ == EVENT_SOCKET_LISTENING ? EPOLLIN : 0;
+		loop_->watch(fd_, events_, [self] (std::uint32_t events) {
+			self->handle(events);
+		});
+		loop_->sockets_[fd_] = this;
+	}
+	void event_socket::update() {
+		if(status_ != EVENT_SOCKET_CONNECTED) return;
+		std::uint32_t events = 0;
+		if(on_data_ && !closing_) events |= EPOLLIN;
+		if(wbuf_.size() > 0) events |= EPOLLOUT;
+		if(events == events_) return;
+		events_ = events;
+		loop_->modify(fd_, events_);
+	}
+	void event_socket::handle(std::uint32_t events) {
+		std::shared_ptr<event_socket> self = shared_from_this();
+		switch(status_) {
+		case EVENT_SOCKET_CONNECTING:
+			do_connect();
+			break;
+		case EVENT_SOCKET_LISTENING:
+			do_accept();
+			break;
+		case EVENT_SOCKET_CONNECTED:
+			if(events & EPOLLERR) {
+				int e = 0;
+				socklen_t len = sizeof(e);
+				getsockopt(fd_, SOL_SOCKET, SO_ERROR, &e, &len);
+				finish(e ? event_socket_error("socket", e) : std::string());
+				break;
+			}
+			if(events & EPOLLOUT) do_write();
+			if(status_ != EVENT_SOCKET_CONNECTED) break;
+			if(events & EPOLLIN) do_read();
+			// 双向均已关闭且未读取 (否则由读取到 EOF 处理)
+			else if(events & EPOLLHUP) finish("");
+			break;
+		}
+	}
+	void event_socket::do_connect() {
+		int e = 0;
+		socklen_t len = sizeof(e);
+		if(getsockopt(fd_, SOL_SOCKET, SO_ERROR, &e, &len) != 0) e = errno;
+		std::function<void (const std::string& error)> cb = std::move(on_connect_);
+		on_connect_ = nullptr;
+		if(e) {
+			std::string error = event_socket_error("connect", e);
+			finish(error);
+			if(cb) cb(error);
+			return;
+		}
+		status_ = EVENT_SOCKET_CONNECTED;
+		update();
+		if(cb) cb("");
+	}
+	void event_socket::do_accept() {
+		// 每轮至多接受 64 个连接
+		for(int i=0; i<64 && status_ == EVENT_SOCKET_LISTENING; ++i) {
+			sockaddr_storage sa;
+			socklen_t        len = sizeof(sa);
+			int fd = accept4(fd_, reinterpret_cast<sockaddr*>(&sa), &len, SOCK_NONBLOCK | SOCK_CLOEXEC);
+			if(fd < 0) {
+				if(errno == EINTR || errno == ECONNABORTED) continue;
+				// EAGAIN 或资源不足 (EMFILE 等, 待下次事件重试)
+				break;
+			}
+			if(sa.ss_family != AF_UNIX) {
+				int v = 1;
+				setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &v, sizeof(v));
+			}
+			std::shared_ptr<event_socket> s(new event_socket(loop_, fd, EVENT_SOCKET_CONNECTED));
+			s->attach();
+			std::function<void (const std::shared_ptr<event_socket>& s)> cb = on_accept_;
+			if(cb) cb(s);
+		}
+	}
+	void event_socket::do_read() {
+		bool eof = false;
+		// 每轮至多读取 4 块, 避免单个连接占用事件循环
+		for(int i=0; i<4; ++i) {
+			if(rbuf_.size() + EVENT_SOCKET_CHUNK > rbuf_.max_size()) {
+				finish("event_loop: read buffer full");
+				return;
+			}
+			ssize_t r = ::read(fd_, rbuf_.prepare(EVENT_SOCKET_CHUNK), EVENT_SOCKET_CHUNK);
+			if(r > 0) {
+				rbuf_.commit(r);
+				if(static_cast<std::size_t>(r) < EVENT_SOCKET_CHUNK) break;
+			}else if(r == 0) {
+				eof = true;
+				break;
+			}else if(errno == EINTR) {
+				continue;
+			}else if(errno == EAGAIN || errno == EWOULDBLOCK) {
+				break;
+			}else{
+				finish(event_socket_error("read", errno));
+				return;
+			}
+		}
+		if(rbuf_.size() > 0 && on_data_) {
+			std::function<void (stream_buffer& buf)> cb = on_data_; // 回调中可能被替换或关闭
+			cb(rbuf_);
+		}
+		if(!eof || status_ != EVENT_SOCKET_CONNECTED) return;
+		// 对端关闭: 发送完写缓冲后关闭
+		closing_ = true;
+		if(wbuf_.size() == 0) finish("");
+		else update();
+	}
+	void event_socket::do_write() {
+		while(wbuf_.size() > 0) {
+			ssize_t r = ::send(fd_, wbuf_.data(), wbuf_.size(), MSG_NOSIGNAL);
+			if(r >= 0) {
+				wbuf_.consume(r);
+			}else if(errno == EINTR) {
+				continue;
+			}else if(errno == EAGAIN || errno == EWOULDBLOCK) {
+				break;
+			}else{
+				finish(event_socket_error("write", errno));
+				return;
+			}
+		}
+		if(wbuf_.size() == 0 && closing_) finish("");
+		else update();
+	}
+	void event_socket::write(const char* data, std::size_t size) {
+		if(status_ == EVENT_SOCKET_CLOSED || closing_) throw php::exception(zend_ce_error, "event_loop: socket closed");
+		if(status_ == EVENT_SOCKET_LISTENING) throw php::exception(zend_ce_error, "event_loop: cannot write to a listening socket");
+		std::size_t n = 0;
+		if(status_ == EVENT_SOCKET_CONNECTED && wbuf_.size() == 0) {
+			ssize_t r = ::send(fd_, data, size, MSG_NOSIGNAL);
+			// 错误于可写事件中再次发送时报告
+			if(r > 0) n = r;
+		}
+		if(n == size) return;
+		if(wbuf_.size() + size - n > wbuf_.max_size()) throw php::exception(zend_ce_error, "event_loop: write buffer full");
+		wbuf_.sputn(data + n, size - n);
+		update();
+	}
+	void event_socket::close(bool graceful) {
+		if(status_ == EVENT_SOCKET_CLOSED) return;
+		if(graceful && status_ == EVENT_SOCKET_CONNECTED && wbuf_.size() > 0) {
+			closing_ = true;
+			update();
+		}else{
+			finish("");
+		}
+	}
+	void event_socket::finish(const std::string& error) {
+		if(status_ == EVENT_SOCKET_CLOSED) return;
+		status_ = EVENT_SOCKET_CLOSED;
+		// 释放 event_loop 持有的引用前保持自身
+		std::shared_ptr<event_socket> self = shared_from_this();
+		loop_->sockets_.erase(fd_);
+		loop_->unwatch(fd_);
+		::close(fd_);
+		fd_ = -1;
+		if(!path_.empty()) ::unlink(path_.c_str());
+		path_.clear();
+		// 回调可能持有 PHP 数据 (含封装对象自身), 关闭后释放
+		std::function<void (const std::string& error)> cb = std::move(on_close_);
+		on_close_  = nullptr;
+		on_accept_ = nullptr;
+		on_data_   = nullptr;
+		if(cb) cb(error);
+	}
+	void event_socket::abort() {
+		if(status_ == EVENT_SOCKET_CLOSED) return;
+		// 回调释放时可能移除最后的外部引用
+		std::shared_ptr<event_socket> self = shared_from_this();
+		on_connect_ = nullptr;
+		on_accept_  = nullptr;
+		on_data_    = nullptr;
+		on_close_   = nullptr;
+		finish("");
+	}
+	std::size_t event_socket::buffered() {
+		return wbuf_.size();
+	}
+	bool event_socket::closed() const {
+		return status_ == EVENT_SOCKET_CLOSED;
+	}
+	std::string event_socket::address() const {
+		sockaddr_storage sa;
+		socklen_t        len = sizeof(sa);
+		if(fd_ < 0 || getsockname(fd_, reinterpret_cast<sockaddr*>(&sa), &len) != 0) return "";
+		return event_socket_format(sa, len);
+	}
+	std::string event_socket::peer() const {
+		sockaddr_storage sa;
+		socklen_t        len = sizeof(sa);
+		if(fd_ < 0 || getpeername(fd_, reinterpret_cast<sockaddr*>(&sa), &len) != 0) return "";
+		return event_socket_format(sa, len);
+	}
+
+	static value event_loop_callback(parameters& params, int i) {
+		value cb = params[i];
+		if(!cb.type_of(TYPE::CALLABLE)) throw php::exception(zend_ce_type_error, "event_loop: callback must be callable");
+		return cb;
+	}
+	event_loop_object::~event_loop_object() {
+		if(loop_) loop_->close();
+	}
+	const std::shared_ptr<event_loop>& event_loop_object::loop() {
+		if(!loop_) loop_ = std::make_shared<event_loop>();
+		return loop_;
+	}
+	value event_loop_object::after(parameters& params) {
+		std::int64_t ms = params[0];
+		callable cb = event_loop_callback(params, 1);
+		return static_cast<std::int64_t>(loop()->after(ms < 0 ? 0 : ms, [cb] () {
+			cb.call();
+		}));
+	}
+	value event_loop_object::every(parameters& params) {
+		std::int64_t ms = params[0];
+		callable cb = event_loop_callback(params, 1);
+		return static_cast<std::int64_t>(loop()->every(ms < 0 ? 0 : ms, [cb] () {
+			cb.call();
+		}));
+	}
+	value event_loop_object::cancel(parameters& params) {
+		std::int64_t id = params[0];
+		return loop()->cancel(id);
+	}
+	value event_loop_object::connect(parameters& params) {
+		string address = params[0];
+		callable cb = event_loop_callback(params, 1);
+		std::shared_ptr<event_socket> s = event_socket::connect(loop(), std::string(address.c_str(), address.size()));
+		value obj = event_socket_object::create(s);
+		s->on_connect([cb, obj] (const std::string& error) {
+			if(error.empty()) cb.call({obj, nullptr});
+			else cb.call({obj, error});
+		});
+		return obj;
+	}
+	value event_loop_object::listen(parameters& params) {
+		string address = params[0];
+		callable cb = event_loop_callback(params, 1);
+		std::shared_ptr<event_socket> s = event_socket::listen(loop(), std::string(address.c_str(), address.size()));
+		s->on_accept([cb] (const std::shared_ptr<event_socket>& s) {
+			cb.call({event_socket_object::create(s)});
+		});
+		return event_socket_object::create(s);
+	}
+	value event_loop_object::run(parameters& params) {
+		loop()->run();
+		return nullptr;
+	}
+	value event_loop_object::run_until(parameters& params) {
+		callable pred = event_loop_callback(params, 0);
+		double timeout = params.size() > 1 ? params[1].to_float() : -1;
+		return loop()->run_until([pred] () -> bool {
+			value r = pred.call();
+			return r.to_boolean();
+		}, timeout < 0 ? -1 : static_cast<std::int64_t>(timeout * 1000));
+	}
+	value event_loop_object::stop(parameters& params) {
+		loop()->stop();
+		return nullptr;
+	}
+	value event_loop_object::now(parameters& params) {
+		return static_cast<std::int64_t>(loop()->now());
+	}
+
+	value event_socket_object::create(const std::shared_ptr<event_socket>& s) {
+		if(!class_entry<event_socket_object>::entry()) throw php::exception(zend_ce_error, "event_loop: class_entry<event_socket_object> not registered");
+		value obj(class_entry<event_socket_object>::entry());
+		static_cast<event_socket_object*>(native(Z_OBJ_P(static_cast<zval*>(obj))))->socket_ = s;
+		return obj;
+	}
+	event_socket* event_socket_object::socket() const {
+		if(!socket_) throw php::exception(zend_ce_error, "event_loop: socket not created by event_loop");
+		return socket_.get();
+	}
+	// 回调持有封装对象 (连接关闭时释放)
+	value event_socket_object::on_data(parameters& params) {
+		callable cb = event_loop_callback(params, 0);
+		value    self(&obj_);
+		socket()->on_data([cb, self] (stream_buffer& buf) {
+			string data(buf.data(), buf.size());
+			buf.consume(buf.size());
+			cb.call({self, data});
+		});
+		return nullptr;
+	}
+	value event_socket_object::on_close(parameters& params) {
+		callable cb = event_loop_callback(params, 0);
+		value    self(&obj_);
+		socket()->on_close([cb, self] (const std::string& error) {
+			if(error.empty()) cb.call({self, nullptr});
+			else cb.call({self, error});
+		});
+		return nullptr;
+	}
+	value event_socket_object::write(parameters& params) {
+		string data = params[0];
+		if(!data.type_of(TYPE::STRING)) data.to_string();
+		socket()->write(data.c_str(), data.size());
+		return static_cast<std::int64_t>(socket()->buffered());
+	}
+	value event_socket_object::close(parameters& params) {
+		value graceful = params.size() > 0 ? value(params[0]) : value(true);
+		socket()->close(graceful.to_boolean());
+		return nullptr;
+	}
+	value event_socket_object::address(parameters& params) {
+		return socket()->address();
+	}
+	value event_socket_object::peer(parameters& params) {
+		return socket()->peer();
+	}
+	value event_socket_object::buffered(parameters& params) {
+		return static_cast<std::int64_t>(socket()->buffered());
+	}
+}
@@ -0,0 +1,183 @@
+#pragma once
+
+#include "value.h"
+#include "callable.h"
+#include "class_base.h"
+#include "parameters.h"
+#include "stream_buffer.h"
+
+namespace php {
+	struct timer_wheel_node;
+	struct timer_wheel_link {
+		timer_wheel_link* prev;
+		timer_wheel_link* next;
+	};
+	// 分层时间轮 (5 层, 每层 64 槽, 单位为 tick): 添加、取消为 O(1), 推进时逐 tick 执行到期定时器并将上层槽中的定时器逐级下放
+	// 超出 64^5 tick 的定时器暂存于最高层, 下放时重新计算
+	class timer_wheel {
+	public:
+		explicit timer_wheel(std::uint64_t now = 0);
+		~timer_wheel();
+		timer_wheel(const timer_wheel& w) = delete;
+		timer_wheel& operator =(const timer_wheel& w) = delete;
+		// 于 expire (绝对 tick, 不早于下一 tick) 执行 cb; repeat > 0 时此后每 repeat tick 重复执行; 返回定时器编号
+		std::uint64_t add(std::uint64_t expire, std::function<void ()> cb, std::uint64_t repeat = 0);
+		// 取消 (可在回调中取消自身); 不存在或已执行时返回 false
+		bool cancel(std::uint64_t id);
+		// 推进至 now 并执行到期定时器; 回调抛出的异常向外传递, 当前 tick 中未执行的定时器于下次推进时执行
+		void advance(std::uint64_t now);
+		// 距下一次须推进的 tick 数 (定时器到期或上层槽下放), 无定时器时返回 -1
+		std::int64_t next() const;
+		// 已推进至的 tick
+		std::uint64_t now() const;
+		std::size_t size() const;
+		// 移除全部定时器 (不执行)
+		void clear();
+	private:
+		timer_wheel_link                            slots_[5][64];
+		std::map<std::uint64_t, timer_wheel_node*> index_;
+		std::uint64_t                               current_;
+		std::uint64_t                               id_;
+		timer_wheel_node*                           running_;
+
+		void place(timer_wheel_node* n);
+		void cascade(int level);
+		void finish(timer_wheel_node* n);
+	};
+	class event_socket;
+	// epoll 反应器 (水平触发) 与定时器 (毫秒时间轮), 仅可在创建线程中使用
+	// 回调在 run() / run_until() 中执行 (不可在回调中再次调用), 抛出的异常中止本次执行并向外传递 (之后可再次执行)
+	class event_loop {
+	public:
+		event_loop();
+		~event_loop();
+		event_loop(const event_loop& l) = delete;
+		event_loop& operator =(const event_loop& l) = delete;
+		// 监听 fd 的 EPOLLIN / EPOLLOUT 等事件 (EPOLLERR / EPOLLHUP 总是报告)
+		void watch(int fd, std::uint32_t events, std::function<void (std::uint32_t events)> handler);
+		void modify(int fd, std::uint32_t events);
+		// 须在关闭 fd 之前调用
+		void unwatch(int fd);
+		// ms 毫秒后执行一次 / 每 ms 毫秒执行, 返回定时器编号
+		std::uint64_t after(std::uint64_t ms, std::function<void ()> cb);
+		std::uint64_t every(std::uint64_t ms, std::function<void ()> cb);
+		bool cancel(std::uint64_t id);
+		// 执行直至不存在监听的 fd 及定时器, 或 stop() 被调用
+		void run();
+		// 执行直至 pred() 为真 (返回 true), 或超时 (timeout_ms < 0 不限) / stop() / 无监听及定时器 (返回 false)
+		bool run_until(std::function<bool ()> pred, std::int64_t timeout_ms = -1);
+		// 当前的 run() / run_until() 于本轮事件处理后返回
+		void stop();
+		// 关闭已注册的套接字并释放全部监听及定时器 (不执行回调), 之后不可继续使用
+		void close();
+		// 创建以来的毫秒数
+		std::uint64_t now() const;
+		bool alive() const;
+	private:
+		int                                                                       epfd_;
+		bool                                                                      stop_;
+		bool                                                                      running_;
+		std::chrono::steady_clock::time_point                                     t0_;
+		timer_wheel                                                               timers_;
+		std::map<int, std::shared_ptr<std::function<void (std::uint32_t events)>>> watchers_;
+		std::map<int, event_socket*>                                              sockets_; // 已注册的套接字 (关闭时结束)
+
+		void poll(std::int64_t timeout_ms);
+		friend class event_socket;
+	};
+	// 非阻塞 TCP / Unix 流套接字, 地址形如 "tcp://127.0.0.1:8080", "[::1]:8080" (默认 tcp), "unix:///tmp/test.sock"
+	// 域名解析 (getaddrinfo) 为阻塞调用; 回调均在 event_loop 中执行; 已注册到 event_loop 的套接字由其持有, 直至关闭
+	class event_socket: public std::enable_shared_from_this<event_socket> {
+	public:
+		~event_socket();
+		event_socket(const event_socket& s) = delete;
+		event_socket& operator =(const event_socket& s) = delete;
+		// 发起连接; 立即失败时抛出异常, 完成 (或失败) 后调用 on_connect 回调
+		static std::shared_ptr<event_socket> connect(const std::shared_ptr<event_loop>& loop, const std::string& address);
+		// 监听 (Unix 套接字文件须不存在, 关闭时删除); 接受的连接由 on_accept 回调取得
+		static std::shared_ptr<event_socket> listen(const std::shared_ptr<event_loop>& loop, const std::string& address, int backlog = 511);
+		// 连接完成: error 为空表示成功
+		void on_connect(std::function<void (const std::string& error)> cb);
+		void on_accept(std::function<void (const std::shared_ptr<event_socket>& s)> cb);
+		// 读取的数据追加至 buf, 回调中消费 (consume) 已处理的部分, 余下的保留至下次; 未设置时不读取 (数据保留于内核缓冲)
+		void on_data(std::function<void (stream_buffer& buf)> cb);
+		// 关闭 (对端关闭、出错或 close()): error 为空表示正常关闭
+		void on_close(std::function<void (const std::string& error)> cb);
+		// 尽量直接发送, 余下的数据加入写缓冲; 写缓冲超出上限时抛出异常
+		void write(const char* data, std::size_t size);
+		// graceful 时发送完写缓冲中的数据后关闭
+		void close(bool graceful = true);
+		// 写缓冲中尚未发送的字节数
+		std::size_t buffered();
+		bool closed() const;
+		// 本地 / 对端地址 (格式同上)
+		std::string address() const;
+		std::string peer() const;
+	private:
+		std::shared_ptr<event_loop>                                   loop_;
+		int                                                           fd_;
+		int                                                           status_;
+		bool                                                          closing_;
+		std::uint32_t                                                 events_;
+		std::string                                                   path_; // 监听的 Unix 套接字文件
+		stream_buffer                                                 rbuf_;
+		stream_buffer                                                 wbuf_;
+		std::function<void (const std::string& error)>                on_connect_;
+		std::function<void (const std::shared_ptr<event_socket>& s)>  on_accept_;
+		std::function<void (stream_buffer& buf)>                      on_data_;
+		std::function<void (const std::string& error)>                on_close_;
+
+		event_socket(const std::shared_ptr<event_loop>& loop, int fd, int status);
+		void attach();
+		void update();
+		void handle(std::uint32_t events);
+		void do_connect();
+		void do_accept();
+		void do_read();
+		void do_write();
+		void finish(const std::string& error);
+		// 结束且不执行回调 (event_loop 关闭时)
+		void abort();
+		friend class event_loop;
+	};
+	// PHP 类封装 (以 class_entry<event_loop_object> / class_entry<event_socket_object> 注册, 后者实例由前者创建):
+	// event_loop_object: after(int $ms, callable $cb): int, every(int $ms, callable $cb): int, cancel(int $id): bool,
+	//   connect(string $address, callable $cb($socket, ?string $error)): socket, listen(string $address, callable $cb($socket)): socket,
+	//   run(), run_until(callable $pred, float $timeout = -1): bool, stop(), now(): int
+	// event_socket_object: on_data(callable $cb($socket, string $data)), on_close(callable $cb($socket, ?string $error)),
+	//   write(string $data): int (写缓冲字节数), close(bool $graceful = true), address(): string, peer(): string, buffered(): int
+	// 对象销毁时 (含请求结束) 关闭全部套接字及定时器
+	class event_loop_object: public class_base {
+	public:
+		~event_loop_object();
+		value after(parameters& params);
+		value every(parameters& params);
+		value cancel(parameters& params);
+		value connect(parameters& params);
+		value listen(parameters& params);
+		value run(parameters& params);
+		value run_until(parameters& params);
+		value stop(parameters& params);
+		value now(parameters& params);
+	private:
+		std::shared_ptr<event_loop> loop_;
+
+		const std::shared_ptr<event_loop>& loop();
+	};
+	class event_socket_object: public class_base {
+	public:
+		value on_data(parameters& params);
+		value on_close(parameters& params);
+		value write(parameters& params);
+		value close(parameters& params);
+		value address(parameters& params);
+		value peer(parameters& params);
+		value buffered(parameters& params);
+	private:
+		std::shared_ptr<event_socket> socket_;
+
+		event_socket* socket() const;
+		static value create(const std::shared_ptr<event_socket>& s);
+		friend class event_loop_object;
+	};
+}
@@ -3,21 +3,34 @@
 
 #include "class_entry.h"
 #include "closure.h"
+#include "persistent.h"
+#include "deferred.h"
+#include "thread_pool.h"
 
 namespace php {
 	extension_entry* extension_entry::self;
+#ifdef ZTS
+	ts_rsrc_id module_globals_id::id;
+	thread_local void* module_globals_id::cache = nullptr;
+	thread_local std::uint64_t extension_entry::requests_ = 0;
+#else
+	std::uint64_t extension_entry::requests_ = 0;
+#endif
 	extension_entry::extension_entry(const std::string& name, const std::string& version)
 	: name_(name)
-	, version_(version) {
+	, version_(version)
+	, ini_registered_(false)
+	, threads_(0) {
 		self = this;
 		dependencies_[0] = {"standard", "ge", "7.0.0", MODULE_DEP_REQUIRED};
 		dependencies_[1] = {"json", "ge", "7.0.0", MODULE_DEP_REQUIRED};
 		dependencies_[2] = {"date", "ge", "7.0.0", MODULE_DEP_REQUIRED};
-		dependencies_[3] = {nullptr, nullptr, nullptr, 0};
+		dependencies_[3] = {"spl", nullptr, nullptr, MODULE_DEP_REQUIRED}; // 延迟声明的类依赖自动加载
+		dependencies_[4] = {nullptr, nullptr, nullptr, 0};
 		entry_.size                  = sizeof(entry_);
 		entry_.zend_api              = ZEND_MODULE_API_NO;
 		entry_.zend_debug            = ZEND_DEBUG;
-		entry_.zts                   = 0;
+		entry_.zts                   = USING_ZTS;
 		entry_.ini_entry             = nullptr; // 此项数据由 zend engine 填充
 		entry_.deps                  = dependencies_;
 		entry_.name                  = name_.c_str();
@@ -36,7 +49,7 @@ namespace php {
 #endif
 		entry_.globals_ctor          = nullptr;
 		entry_.globals_dtor          = nullptr;
-		entry_.post_deactivate_func  = nullptr;
+		entry_.post_deactivate_func  = on_request_post_deactivate_handler;
 		entry_.module_started        = 0;
 		entry_.type                  = 0;
 		entry_.handle                = nullptr;
@@ -55,6 +68,10 @@ namespace php {
 		decriptions_.push_back(kv);
 		return *this;
 	}
+	extension_entry& extension_entry::threads(std::size_t n) {
+		threads_ = n;
+		return *this;
+	}
 	extension_entry::operator zend_module_entry*() {
 		// 函数注册
 		if(!function_entries_.empty()) {
@@ -82,6 +99,9 @@ namespace php {
 		handler_rsd_.push_back(handler);
 		return *this;
 	}
+	std::uint64_t extension_entry::request_sequence() {
+		return requests_;
+	}
 	// 扩展回调函数
 	int extension_entry::on_module_startup_handler  (int type, int module) {
 		// ini 注册
@@ -90,10 +110,13 @@ namespace php {
 			int i = 0;
 			for(;i<self->ini_entries_.size();++i) {
 				self->ini_entries_[i]->fill(&entries[i]);
+				// 绑定数据在注册期间须保持有效
+				if(self->ini_entries_[i]->binding()) self->ini_bindings_.push_back(self->ini_entries_[i]->binding());
 			}
 			// ini 注册停止条件
 			entries[i].name = nullptr; // zend_register_ini_entries() -> while(entry->name) { zend_string_copy }
 			zend_register_ini_entries(entries, module);
+			self->ini_registered_ = true;
 			// ini_entry 中持有的 php::string 拥有的 zend_string* 会被 Zend 引擎回收内存
 			// 故需要提前清理
 			self->ini_entries_.clear();
@@ -101,14 +124,18 @@ namespace php {
 		// 常量注册
 		if(!self->constant_entries_.empty()) {
 			for(auto i=self->constant_entries_.begin(); i!= self->constant_entries_.end(); ++i) {
-				(*i)->declare(module);
+				if(!(*i)->declare(module)) return FAILURE;
 			}
 			self->constant_entries_.clear();
 		}
-		// 完成 classes 注册
+		// 完成 classes 注册 (延迟声明的类先行登记, 以便作为其他类的父类时按需声明)
+		for(auto i=self->lazy_entries_.begin();i!=self->lazy_entries_.end();++i) {
+			(*i)->declare_lazy();
+		}
 		for(auto i=self->class_entries_.begin();i!=self->class_entries_.end();++i) {
 			(*i)->declare();
 		}
+		if(self->threads_ > 0) thread_pool::start(self->threads_);
 		// 正向调用
 		for(auto i=self->handler_mst_.begin(); i!= self->handler_mst_.end(); ++i) {
 			if(! (*i)(*self) ) return FAILURE;
@@ -116,16 +143,35 @@ namespace php {
 		return ZEND_RESULT_CODE::SUCCESS;
 	}
 	int extension_entry::on_module_shutdown_handler (int type, int module) {
-		if(!self->ini_entries_.empty()) {
+		// ini_entries_ 在注册后已被清理
+		if(self->ini_registered_) {
 			zend_unregister_ini_entries(module);
+			self->ini_registered_ = false;
 		}
 		// 反向调用
 		for(auto i=self->handler_msd_.rbegin(); i!= self->handler_msd_.rend(); ++i) {
 			if(! (*i)(*self) ) return FAILURE;
 		}
+		thread_pool::stop();
+		// 数组常量由本模块释放 (PHP < 7.3 引擎释放持久常量中的数组时报错); ZTS 下不存在模块级数组常量
+		zend_constant* c;
+		ZEND_HASH_FOREACH_PTR(EG(zend_constants), c) {
+#if PHP_VERSION_ID < 70300
+			if(c->module_number != module || Z_TYPE(c->value) != IS_ARRAY) continue;
+#else
+			if(ZEND_CONSTANT_MODULE_NUMBER(c) != module || Z_TYPE(c->value) != IS_ARRAY) continue;
+#endif
+			persistent_free(&c->value);
+			ZVAL_NULL(&c->value);
+		} ZEND_HASH_FOREACH_END();
 		return ZEND_RESULT_CODE::SUCCESS;
 	}
 	int extension_entry::on_request_startup_handler (int type, int module) {
+#ifdef ZTS
+		module_globals_id::cache = tsrm_get_ls_cache();
+#endif
+		++requests_;
+		if(!self->lazy_entries_.empty()) class_entry_base::activate();
 		// 正向调用
 		for(auto i=self->handler_rst_.begin(); i!= self->handler_rst_.end(); ++i) {
 			if(! (*i)(*self) ) return FAILURE;
@@ -133,10 +179,21 @@ namespace php {
 		return ZEND_RESULT_CODE::SUCCESS;
 	}
 	int extension_entry::on_request_shutdown_handler(int type, int module) {
+		int r = ZEND_RESULT_CODE::SUCCESS;
 		// 反向调用
 		for(auto i=self->handler_rsd_.rbegin(); i!= self->handler_rsd_.rend(); ++i) {
-			if(! (*i)(*self) ) return FAILURE;
+			if(! (*i)(*self) ) {
+				r = FAILURE;
+				break;
+			}
 		}
+		// 延迟任务中的 PHP 回调须在执行器关闭前执行
+		deferred::request_shutdown();
+		thread_pool_future::request_shutdown();
+		return r;
+	}
+	int extension_entry::on_request_post_deactivate_handler() {
+		deferred::post_deactivate();
 		return ZEND_RESULT_CODE::SUCCESS;
 	}
 	void extension_entry::on_module_info_handler(zend_module_entry *zend_module) {
@@ -5,21 +5,31 @@
 #include "delegate.h"
 #include "arguments.h"
 #include "class_entry.h"
+#include "module_globals.h"
 
 namespace php {
 	class extension_entry {
 	private:
 		static extension_entry* self;
+#ifdef ZTS
+		static thread_local std::uint64_t requests_;
+#else
+		static std::uint64_t requests_;
+#endif
 		//
 		std::string                                              name_;
 		std::string                                           version_;
 		zend_module_entry                                       entry_;
-		zend_module_dep                                  dependencies_[4];
+		zend_module_dep                                  dependencies_[5];
 		std::vector<std::shared_ptr<ini_entry>>           ini_entries_;
+		std::vector<std::shared_ptr<void>>               ini_bindings_;
+		bool                                           ini_registered_;
+		std::size_t                                           threads_;
 		std::vector<std::shared_ptr<constant_entry>> constant_entries_;
 		std::vector<zend_function_entry>             function_entries_;
 		std::vector<arguments>                              arguments_;
 		std::vector<class_entry_base*>                  class_entries_;
+		std::vector<class_entry_base*>                   lazy_entries_;
 		std::vector<std::pair<std::string, std::string>>  decriptions_;
 
 		std::list<std::function<bool(extension_entry&)>> handler_rsd_;
@@ -30,6 +40,19 @@ namespace php {
 		
 		extension_entry(const std::string& name, const std::string& version);
 		extension_entry& ini(const ini_entry& entry);
+		// 绑定至模块全局数据 T 的字段 (见 ini_entry::bind), 读取时直接访问 globals<T>().field 即可
+		template <class T, class F>
+		extension_entry& ini(const ini_entry& entry, F T::*field) {
+			ini_entries_.emplace_back(new ini_entry(entry));
+			ini_entries_.back()->bind(field);
+			return *this;
+		}
+		template <class T, class F>
+		extension_entry& ini(const ini_entry& entry, F T::*field, std::initializer_list<std::pair<const char*, F>> names) {
+			ini_entries_.emplace_back(new ini_entry(entry));
+			ini_entries_.back()->bind(field, names);
+			return *this;
+		}
 		extension_entry& constant(const constant_entry& entry);
 		// 函数
 		template<value FUNCTION(parameters& params)>
@@ -62,18 +85,52 @@ namespace php {
 			class_entries_.emplace_back(new class_entry<CLASS_TYPE>(std::move(entry)) );
 			return *this;
 		}
+		// 延迟声明的类: 模块启动时仅登记类名, 首次使用时声明 (见 class_entry_base::declare_lazy())
+		template <class CLASS_TYPE>
+		extension_entry& add_lazy(class_entry<CLASS_TYPE>&& entry) {
+			lazy_entries_.emplace_back(new class_entry<CLASS_TYPE>(std::move(entry)) );
+			return *this;
+		}
 		extension_entry& desc(std::pair<std::string, std::string> kv);
+		// 线程池 (thread_pool::global()) 的线程数量: 模块启动时创建, 模块关闭时结束
+		extension_entry& threads(std::size_t n);
+		// 声明模块全局数据类型 T (每个扩展至多一个, 须在返回 zend_module_entry* 之前声明)
+		// NTS: 模块注册时构造, 模块卸载时析构; ZTS: 每个线程一个实例, 随线程创建 / 结束构造与析构
+		// ctor / dtor 分别在 T 构造之后 / 析构之前调用
+		template <class T>
+		extension_entry& declare_globals(std::function<void (T&)> ctor = nullptr, std::function<void (T&)> dtor = nullptr) {
+			module_globals<T>::ctor = ctor;
+			module_globals<T>::dtor = dtor;
+			entry_.globals_size = sizeof(T);
+#ifdef ZTS
+			entry_.globals_id_ptr = &module_globals_id::id;
+#else
+			entry_.globals_ptr = &module_globals<T>::data;
+#endif
+			entry_.globals_ctor = module_globals<T>::on_ctor_handler;
+			entry_.globals_dtor = module_globals<T>::on_dtor_handler;
+			return *this;
+		}
+		// 当前线程的模块全局数据 (NTS 为静态存储的直接访问, ZTS 为缓存的 TSRM 存储下标访问)
+		template <class T>
+		static T& globals() {
+			return module_globals<T>::get();
+		}
 		operator zend_module_entry*();
 		extension_entry& on_module_startup(std::function<bool (extension_entry&)> handler);
 		extension_entry& on_module_shutdown(std::function<bool (extension_entry&)> handler);
 		extension_entry& on_request_startup(std::function<bool (extension_entry&)> handler);
 		extension_entry& on_request_shutdown(std::function<bool (extension_entry&)> handler);
+		// 请求结束后执行的任务见 deferred
+		// 当前线程已开始的请求数量 (请求开始时递增), 用于判断跨请求持有的数据在当前请求中是否可能仍被引用
+		static std::uint64_t request_sequence();
 	private:
 		// 扩展回调函数
 		static int on_module_startup_handler  (int type, int module);
 		static int on_module_shutdown_handler (int type, int module);
 		static int on_request_startup_handler (int type, int module);
 		static int on_request_shutdown_handler(int type, int module);
+		static int on_request_post_deactivate_handler();
 		static void on_module_info_handler(zend_module_entry *zend_module);
 	};
 }
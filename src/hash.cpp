@@ -0,0 +1,325 @@
+#include "vendor.h"
+#include "hash.h"
+#include "exception.h"
+
+namespace php {
+	static const std::uint64_t xxh64_p1 = 0x9E3779B185EBCA87ull;
+	static const std::uint64_t xxh64_p2 = 0xC2B2AE3D27D4EB4Full;
+	static const std::uint64_t xxh64_p3 = 0x165667B19E3779F9ull;
+	static const std::uint64_t xxh64_p4 = 0x85EBCA77C2B2AE63ull;
+	static const std::uint64_t xxh64_p5 = 0x27D4EB2F165667C5ull;
+
+	static inline std::uint64_t hash_rotl(std::uint64_t x, int r) {
+		return (x << r) | (x >> (64 - r));
+	}
+	// 小端序读取
+	static inline std::uint64_t hash_read64(const unsigned char* p) {
+		std::uint64_t v;
+		std::memcpy(&v, p, 8);
+#ifdef WORDS_BIGENDIAN
+		v = __builtin_bswap64(v);
+#endif
+		return v;
+	}
+	static inline std::uint32_t hash_read32(const unsigned char* p) {
+		std::uint32_t v;
+		std::memcpy(&v, p, 4);
+#ifdef WORDS_BIGENDIAN
+		v = __builtin_bswap32(v);
+#endif
+		return v;
+	}
+	// ---------------------------------------------------------------------
+	static inline std::uint64_t xxh64_round(std::uint64_t acc, std::uint64_t input) {
+		acc += input * xxh64_p2;
+		acc = hash_rotl(acc, 31);
+		return acc * xxh64_p1;
+	}
+	static inline std::uint64_t xxh64_merge(std::uint64_t acc, std::uint64_t v) {
+		acc ^= xxh64_round(0, v);
+		return acc * xxh64_p1 + xxh64_p4;
+	}
+	// 处理完整的 32 字节块, 返回处理长度
+	static inline std::size_t xxh64_stripes(std::uint64_t v[4], const unsigned char* p, std::size_t len) {
+		std::size_t n = 0;
+		for(; len - n >= 32; n += 32) {
+			v[0] = xxh64_round(v[0], hash_read64(p + n));
+			v[1] = xxh64_round(v[1], hash_read64(p + n + 8));
+			v[2] = xxh64_round(v[2], hash_read64(p + n + 16));
+			v[3] = xxh64_round(v[3], hash_read64(p + n + 24));
+		}
+		return n;
+	}
+	// 合并累加器、处理剩余 (少于 32 字节) 数据并混合
+	static std::uint64_t xxh64_finish(const std::uint64_t v[4], std::uint64_t seed, std::uint64_t total, const unsigned char* p, std::size_t len) {
+		std::uint64_t h;
+		if(total >= 32) {
+			h = hash_rotl(v[0], 1) + hash_rotl(v[1], 7) + hash_rotl(v[2], 12) + hash_rotl(v[3], 18);
+			h = xxh64_merge(h, v[0]);
+			h = xxh64_merge(h, v[1]);
+			h = xxh64_merge(h, v[2]);
+			h = xxh64_merge(h, v[3]);
+		}else{
+			h = seed + xxh64_p5;
+		}
+		h += total;
+		for(; len >= 8; p += 8, len -= 8) {
+			h ^= xxh64_round(0, hash_read64(p));
+			h = hash_rotl(h, 27) * xxh64_p1 + xxh64_p4;
+		}
+		if(len >= 4) {
+			h ^= static_cast<std::uint64_t>(hash_read32(p)) * xxh64_p1;
+			h = hash_rotl(h, 23) * xxh64_p2 + xxh64_p3;
+			p += 4;
+			len -= 4;
+		}
+		for(; len > 0; ++p, --len) {
+			h ^= *p * xxh64_p5;
+			h = hash_rotl(h, 11) * xxh64_p1;
+		}
+		h ^= h >> 33;
+		h *= xxh64_p2;
+		h ^= h >> 29;
+		h *= xxh64_p3;
+		h ^= h >> 32;
+		return h;
+	}
+	static inline void xxh64_init(std::uint64_t v[4], std::uint64_t seed) {
+		v[0] = seed + xxh64_p1 + xxh64_p2;
+		v[1] = seed + xxh64_p2;
+		v[2] = seed;
+		v[3] = seed - xxh64_p1;
+	}
+	std::uint64_t xxh64(const void* data, std::size_t size, std::uint64_t seed) {
+		const unsigned char* p = reinterpret_cast<const unsigned char*>(data);
+		std::uint64_t v[4];
+		xxh64_init(v, seed);
+		std::size_t n = xxh64_stripes(v, p, size);
+		return xxh64_finish(v, seed, size, p + n, size - n);
+	}
+	std::uint64_t xxh64(const php::string& str, std::uint64_t seed) {
+		return xxh64(str.c_str(), str.size(), seed);
+	}
+	std::uint64_t xxh64(const buffer& buf, std::uint64_t seed) {
+		return buf.size() > 0 ? xxh64(buf.data(), buf.size(), seed) : xxh64(nullptr, 0, seed);
+	}
+	std::uint64_t xxh64(stream_buffer& buf, std::uint64_t seed) {
+		return xxh64(buf.data(), buf.size(), seed);
+	}
+	xxh64_context::xxh64_context(std::uint64_t seed) {
+		reset(seed);
+	}
+	xxh64_context& xxh64_context::update(const void* data, std::size_t size) {
+		const unsigned char* p = reinterpret_cast<const unsigned char*>(data);
+		total_ += size;
+		if(size_ > 0) {
+			std::size_t n = std::min(size, sizeof(tail_) - size_);
+			std::memcpy(tail_ + size_, p, n);
+			size_ += n;
+			p += n;
+			size -= n;
+			if(size_ < sizeof(tail_)) return *this;
+			xxh64_stripes(v_, tail_, sizeof(tail_));
+			size_ = 0;
+		}
+		std::size_t n = xxh64_stripes(v_, p, size);
+		std::memcpy(tail_, p + n, size - n);
+		size_ = size - n;
+		return *this;
+	}
+	xxh64_context& xxh64_context::update(const php::string& str) {
+		return update(str.c_str(), str.size());
+	}
+	xxh64_context& xxh64_context::update(const buffer& buf) {
+		if(buf.size() > 0) update(buf.data(), buf.size());
+		return *this;
+	}
+	xxh64_context& xxh64_context::update(stream_buffer& buf) {
+		return update(buf.data(), buf.size());
+	}
+	std::uint64_t xxh64_context::finalize() const {
+		return xxh64_finish(v_, seed_, total_, tail_, size_);
+	}
+	void xxh64_context::reset(std::uint64_t seed) {
+		seed_ = seed;
+		xxh64_init(v_, seed);
+		total_ = 0;
+		size_ = 0;
+	}
+	// ---------------------------------------------------------------------
+	static const std::uint64_t murmur3_c1 = 0x87c37b91114253d5ull;
+	static const std::uint64_t murmur3_c2 = 0x4cf5ad432745937full;
+
+	static inline std::uint64_t murmur3_fmix(std::uint64_t k) {
+		k ^= k >> 33;
+		k *= 0xff51afd7ed558ccdull;
+		k ^= k >> 33;
+		k *= 0xc4ceb9fe1a85ec53ull;
+		k ^= k >> 33;
+		return k;
+	}
+	static inline std::uint64_t murmur3_k1(std::uint64_t k1) {
+		k1 *= murmur3_c1;
+		k1 = hash_rotl(k1, 31);
+		return k1 * murmur3_c2;
+	}
+	static inline std::uint64_t murmur3_k2(std::uint64_t k2) {
+		k2 *= murmur3_c2;
+		k2 = hash_rotl(k2, 33);
+		return k2 * murmur3_c1;
+	}
+	// 处理完整的 16 字节块, 返回处理长度
+	static inline std::size_t murmur3_blocks(std::uint64_t& h1, std::uint64_t& h2, const unsigned char* p, std::size_t len) {
+		std::size_t n = 0;
+		for(; len - n >= 16; n += 16) {
+			h1 ^= murmur3_k1(hash_read64(p + n));
+			h1 = hash_rotl(h1, 27);
+			h1 += h2;
+			h1 = h1 * 5 + 0x52dce729;
+			h2 ^= murmur3_k2(hash_read64(p + n + 8));
+			h2 = hash_rotl(h2, 31);
+			h2 += h1;
+			h2 = h2 * 5 + 0x38495ab5;
+		}
+		return n;
+	}
+	static hash128 murmur3_finish(std::uint64_t h1, std::uint64_t h2, std::uint64_t total, const unsigned char* p, std::size_t len) {
+		std::uint64_t k1 = 0, k2 = 0;
+		for(std::size_t i = len; i > 8; --i) k2 = (k2 << 8) | p[i - 1];
+		for(std::size_t i = std::min<std::size_t>(len, 8); i > 0; --i) k1 = (k1 << 8) | p[i - 1];
+		if(len > 8) h2 ^= murmur3_k2(k2);
+		if(len > 0) h1 ^= murmur3_k1(k1);
+		h1 ^= total;
+		h2 ^= total;
+		h1 += h2;
+		h2 += h1;
+		h1 = murmur3_fmix(h1);
+		h2 = murmur3_fmix(h2);
+		h1 += h2;
+		h2 += h1;
+		return hash128 {h1, h2};
+	}
+	hash128 murmur3_128(const void* data, std::size_t size, std::uint32_t seed) {
+		const unsigned char* p = reinterpret_cast<const unsigned char*>(data);
+		std::uint64_t h1 = seed, h2 = seed;
+		std::size_t n = murmur3_blocks(h1, h2, p, size);
+		return murmur3_finish(h1, h2, size, p + n, size - n);
+	}
+	hash128 murmur3_128(const php::string& str, std::uint32_t seed) {
+		return murmur3_128(str.c_str(), str.size(), seed);
+	}
+	hash128 murmur3_128(const buffer& buf, std::uint32_t seed) {
+		return buf.size() > 0 ? murmur3_128(buf.data(), buf.size(), seed) : murmur3_128(nullptr, 0, seed);
+	}
+	hash128 murmur3_128(stream_buffer& buf, std::uint32_t seed) {
+		return murmur3_128(buf.data(), buf.size(), seed);
+	}
+	murmur3_128_context::murmur3_128_context(std::uint32_t seed) {
+		reset(seed);
+	}
+	murmur3_128_context& murmur3_128_context::update(const void* data, std::size_t size) {
+		const unsigned char* p = reinterpret_cast<const unsigned char*>(data);
+		total_ += size;
+		if(size_ > 0) {
+			std::size_t n = std::min(size, sizeof(tail_) - size_);
+			std::memcpy(tail_ + size_, p, n);
+			size_ += n;
+			p += n;
+			size -= n;
+			if(size_ < sizeof(tail_)) return *this;
+			murmur3_blocks(h1_, h2_, tail_, sizeof(tail_));
+			size_ = 0;
+		}
+		std::size_t n = murmur3_blocks(h1_, h2_, p, size);
+		std::memcpy(tail_, p + n, size - n);
+		size_ = size - n;
+		return *this;
+	}
+	murmur3_128_context& murmur3_128_context::update(const php::string& str) {
+		return update(str.c_str(), str.size());
+	}
+	murmur3_128_context& murmur3_128_context::update(const buffer& buf) {
+		if(buf.size() > 0) update(buf.data(), buf.size());
+		return *this;
+	}
+	murmur3_128_context& murmur3_128_context::update(stream_buffer& buf) {
+		return update(buf.data(), buf.size());
+	}
+	hash128 murmur3_128_context::finalize() const {
+		return murmur3_finish(h1_, h2_, total_, tail_, size_);
+	}
+	void murmur3_128_context::reset(std::uint32_t seed) {
+		h1_ = seed;
+		h2_ = seed;
+		total_ = 0;
+		size_ = 0;
+	}
+	// ---------------------------------------------------------------------
+	std::int32_t jump_consistent_hash(std::uint64_t key, std::int32_t buckets) {
+		std::int64_t b = -1, j = 0;
+		while(j < buckets) {
+			b = j;
+			key = key * 2862933555777941757ull + 1;
+			j = static_cast<std::int64_t>((b + 1) * (static_cast<double>(1ll << 31) / static_cast<double>((key >> 33) + 1)));
+		}
+		return static_cast<std::int32_t>(b);
+	}
+	std::int32_t jump_consistent_hash(const char* key, std::size_t len, std::int32_t buckets) {
+		return jump_consistent_hash(xxh64(key, len), buckets);
+	}
+	// ---------------------------------------------------------------------
+	ketama_ring::ketama_ring(std::size_t replicas)
+	: replicas_(replicas) {
+
+	}
+	void ketama_ring::add(const std::string& node, std::uint32_t weight) {
+		for(auto& n : nodes_) {
+			if(n.name == node) {
+				n.weight = weight;
+				build();
+				return;
+			}
+		}
+		nodes_.push_back(node_t {node, weight});
+		build();
+	}
+	void ketama_ring::remove(const std::string& node) {
+		for(auto i=nodes_.begin(); i!=nodes_.end(); ++i) {
+			if(i->name == node) {
+				nodes_.erase(i);
+				build();
+				return;
+			}
+		}
+	}
+	std::size_t ketama_ring::size() const {
+		return nodes_.size();
+	}
+	bool ketama_ring::empty() const {
+		return nodes_.empty();
+	}
+	const std::string& ketama_ring::get(const char* key, std::size_t len) const {
+		if(points_.empty()) throw php::exception(zend_ce_error, "failed to locate node: ring is empty");
+		point_t p {xxh64(key, len), 0};
+		auto i = std::upper_bound(points_.begin(), points_.end(), p);
+		if(i == points_.end()) i = points_.begin(); // 环绕
+		return nodes_[i->node].name;
+	}
+	const std::string& ketama_ring::get(const php::string& key) const {
+		return get(key.c_str(), key.size());
+	}
+	const std::string& ketama_ring::get(const std::string& key) const {
+		return get(key.c_str(), key.size());
+	}
+	void ketama_ring::build() {
+		points_.clear();
+		for(std::uint32_t i=0; i<nodes_.size(); ++i) {
+			// 虚拟节点位置: XXH64(节点名, 序号) 与节点顺序无关, 增删节点时其余节点位置不变
+			std::size_t count = replicas_ * nodes_[i].weight;
+			for(std::size_t j=0; j<count; ++j) {
+				points_.push_back(point_t {xxh64(nodes_[i].name.c_str(), nodes_[i].name.size(), j), i});
+			}
+		}
+		std::sort(points_.begin(), points_.end());
+	}
+}
@@ -0,0 +1,103 @@
+#pragma once
+
+#include "string.h"
+#include "buffer.h"
+#include "stream_buffer.h"
+
+namespace php {
+	// 非加密哈希, 适用于缓存键分片、哈希表等 (不可用于签名)
+	// XXH64 (结果与 xxHash 的 XXH64() 一致)
+	std::uint64_t xxh64(const void* data, std::size_t size, std::uint64_t seed = 0);
+	std::uint64_t xxh64(const string& str, std::uint64_t seed = 0);
+	std::uint64_t xxh64(const buffer& buf, std::uint64_t seed = 0);
+	// 计算可读取数据部分，不消费
+	std::uint64_t xxh64(stream_buffer& buf, std::uint64_t seed = 0);
+	// 增量计算
+	class xxh64_context {
+	public:
+		xxh64_context(std::uint64_t seed = 0);
+		xxh64_context& update(const void* data, std::size_t size);
+		xxh64_context& update(const string& str);
+		xxh64_context& update(const buffer& buf);
+		xxh64_context& update(stream_buffer& buf);
+		// 读取当前哈希值 (不影响继续 update)
+		std::uint64_t finalize() const;
+		void reset(std::uint64_t seed = 0);
+	private:
+		std::uint64_t  seed_;
+		std::uint64_t  v_[4];
+		std::uint64_t  total_;
+		unsigned char  tail_[32];
+		std::size_t    size_; // tail_ 中的数据长度
+	};
+	// 128 位哈希: MurmurHash3 x64_128 (结果与 MurmurHash3_x64_128() 一致, 按小端序输出时 low 在前)
+	struct hash128 {
+		std::uint64_t low;
+		std::uint64_t high;
+
+		bool operator ==(const hash128& h) const {
+			return low == h.low && high == h.high;
+		}
+		bool operator !=(const hash128& h) const {
+			return low != h.low || high != h.high;
+		}
+	};
+	hash128 murmur3_128(const void* data, std::size_t size, std::uint32_t seed = 0);
+	hash128 murmur3_128(const string& str, std::uint32_t seed = 0);
+	hash128 murmur3_128(const buffer& buf, std::uint32_t seed = 0);
+	hash128 murmur3_128(stream_buffer& buf, std::uint32_t seed = 0);
+	class murmur3_128_context {
+	public:
+		murmur3_128_context(std::uint32_t seed = 0);
+		murmur3_128_context& update(const void* data, std::size_t size);
+		murmur3_128_context& update(const string& str);
+		murmur3_128_context& update(const buffer& buf);
+		murmur3_128_context& update(stream_buffer& buf);
+		hash128 finalize() const;
+		void reset(std::uint32_t seed = 0);
+	private:
+		std::uint64_t h1_;
+		std::uint64_t h2_;
+		std::uint64_t total_;
+		unsigned char tail_[16];
+		std::size_t   size_;
+	};
+	// Jump Consistent Hash (Lamping & Veach): 将键映射到 [0, buckets), 桶数量增加时仅约 1/n 的键迁移
+	// 仅适用于桶编号连续、只在末尾增减的场景
+	std::int32_t jump_consistent_hash(std::uint64_t key, std::int32_t buckets);
+	std::int32_t jump_consistent_hash(const char* key, std::size_t len, std::int32_t buckets);
+	// ketama 式一致性哈希环 (虚拟节点, 可加权; 节点位置与键均以 XXH64 计算)
+	// 仅使用 std 容器 (不依赖请求内存), 可作为静态/全局对象跨请求长期持有
+	class ketama_ring {
+	public:
+		// replicas: 权重为 1 的节点在环上的虚拟节点数量
+		ketama_ring(std::size_t replicas = 160);
+		// 添加节点 (已存在时更新权重)
+		void add(const std::string& node, std::uint32_t weight = 1);
+		void remove(const std::string& node);
+		std::size_t size() const;
+		bool empty() const;
+		// 查找键对应的节点 (环为空时抛出异常)
+		const std::string& get(const char* key, std::size_t len) const;
+		const std::string& get(const string& key) const;
+		const std::string& get(const std::string& key) const;
+	private:
+		struct node_t {
+			std::string   name;
+			std::uint32_t weight;
+		};
+		struct point_t {
+			std::uint64_t hash;
+			std::uint32_t node;
+
+			bool operator <(const point_t& p) const {
+				return hash < p.hash;
+			}
+		};
+		std::size_t          replicas_;
+		std::vector<node_t>  nodes_;
+		std::vector<point_t> points_; // 按 hash 排序
+
+		void build();
+	};
+}
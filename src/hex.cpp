@@ -0,0 +1,140 @@
+#include "vendor.h"
+#include "hex.h"
+#include "exception.h"
+#include "simd.h"
+
+namespace php {
+	static const char hex_digits[] = "0123456789abcdef";
+	// 批量函数: 返回已处理的输入长度
+	typedef std::size_t (*bin2hex_fn)(char* dst, const unsigned char* src, std::size_t len);
+	typedef std::size_t (*hex2bin_fn)(char* dst, const char* src, std::size_t len);
+
+	static std::size_t bin2hex_none(char* dst, const unsigned char* src, std::size_t len) {
+		return 0;
+	}
+	static std::size_t hex2bin_none(char* dst, const char* src, std::size_t len) {
+		return 0;
+	}
+#ifdef PHPEXT_SIMD_X86
+	// 高低半字节分别查表后交错
+	PHPEXT_TARGET("ssse3")
+	static std::size_t bin2hex_ssse3(char* dst, const unsigned char* src, std::size_t len) {
+		const __m128i lut = _mm_loadu_si128(reinterpret_cast<const __m128i*>(hex_digits));
+		const __m128i mask = _mm_set1_epi8(0x0f);
+		std::size_t n = 0;
+		for(; len - n >= 16; n += 16, dst += 32) {
+			__m128i in = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + n));
+			__m128i hi = _mm_shuffle_epi8(lut, _mm_and_si128(_mm_srli_epi16(in, 4), mask));
+			__m128i lo = _mm_shuffle_epi8(lut, _mm_and_si128(in, mask));
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(dst), _mm_unpacklo_epi8(hi, lo));
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(dst + 16), _mm_unpackhi_epi8(hi, lo));
+		}
+		return n;
+	}
+	PHPEXT_TARGET("avx2")
+	static std::size_t bin2hex_avx2(char* dst, const unsigned char* src, std::size_t len) {
+		const __m256i lut = _mm256_broadcastsi128_si256(_mm_loadu_si128(reinterpret_cast<const __m128i*>(hex_digits)));
+		const __m256i mask = _mm256_set1_epi8(0x0f);
+		std::size_t n = 0;
+		for(; len - n >= 32; n += 32, dst += 64) {
+			__m256i in = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + n));
+			__m256i hi = _mm256_shuffle_epi8(lut, _mm256_and_si256(_mm256_srli_epi16(in, 4), mask));
+			__m256i lo = _mm256_shuffle_epi8(lut, _mm256_and_si256(in, mask));
+			// 交错操作在通道内进行, 需要重新排列通道
+			__m256i a = _mm256_unpacklo_epi8(hi, lo);
+			__m256i b = _mm256_unpackhi_epi8(hi, lo);
+			_mm256_storeu_si256(reinterpret_cast<__m256i*>(dst), _mm256_permute2x128_si256(a, b, 0x20));
+			_mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + 32), _mm256_permute2x128_si256(a, b, 0x31));
+		}
+		return n + bin2hex_ssse3(dst, src + n, len - n);
+	}
+	// 将 16 个十六进制字符转换为数值 (0 ~ 15), 存在非法字符时 valid 返回 false
+	PHPEXT_TARGET("ssse3")
+	static inline __m128i hex2bin_nibbles(__m128i c, bool& valid) {
+		const __m128i d = _mm_sub_epi8(c, _mm_set1_epi8('0'));
+		const __m128i l = _mm_sub_epi8(_mm_or_si128(c, _mm_set1_epi8(0x20)), _mm_set1_epi8('a'));
+		const __m128i is_d = _mm_cmpeq_epi8(_mm_min_epu8(d, _mm_set1_epi8(9)), d);
+		const __m128i is_l = _mm_cmpeq_epi8(_mm_min_epu8(l, _mm_set1_epi8(5)), l);
+		valid = _mm_movemask_epi8(_mm_or_si128(is_d, is_l)) == 0xFFFF;
+		return _mm_or_si128(_mm_and_si128(is_d, d), _mm_and_si128(is_l, _mm_add_epi8(l, _mm_set1_epi8(10))));
+	}
+	PHPEXT_TARGET("ssse3")
+	static std::size_t hex2bin_ssse3(char* dst, const char* src, std::size_t len) {
+		const __m128i mul = _mm_set1_epi16(0x0110); // 高位 * 16 + 低位
+		std::size_t n = 0;
+		for(; len - n >= 32; n += 32, dst += 16) {
+			bool v0, v1;
+			__m128i a = hex2bin_nibbles(_mm_loadu_si128(reinterpret_cast<const __m128i*>(src + n)), v0);
+			__m128i b = hex2bin_nibbles(_mm_loadu_si128(reinterpret_cast<const __m128i*>(src + n + 16)), v1);
+			if(!v0 || !v1) break;
+			a = _mm_maddubs_epi16(a, mul);
+			b = _mm_maddubs_epi16(b, mul);
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(dst), _mm_packus_epi16(a, b));
+		}
+		return n;
+	}
+#endif
+	static bin2hex_fn bin2hex_select() {
+#ifdef PHPEXT_SIMD_X86
+		if(cpu_support(cpu_feature::AVX2)) return bin2hex_avx2;
+		if(cpu_support(cpu_feature::SSSE3)) return bin2hex_ssse3;
+#endif
+		return bin2hex_none;
+	}
+	static hex2bin_fn hex2bin_select() {
+#ifdef PHPEXT_SIMD_X86
+		if(cpu_support(cpu_feature::SSSE3)) return hex2bin_ssse3;
+#endif
+		return hex2bin_none;
+	}
+	static inline int hex2bin_nibble(unsigned char c) {
+		if(c >= '0' && c <= '9') return c - '0';
+		c |= 0x20;
+		if(c >= 'a' && c <= 'f') return c - 'a' + 10;
+		return -1;
+	}
+	std::size_t bin2hex_to(char* dst, const unsigned char* src, std::size_t len) {
+		static bin2hex_fn fn = bin2hex_select();
+		std::size_t n = fn(dst, src, len);
+		for(char* out = dst + 2 * n; n < len; ++n) {
+			*out++ = hex_digits[src[n] >> 4];
+			*out++ = hex_digits[src[n] & 0x0f];
+		}
+		return 2 * len;
+	}
+	void bin2hex_to(buffer& dst, const unsigned char* src, std::size_t len) {
+		char* p = dst.prepare(2 * len);
+		dst.commit(bin2hex_to(p, src, len));
+	}
+	php::string bin2hex(const unsigned char* old, std::size_t len) {
+		php::string str(2 * len);
+		bin2hex_to(str.data(), old, len);
+		return str;
+	}
+	std::size_t hex2bin_to(char* dst, const char* src, std::size_t len) {
+		static hex2bin_fn fn = hex2bin_select();
+		len &= ~std::size_t(1);
+		std::size_t n = fn(dst, src, len);
+		for(char* out = dst + n / 2; n < len; n += 2) {
+			int h = hex2bin_nibble(src[n]), l = hex2bin_nibble(src[n + 1]);
+			if(h < 0 || l < 0) {
+				throw exception(zend_ce_error, "invalid hex string");
+			}
+			*out++ = static_cast<char>((h << 4) | l);
+		}
+		return len / 2;
+	}
+	void hex2bin_to(buffer& dst, const char* src, std::size_t len) {
+		char* p = dst.prepare(len / 2);
+		dst.commit(hex2bin_to(p, src, len));
+	}
+	std::size_t hex2bin_inplace(char* str, std::size_t len) {
+		// 输出位置始终不超过已读取位置
+		return hex2bin_to(str, str, len);
+	}
+	php::string php_hex2bin(const unsigned char* old, const size_t len) {
+		php::string s(len / 2);
+		hex2bin_to(s.data(), reinterpret_cast<const char*>(old), len);
+		return s;
+	}
+}
@@ -0,0 +1,18 @@
+#pragma once
+
+#include "string.h"
+#include "buffer.h"
+
+namespace php {
+	// 编码为小写十六进制写入 dst (至少 2 * len 空间), 返回写入长度
+	std::size_t bin2hex_to(char* dst, const unsigned char* src, std::size_t len);
+	void bin2hex_to(buffer& dst, const unsigned char* src, std::size_t len);
+	string bin2hex(const unsigned char* old, std::size_t len);
+	// 解码十六进制 (大小写均可) 写入 dst (至少 len / 2 空间), 返回写入长度
+	// 存在非法字符时抛出异常; 奇数长度时忽略最后一个字符
+	std::size_t hex2bin_to(char* dst, const char* src, std::size_t len);
+	void hex2bin_to(buffer& dst, const char* src, std::size_t len);
+	// 原地解码, 返回解码后长度
+	std::size_t hex2bin_inplace(char* str, std::size_t len);
+	string php_hex2bin(const unsigned char* old, const size_t len);
+}
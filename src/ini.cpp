@@ -26,10 +26,11 @@ namespace php {
 	}
 	std::int64_t ini::calc() {
 		std::int64_t size = zend_ini_long(const_cast<char *>(key_.data()), key_.length(), 0);
-		std::string  val_ = static_cast<std::string>(*this);
-		std::size_t npos = val_.find_last_not_of(' ');
-		if(npos != val_.npos) {
-			switch(val_[npos]) {
+		const char*  val = data();
+		std::size_t  len = val ? std::strlen(val) : 0;
+		while(len > 0 && val[len - 1] == ' ') --len;
+		if(len > 0) {
+			switch(val[len - 1]) {
 			case 't':
 			case 'T':
 				size *= 1024;
@@ -1,19 +1,90 @@
 #include "vendor.h"
 #include "ini_entry.h"
+#include "ascii.h"
+#include "numeric.h"
 
 namespace php {
 	ini_entry::ini_entry(const php::string& name, const php::value& val)
 	: key_(name)
-	, val_(val) {
+	, val_(val)
+	, on_modify_(nullptr) {
 		val_.to_string();
 	}
 	void ini_entry::fill(zend_ini_entry_def* entry) {
 		std::memset(entry, 0, sizeof(zend_ini_entry_def));
 		entry->name            = key_.c_str();
 		entry->name_length     = key_.length();
-		// 未实现 modify_handler 进行实时的数据映射
+		// 绑定字段时由 on_modify 进行实时的数据映射
+		entry->on_modify       = on_modify_;
+		entry->mh_arg1         = binding_.get();
 		entry->value           = val_.c_str();
 		entry->value_length    = val_.length();
 		entry->modifiable      = ZEND_INI_ALL;
 	}
+	std::shared_ptr<void> ini_entry::binding() const {
+		return binding_;
+	}
+	bool ini_entry::parse_name(const char* str, std::size_t len, const char* name) {
+		return ascii_iequal(str, len, name, std::strlen(name));
+	}
+	bool ini_entry::parse(const char* str, std::size_t len, bool& v) {
+		// INI 解析器已将 On / Off 等常量转换为 "1" / ""
+		if(len == 0 || parse_name(str, len, "off")
+			|| parse_name(str, len, "no") || parse_name(str, len, "false") || parse_name(str, len, "none")) {
+			v = false;
+			return true;
+		}
+		if(parse_name(str, len, "on") || parse_name(str, len, "yes") || parse_name(str, len, "true")) {
+			v = true;
+			return true;
+		}
+		// 数值同 zend_ini_parse_bool(): atoi() != 0 (如 "2" 为真, "00" 为假)
+		const char* p = str, * e = str + len;
+		while(p < e && (*p == ' ' || (*p >= '\t' && *p <= '\r'))) ++p;
+		if(p < e && (*p == '+' || *p == '-')) ++p;
+		if(p == e || *p < '0' || *p > '9') return false;
+		v = static_cast<int>(parse_integer_prefix(str, len, 10)) != 0;
+		return true;
+	}
+	bool ini_entry::parse(const char* str, std::size_t len, int& v) {
+		std::int64_t i;
+		if(!parse_integer(str, len, i) || i < std::numeric_limits<int>::min() || i > std::numeric_limits<int>::max()) return false;
+		v = static_cast<int>(i);
+		return true;
+	}
+	bool ini_entry::parse(const char* str, std::size_t len, std::int64_t& v) {
+		return parse_integer(str, len, v);
+	}
+	bool ini_entry::parse(const char* str, std::size_t len, std::size_t& v) {
+		int shift = 0;
+		if(len > 0) {
+			switch(str[len - 1]) {
+			case 'g':
+			case 'G':
+				shift = 30;
+				break;
+			case 'm':
+			case 'M':
+				shift = 20;
+				break;
+			case 'k':
+			case 'K':
+				shift = 10;
+				break;
+			}
+		}
+		std::int64_t i;
+		if(!parse_integer(str, shift > 0 ? len - 1 : len, i) || i < 0
+			|| static_cast<std::uint64_t>(i) > (std::numeric_limits<std::size_t>::max() >> shift)) return false;
+		v = static_cast<std::size_t>(i) << shift;
+		return true;
+	}
+	bool ini_entry::parse(const char* str, std::size_t len, double& v) {
+		return parse_float(str, len, v);
+	}
+	bool ini_entry::parse(const char* str, std::size_t len, ini_string_view& v) {
+		v.data = str;
+		v.size = len;
+		return true;
+	}
 }
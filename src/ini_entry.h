@@ -1,14 +1,81 @@
 #pragma once
 
 #include "string.h"
+#include "module_globals.h"
 
 namespace php {
+	// INI 字符串值的视图: 数据由 INI 项持有, 值修改 (ini_set() / 请求结束时恢复) 时随之更新
+	struct ini_string_view {
+		const char* data;
+		std::size_t size;
+	};
 	class ini_entry {
 	public:
-		ini_entry(const string& name, const value& val);		
+		ini_entry(const string& name, const value& val);
+		// 绑定至模块全局数据 (extension_entry::declare_globals<T>()) 的字段, 值在 on_modify 中校验并写入:
+		// bool: on / yes / true 或 off / no / false / none / 空, 数值同 atoi() != 0
+		// int / std::int64_t: 十进制整数; std::size_t: 非负整数, 可带 K / M / G 单位 (同 ini::calc())
+		// double: 十进制浮点数; ini_string_view: 原始字符串
+		// 不合法的值被拒绝 (ini_set() 返回 false; php.ini 中的值回退为默认值)
+		template <class T, class F>
+		ini_entry& bind(F T::*field) {
+			std::shared_ptr<field_binding<T, F>> b = std::make_shared<field_binding<T, F>>();
+			b->field = field;
+			binding_ = b;
+			on_modify_ = field_binding<T, F>::on_modify;
+			return *this;
+		}
+		// 枚举: 名称 (不区分大小写) 映射为对应的值
+		template <class T, class F>
+		ini_entry& bind(F T::*field, std::initializer_list<std::pair<const char*, F>> names) {
+			std::shared_ptr<enum_binding<T, F>> b = std::make_shared<enum_binding<T, F>>();
+			b->field = field;
+			b->names.assign(names.begin(), names.end());
+			binding_ = b;
+			on_modify_ = enum_binding<T, F>::on_modify;
+			return *this;
+		}
 		void fill(zend_ini_entry_def* entry);
+		// 绑定数据 (on_modify 的 mh_arg1), 须在 INI 项注册期间保持有效
+		std::shared_ptr<void> binding() const;
 	private:
 		string key_;
 		string val_;
+		std::shared_ptr<void> binding_;
+		int (*on_modify_)(zend_ini_entry* entry, zend_string* value, void* mh_arg1, void* mh_arg2, void* mh_arg3, int stage);
+
+		template <class T, class F>
+		struct field_binding {
+			F T::*field;
+			static int on_modify(zend_ini_entry* entry, zend_string* value, void* mh_arg1, void* mh_arg2, void* mh_arg3, int stage) {
+				F v;
+				if(!value || !parse(ZSTR_VAL(value), ZSTR_LEN(value), v)) return FAILURE;
+				module_globals<T>::get().*(static_cast<field_binding*>(mh_arg1)->field) = v;
+				return SUCCESS;
+			}
+		};
+		template <class T, class F>
+		struct enum_binding {
+			F T::*field;
+			std::vector<std::pair<const char*, F>> names;
+			static int on_modify(zend_ini_entry* entry, zend_string* value, void* mh_arg1, void* mh_arg2, void* mh_arg3, int stage) {
+				enum_binding* b = static_cast<enum_binding*>(mh_arg1);
+				if(!value) return FAILURE;
+				for(auto i=b->names.begin(); i!=b->names.end(); ++i) {
+					if(parse_name(ZSTR_VAL(value), ZSTR_LEN(value), i->first)) {
+						module_globals<T>::get().*(b->field) = i->second;
+						return SUCCESS;
+					}
+				}
+				return FAILURE;
+			}
+		};
+		static bool parse(const char* str, std::size_t len, bool& v);
+		static bool parse(const char* str, std::size_t len, int& v);
+		static bool parse(const char* str, std::size_t len, std::int64_t& v);
+		static bool parse(const char* str, std::size_t len, std::size_t& v);
+		static bool parse(const char* str, std::size_t len, double& v);
+		static bool parse(const char* str, std::size_t len, ini_string_view& v);
+		static bool parse_name(const char* str, std::size_t len, const char* name);
 	};
 }
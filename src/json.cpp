@@ -0,0 +1,486 @@
+#include "vendor.h"
+#include "json.h"
+#include "exception.h"
+#include "util.h"
+#include "simd.h"
+
+namespace php {
+	static const char json_digits[] = "0123456789abcdef";
+	static const char json_digit_pairs[] =
+		"00010203040506070809101112131415161718192021222324252627282930313233343536373839"
+		"40414243444546474849505152535455565758596061626364656667686970717273747576777879"
+		"8081828384858687888990919293949596979899";
+	// 批量扫描: 返回起始处无需处理的字节长度 (仅处理完整的块)
+	// 需处理的字符: 控制字符、'"'、'\\'、'/' 以及非 ASCII 字符 (跳过 UTF-8 校验时仅 0xE2, 即 U+2028 / U+2029 的首字节)
+	typedef std::size_t (*json_scan_fn)(const unsigned char* s, std::size_t len, bool utf8);
+
+	static inline bool json_plain(unsigned char c, bool utf8) {
+		return c >= 0x20 && c != '"' && c != '\\' && c != '/' && (utf8 ? c != 0xE2 : c < 0x80);
+	}
+	static std::size_t json_scan_none(const unsigned char* s, std::size_t len, bool utf8) {
+		return 0;
+	}
+#ifdef PHPEXT_SIMD_X86
+	PHPEXT_TARGET("sse2")
+	static std::size_t json_scan_sse2(const unsigned char* s, std::size_t len, bool utf8) {
+		const __m128i ctrl = _mm_set1_epi8(0x1f);
+		std::size_t n = 0;
+		for(; len - n >= 16; n += 16) {
+			__m128i c = _mm_loadu_si128(reinterpret_cast<const __m128i*>(s + n));
+			__m128i m = _mm_cmpeq_epi8(_mm_min_epu8(c, ctrl), c);
+			m = _mm_or_si128(m, _mm_cmpeq_epi8(c, _mm_set1_epi8('"')));
+			m = _mm_or_si128(m, _mm_cmpeq_epi8(c, _mm_set1_epi8('\\')));
+			m = _mm_or_si128(m, _mm_cmpeq_epi8(c, _mm_set1_epi8('/')));
+			// 非 ASCII 字符的最高位即可直接作为掩码
+			m = utf8 ? _mm_or_si128(m, _mm_cmpeq_epi8(c, _mm_set1_epi8(static_cast<char>(0xE2)))) : _mm_or_si128(m, c);
+			int mask = _mm_movemask_epi8(m);
+			if(mask) return n + __builtin_ctz(mask);
+		}
+		return n;
+	}
+	PHPEXT_TARGET("avx2")
+	static std::size_t json_scan_avx2(const unsigned char* s, std::size_t len, bool utf8) {
+		const __m256i ctrl = _mm256_set1_epi8(0x1f);
+		std::size_t n = 0;
+		for(; len - n >= 32; n += 32) {
+			__m256i c = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(s + n));
+			__m256i m = _mm256_cmpeq_epi8(_mm256_min_epu8(c, ctrl), c);
+			m = _mm256_or_si256(m, _mm256_cmpeq_epi8(c, _mm256_set1_epi8('"')));
+			m = _mm256_or_si256(m, _mm256_cmpeq_epi8(c, _mm256_set1_epi8('\\')));
+			m = _mm256_or_si256(m, _mm256_cmpeq_epi8(c, _mm256_set1_epi8('/')));
+			m = utf8 ? _mm256_or_si256(m, _mm256_cmpeq_epi8(c, _mm256_set1_epi8(static_cast<char>(0xE2)))) : _mm256_or_si256(m, c);
+			std::uint32_t mask = _mm256_movemask_epi8(m);
+			if(mask) return n + __builtin_ctz(mask);
+		}
+		return n + json_scan_sse2(s + n, len - n, utf8);
+	}
+#endif
+	static json_scan_fn json_scan_select() {
+#ifdef PHPEXT_SIMD_X86
+		if(cpu_support(cpu_feature::AVX2)) return json_scan_avx2;
+		if(cpu_support(cpu_feature::SSE2)) return json_scan_sse2;
+#endif
+		return json_scan_none;
+	}
+	// 校验并读取一个非 ASCII 的 UTF-8 字符 (规则同 php_next_utf8_char), 返回字节数, 非法时返回 0
+	static inline std::size_t json_utf8_char(const unsigned char* s, std::size_t len, std::uint32_t& cp) {
+		unsigned char c = s[0];
+		if(c < 0xc2) return 0;
+		if(c < 0xe0) {
+			if(len < 2 || (s[1] & 0xc0) != 0x80) return 0;
+			cp = ((c & 0x1f) << 6) | (s[1] & 0x3f);
+			return 2;
+		}
+		if(c < 0xf0) {
+			if(len < 3 || (s[1] & 0xc0) != 0x80 || (s[2] & 0xc0) != 0x80) return 0;
+			cp = ((c & 0x0f) << 12) | ((s[1] & 0x3f) << 6) | (s[2] & 0x3f);
+			if(cp < 0x800 || (cp >= 0xd800 && cp <= 0xdfff)) return 0;
+			return 3;
+		}
+		if(c < 0xf5) {
+			if(len < 4 || (s[1] & 0xc0) != 0x80 || (s[2] & 0xc0) != 0x80 || (s[3] & 0xc0) != 0x80) return 0;
+			cp = ((c & 0x07) << 18) | ((s[1] & 0x3f) << 12) | ((s[2] & 0x3f) << 6) | (s[3] & 0x3f);
+			if(cp < 0x10000 || cp > 0x10ffff) return 0;
+			return 4;
+		}
+		return 0;
+	}
+	// 整数格式化 (两位一组查表), 返回写入长度 (最多 20 字节)
+	static inline std::size_t json_format_long(char* dst, zend_long v) {
+		char tmp[24], *p = tmp + sizeof(tmp);
+		zend_ulong u = v < 0 ? 0 - static_cast<zend_ulong>(v) : static_cast<zend_ulong>(v);
+		while(u >= 100) {
+			p -= 2;
+			std::memcpy(p, json_digit_pairs + (u % 100) * 2, 2);
+			u /= 100;
+		}
+		if(u >= 10) {
+			p -= 2;
+			std::memcpy(p, json_digit_pairs + u * 2, 2);
+		}else{
+			*--p = static_cast<char>('0' + u);
+		}
+		if(v < 0) *--p = '-';
+		std::size_t n = tmp + sizeof(tmp) - p;
+		std::memcpy(dst, p, n);
+		return n;
+	}
+	// 递归保护 (与 ext/json 相同的标记方式), 返回 false 表示发生了递归
+	static inline bool json_protect(HashTable* ht, bool& protect) {
+#if PHP_VERSION_ID < 70300
+		protect = ZEND_HASH_APPLY_PROTECTION(ht);
+		if(protect && ZEND_HASH_GET_APPLY_COUNT(ht) > 0) return false;
+		if(protect) ZEND_HASH_INC_APPLY_COUNT(ht);
+#else
+		protect = !(GC_FLAGS(ht) & GC_IMMUTABLE);
+		if(protect && GC_IS_RECURSIVE(ht)) return false;
+		if(protect) GC_PROTECT_RECURSION(ht);
+#endif
+		return true;
+	}
+	static inline void json_unprotect(HashTable* ht, bool protect) {
+		if(!protect) return;
+#if PHP_VERSION_ID < 70300
+		ZEND_HASH_DEC_APPLY_COUNT(ht);
+#else
+		GC_UNPROTECT_RECURSION(ht);
+#endif
+	}
+	// 同 php_json_determine_array_type()
+	static inline bool json_is_list(HashTable* ht) {
+		if(zend_hash_num_elements(ht) == 0 || (HT_IS_PACKED(ht) && HT_IS_WITHOUT_HOLES(ht))) {
+			return true;
+		}
+		zend_string* key;
+		zend_ulong   index, idx = 0;
+		ZEND_HASH_FOREACH_KEY(ht, index, key) {
+			if(key || index != idx) return false;
+			++idx;
+		} ZEND_HASH_FOREACH_END();
+		return true;
+	}
+	// 直接遍历 zval 写入 smart_str
+	// 递归检查仅针对对象与经由引用到达的数组 (普通数组为值类型, 不经过引用或对象无法构成环)
+	class json_encoder {
+	public:
+		json_encoder(smart_str* str, int flags)
+		: str_(str)
+		, flags_(flags)
+		, depth_(0)
+		, max_depth_(JSON_G(encode_max_depth))
+		, precision_(PG(serialize_precision))
+		, error_(PHP_JSON_ERROR_NONE) {
+
+		}
+		bool encode(zval* val, bool ref = false) {
+again:
+			switch(Z_TYPE_P(val)) {
+			case IS_NULL:
+				smart_str_appendl(str_, "null", 4);
+				return true;
+			case IS_TRUE:
+				smart_str_appendl(str_, "true", 4);
+				return true;
+			case IS_FALSE:
+				smart_str_appendl(str_, "false", 5);
+				return true;
+			case IS_LONG:
+				encode_long(Z_LVAL_P(val));
+				return true;
+			case IS_DOUBLE:
+				return encode_double(Z_DVAL_P(val));
+			case IS_STRING:
+				return encode_string(Z_STR_P(val));
+			case IS_OBJECT:
+				if(instanceof_function(Z_OBJCE_P(val), php_json_serializable_ce)) {
+					return encode_serializable(val);
+				}
+				return encode_array(val, true);
+			case IS_ARRAY:
+				return encode_array(val, ref);
+			case IS_REFERENCE:
+				val = Z_REFVAL_P(val);
+				ref = true;
+				goto again;
+			default:
+				error_ = PHP_JSON_ERROR_UNSUPPORTED_TYPE;
+				return false;
+			}
+		}
+		php_json_error_code error() const {
+			return error_;
+		}
+	private:
+		smart_str*          str_;
+		int                 flags_;
+		int                 depth_;
+		int                 max_depth_;
+		zend_long           precision_;
+		php_json_error_code error_;
+
+		// 确保输出位置 out 之后至少有 size 空间 (可能重新分配)
+		char* ensure(char* out, std::size_t size) {
+			std::size_t used = out - ZSTR_VAL(str_->s);
+			if(used + size >= str_->a) {
+				ZSTR_LEN(str_->s) = used;
+				smart_str_alloc(str_, size, 0);
+				out = ZSTR_VAL(str_->s) + used;
+			}
+			return out;
+		}
+	public:
+		void encode_long(zend_long v) {
+			smart_str_alloc(str_, 24, 0);
+			ZSTR_LEN(str_->s) += json_format_long(ZSTR_VAL(str_->s) + ZSTR_LEN(str_->s), v);
+		}
+		bool encode_double(double d) {
+			if(!zend_finite(d) || zend_isnan(d)) {
+				error_ = PHP_JSON_ERROR_INF_OR_NAN;
+				return false;
+			}
+			// 整数值且位数不超过精度时 php_gcvt() 的结果即为整数形式
+			if((precision_ < 0 || precision_ >= 15) && d > -1e15 && d < 1e15
+				&& d == static_cast<double>(static_cast<zend_long>(d))) {
+				if(d == 0 && std::signbit(d)) smart_str_appendl(str_, "-0", 2);
+				else encode_long(static_cast<zend_long>(d));
+				return true;
+			}
+			if(precision_ < 0) { // serialize_precision = -1: 最短往返表示
+				smart_str_alloc(str_, 32, 0);
+				ZSTR_LEN(str_->s) += double_to_chars(ZSTR_VAL(str_->s) + ZSTR_LEN(str_->s), d, DOUBLE_LOWER_E);
+				return true;
+			}
+			char num[ZEND_DOUBLE_MAX_LENGTH];
+			php_gcvt(d, static_cast<int>(precision_), '.', 'e', num);
+			smart_str_appends(str_, num);
+			return true;
+		}
+		bool encode_string(zend_string* str) {
+			bool utf8 = flags_ & JSON_ASSUME_UTF8;
+#ifdef IS_STR_VALID_UTF8
+			utf8 = utf8 || (GC_FLAGS(str) & IS_STR_VALID_UTF8);
+#endif
+			return encode_string(ZSTR_VAL(str), ZSTR_LEN(str), utf8);
+		}
+		// 转义规则同 php_json_escape_string() (PHP_JSON_UNESCAPED_UNICODE)
+		bool encode_string(const char* str, std::size_t len, bool utf8) {
+			static json_scan_fn scan = json_scan_select();
+			if(len == 0) {
+				smart_str_appendl(str_, "\"\"", 2);
+				return true;
+			}
+			const unsigned char* s = reinterpret_cast<const unsigned char*>(str);
+			smart_str_alloc(str_, len + 16, 0);
+			char* out = ZSTR_VAL(str_->s) + ZSTR_LEN(str_->s);
+			*out++ = '"';
+			std::size_t pos = 0;
+			while(pos < len) {
+				std::size_t n = scan(s + pos, len - pos, utf8);
+				while(pos + n < len && json_plain(s[pos + n], utf8)) ++n;
+				out = ensure(out, n + 16);
+				std::memcpy(out, s + pos, n);
+				out += n;
+				pos += n;
+				if(pos == len) break;
+
+				unsigned char c = s[pos];
+				if(c < 0x80) {
+					++pos;
+					out[0] = '\\';
+					switch(c) {
+					case '"':  out[1] = '"';  out += 2; break;
+					case '\\': out[1] = '\\'; out += 2; break;
+					case '/':  out[1] = '/';  out += 2; break;
+					case '\b': out[1] = 'b';  out += 2; break;
+					case '\f': out[1] = 'f';  out += 2; break;
+					case '\n': out[1] = 'n';  out += 2; break;
+					case '\r': out[1] = 'r';  out += 2; break;
+					case '\t': out[1] = 't';  out += 2; break;
+					default:
+						out[1] = 'u';
+						out[2] = '0';
+						out[3] = '0';
+						out[4] = json_digits[c >> 4];
+						out[5] = json_digits[c & 0x0f];
+						out += 6;
+					}
+				}else if(utf8) {
+					// 仅 0xE2 会进入此处
+					if(len - pos >= 3 && s[pos + 1] == 0x80 && (s[pos + 2] == 0xA8 || s[pos + 2] == 0xA9)) {
+						std::memcpy(out, s[pos + 2] == 0xA8 ? "\\u2028" : "\\u2029", 6);
+						out += 6;
+						pos += 3;
+					}else{
+						*out++ = c;
+						++pos;
+					}
+				}else{
+					// 连续的非 ASCII 字符逐个校验
+					do {
+						std::uint32_t cp;
+						std::size_t n = json_utf8_char(s + pos, len - pos, cp);
+						if(n == 0) {
+							ZSTR_LEN(str_->s) = out - ZSTR_VAL(str_->s);
+							error_ = PHP_JSON_ERROR_UTF8;
+							return false;
+						}
+						out = ensure(out, 16);
+						if(cp == 0x2028 || cp == 0x2029) {
+							std::memcpy(out, cp == 0x2028 ? "\\u2028" : "\\u2029", 6);
+							out += 6;
+						}else{
+							std::memcpy(out, s + pos, n);
+							out += n;
+						}
+						pos += n;
+					} while(pos < len && s[pos] >= 0x80);
+				}
+			}
+			*out++ = '"';
+			ZSTR_LEN(str_->s) = out - ZSTR_VAL(str_->s);
+			return true;
+		}
+	private:
+		bool encode_array(zval* val, bool protect) {
+			HashTable* ht;
+			bool object;
+			if(Z_TYPE_P(val) == IS_ARRAY) {
+				ht = Z_ARRVAL_P(val);
+				object = !json_is_list(ht);
+			}else{
+				ht = Z_OBJPROP_P(val);
+				object = true;
+			}
+			bool protected_ = false;
+			if(ht && protect && !json_protect(ht, protected_)) {
+				error_ = PHP_JSON_ERROR_RECURSION;
+				return false;
+			}
+			++depth_;
+			bool r = object ? encode_members(ht, Z_TYPE_P(val) == IS_OBJECT) : encode_elements(ht);
+			if(ht) json_unprotect(ht, protected_);
+			if(!r) return false;
+			// 与 ext/json 一致: 完成内部编码后检查深度
+			if(depth_ > max_depth_) {
+				error_ = PHP_JSON_ERROR_DEPTH;
+				return false;
+			}
+			--depth_;
+			return true;
+		}
+		bool encode_elements(HashTable* ht) {
+			zval* data;
+			bool  comma = false;
+			smart_str_appendc(str_, '[');
+			ZEND_HASH_FOREACH_VAL_IND(ht, data) {
+				if(comma) smart_str_appendc(str_, ',');
+				else comma = true;
+				if(!encode(data)) return false;
+			} ZEND_HASH_FOREACH_END();
+			smart_str_appendc(str_, ']');
+			return true;
+		}
+		bool encode_members(HashTable* ht, bool object) {
+			zend_string* key;
+			zend_ulong   index;
+			zval*        data;
+			bool         comma = false;
+			if(!ht) {
+				smart_str_appendl(str_, "{}", 2);
+				return true;
+			}
+			smart_str_appendc(str_, '{');
+			ZEND_HASH_FOREACH_KEY_VAL_IND(ht, index, key, data) {
+				if(key) {
+					// 跳过 protected / private 属性
+					if(object && ZSTR_LEN(key) > 0 && ZSTR_VAL(key)[0] == '\0') continue;
+					if(comma) smart_str_appendc(str_, ',');
+					else comma = true;
+					if(!encode_string(key)) return false;
+				}else{
+					if(comma) smart_str_appendc(str_, ',');
+					else comma = true;
+					smart_str_appendc(str_, '"');
+					encode_long(static_cast<zend_long>(index));
+					smart_str_appendc(str_, '"');
+				}
+				smart_str_appendc(str_, ':');
+				if(!encode(data)) return false;
+			} ZEND_HASH_FOREACH_END();
+			smart_str_appendc(str_, '}');
+			return true;
+		}
+		// 同 php_json_encode_serializable_object()
+		bool encode_serializable(zval* val) {
+			HashTable* ht = Z_OBJPROP_P(val);
+			bool protected_ = false;
+			if(ht && !json_protect(ht, protected_)) {
+				error_ = PHP_JSON_ERROR_RECURSION;
+				return false;
+			}
+			zval fname, rv;
+			ZVAL_STRING(&fname, "jsonSerialize");
+			if(FAILURE == call_user_function(EG(function_table), val, &fname, &rv, 0, nullptr) || Z_TYPE(rv) == IS_UNDEF) {
+				if(!EG(exception)) {
+					zend_throw_exception_ex(nullptr, 0, "Failed calling %s::jsonSerialize()", ZSTR_VAL(Z_OBJCE_P(val)->name));
+				}
+				zval_ptr_dtor(&fname);
+				if(ht) json_unprotect(ht, protected_);
+				return false;
+			}
+			zval_ptr_dtor(&fname);
+			bool r;
+			if(EG(exception)) {
+				r = false;
+				if(ht) json_unprotect(ht, protected_);
+			}else if(Z_TYPE(rv) == IS_OBJECT && Z_OBJ(rv) == Z_OBJ_P(val)) {
+				// return $this;
+				if(ht) json_unprotect(ht, protected_);
+				r = encode_array(&rv, true);
+			}else{
+				r = encode(&rv);
+				if(ht) json_unprotect(ht, protected_);
+			}
+			zval_ptr_dtor(&rv);
+			return r;
+		}
+	};
+	static bool json_encode_ex(smart_str* str, zval* val, int flags) {
+		std::size_t checkpoint = str->s ? ZSTR_LEN(str->s) : 0;
+		json_encoder encoder(str, flags);
+		bool r = encoder.encode(val);
+		JSON_G(error_code) = encoder.error();
+		if(!r && str->s) {
+			ZSTR_LEN(str->s) = checkpoint;
+		}
+		return r;
+	}
+	php::string json_encode(const php::value& val, int flags) {
+		smart_str str {nullptr, 0};
+		if(!json_encode_ex(&str, val, flags)) {
+			smart_str_free(&str);
+			php::exception::rethrow();
+			return nullptr;
+		}
+		return &str;
+	}
+	void json_encode_to(smart_str* str, const php::value& val, int flags) {
+		if(!json_encode_ex(str, val, flags)) {
+			php::exception::rethrow();
+		}
+	}
+	bool json_encode_string_to(smart_str* str, const char* s, std::size_t len, int flags) {
+		std::size_t checkpoint = str->s ? ZSTR_LEN(str->s) : 0;
+		json_encoder encoder(str, flags);
+		if(encoder.encode_string(s, len, flags & JSON_ASSUME_UTF8)) return true;
+		JSON_G(error_code) = encoder.error();
+		ZSTR_LEN(str->s) = checkpoint;
+		return false;
+	}
+	bool json_encode_double_to(smart_str* str, double d) {
+		json_encoder encoder(str, 0);
+		if(encoder.encode_double(d)) return true;
+		JSON_G(error_code) = encoder.error();
+		return false;
+	}
+	void json_encode_long_to(smart_str* str, std::int64_t v) {
+		json_encoder encoder(str, 0);
+		encoder.encode_long(v);
+	}
+	php::value json_decode(const char* str, std::size_t size) {
+		php::value rv;
+		if(FAILURE == php_json_decode_ex(rv, const_cast<char*>(str), size, PHP_JSON_OBJECT_AS_ARRAY, PHP_JSON_PARSER_DEFAULT_DEPTH)) {
+			php::exception::rethrow();
+			return nullptr;
+		}
+		return rv;
+	}
+	php::value json_decode(const php::string& str) {
+		php::value rv;
+		if(FAILURE == php_json_decode_ex(rv, const_cast<char*>(str.data()), str.size(), PHP_JSON_OBJECT_AS_ARRAY, PHP_JSON_PARSER_DEFAULT_DEPTH)) {
+			php::exception::rethrow();
+			return nullptr;
+		}
+		return rv;
+	}
+}
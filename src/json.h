@@ -0,0 +1,22 @@
+#pragma once
+
+#include "value.h"
+#include "string.h"
+
+namespace php {
+	enum json_flag {
+		JSON_ASSUME_UTF8 = 0x01, // 字符串已确认为合法 UTF-8, 跳过校验 (仍会转义 U+2028 / U+2029)
+	};
+	// 原生编码实现, 输出与 php_json_encode(..., PHP_JSON_UNESCAPED_UNICODE) 一致
+	// 失败时设置 json_last_error() 并返回 null (若 jsonSerialize() 抛出异常则重新抛出)
+	string json_encode(const value& val, int flags = 0);
+	// buffer& -> smart_str*
+	// 失败时写入的数据被撤销
+	void json_encode_to(smart_str* str, const value& val, int flags = 0);
+	// 原生数据直接编码 (无需构造 value), 失败时设置 json_last_error() 并返回 false, 不写入数据
+	bool json_encode_string_to(smart_str* str, const char* s, std::size_t len, int flags = 0);
+	bool json_encode_double_to(smart_str* str, double d);
+	void json_encode_long_to(smart_str* str, std::int64_t v);
+	value json_decode(const char* str, std::size_t size);
+	value json_decode(const string& str);
+}
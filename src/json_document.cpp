@@ -0,0 +1,458 @@
+#include "vendor.h"
+#include "json_document.h"
+#include "exception.h"
+#include "simd.h"
+
+namespace php {
+	// 结构扫描 (stage 1) 的跨块状态
+	struct json_stage1_state {
+		std::uint64_t escaped;   // 上一块末尾的反斜杠转义了本块首字符
+		std::uint64_t in_string; // 上一块结束时位于字符串内 (全 1)
+		std::uint64_t scalar;    // 上一块末尾字符属于标量
+	};
+	// 处理 64 字节块, 返回结构字符及值起始位置的掩码
+	typedef std::uint64_t (*json_block_fn)(const unsigned char* s, json_stage1_state& st);
+
+	static inline bool json_scalar_start(char c) {
+		switch(c) {
+		case '"': case '-': case 't': case 'f': case 'n':
+		case '0': case '1': case '2': case '3': case '4':
+		case '5': case '6': case '7': case '8': case '9':
+			return true;
+		}
+		return false;
+	}
+	static inline bool json_space(char c) {
+		return c == ' ' || c == '\t' || c == '\n' || c == '\r';
+	}
+	// 被转义的字符 (奇数长度的连续反斜杠之后)
+	static inline std::uint64_t json_escaped(std::uint64_t backslash, json_stage1_state& st) {
+		const std::uint64_t even = 0x5555555555555555ull;
+		backslash &= ~st.escaped;
+		std::uint64_t follows = backslash << 1 | st.escaped;
+		std::uint64_t odd_starts = backslash & ~even & ~follows;
+		std::uint64_t even_seqs = odd_starts + backslash;
+		st.escaped = even_seqs < backslash ? 1 : 0; // 进位
+		return (even ^ (even_seqs << 1)) & follows;
+	}
+	static inline std::uint64_t json_prefix_xor(std::uint64_t x) {
+		x ^= x << 1;
+		x ^= x << 2;
+		x ^= x << 4;
+		x ^= x << 8;
+		x ^= x << 16;
+		x ^= x << 32;
+		return x;
+	}
+	// in_string 为引号掩码的前缀异或 (包含起始引号, 不含结束引号)
+	static inline std::uint64_t json_structurals(std::uint64_t quote, std::uint64_t in_string, std::uint64_t space, std::uint64_t op, json_stage1_state& st) {
+		in_string ^= st.in_string;
+		st.in_string = static_cast<std::uint64_t>(static_cast<std::int64_t>(in_string) >> 63);
+		std::uint64_t scalar = ~(op | space);
+		std::uint64_t nonquote = scalar & ~quote;
+		std::uint64_t follows = nonquote << 1 | st.scalar;
+		st.scalar = nonquote >> 63;
+		// 保留起始引号, 去除字符串内部及结束引号
+		return (op | (scalar & ~follows)) & ~(in_string ^ quote);
+	}
+	static std::uint64_t json_block_none(const unsigned char* s, json_stage1_state& st) {
+		std::uint64_t backslash = 0, quote = 0, space = 0, op = 0;
+		for(int i=0;i<64;++i) {
+			std::uint64_t bit = 1ull << i;
+			switch(s[i]) {
+			case '\\': backslash |= bit; break;
+			case '"':  quote |= bit; break;
+			case ' ': case '\t': case '\n': case '\r': space |= bit; break;
+			case '{': case '}': case '[': case ']': case ':': case ',': op |= bit; break;
+			}
+		}
+		quote &= ~json_escaped(backslash, st);
+		return json_structurals(quote, json_prefix_xor(quote), space, op, st);
+	}
+#ifdef PHPEXT_SIMD_X86
+	PHPEXT_TARGET("sse2")
+	static inline std::uint64_t json_eq_sse2(const __m128i (&c)[4], char x) {
+		__m128i v = _mm_set1_epi8(x);
+		return static_cast<std::uint64_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(c[0], v)))
+			| static_cast<std::uint64_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(c[1], v))) << 16
+			| static_cast<std::uint64_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(c[2], v))) << 32
+			| static_cast<std::uint64_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(c[3], v))) << 48;
+	}
+	PHPEXT_TARGET("sse2")
+	static std::uint64_t json_block_sse2(const unsigned char* s, json_stage1_state& st) {
+		const __m128i c[4] = {
+			_mm_loadu_si128(reinterpret_cast<const __m128i*>(s)),
+			_mm_loadu_si128(reinterpret_cast<const __m128i*>(s + 16)),
+			_mm_loadu_si128(reinterpret_cast<const __m128i*>(s + 32)),
+			_mm_loadu_si128(reinterpret_cast<const __m128i*>(s + 48)),
+		};
+		// '[' ']' 与 0x20 按位或后即为 '{' '}'
+		const __m128i l[4] = {
+			_mm_or_si128(c[0], _mm_set1_epi8(0x20)),
+			_mm_or_si128(c[1], _mm_set1_epi8(0x20)),
+			_mm_or_si128(c[2], _mm_set1_epi8(0x20)),
+			_mm_or_si128(c[3], _mm_set1_epi8(0x20)),
+		};
+		std::uint64_t quote = json_eq_sse2(c, '"');
+		std::uint64_t space = json_eq_sse2(c, ' ') | json_eq_sse2(c, '\t') | json_eq_sse2(c, '\n') | json_eq_sse2(c, '\r');
+		std::uint64_t op = json_eq_sse2(l, '{') | json_eq_sse2(l, '}') | json_eq_sse2(c, ':') | json_eq_sse2(c, ',');
+		quote &= ~json_escaped(json_eq_sse2(c, '\\'), st);
+		return json_structurals(quote, json_prefix_xor(quote), space, op, st);
+	}
+	PHPEXT_TARGET("avx2")
+	static inline std::uint64_t json_eq_avx2(__m256i c0, __m256i c1, char x) {
+		__m256i v = _mm256_set1_epi8(x);
+		return static_cast<std::uint32_t>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(c0, v)))
+			| static_cast<std::uint64_t>(static_cast<std::uint32_t>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(c1, v)))) << 32;
+	}
+	PHPEXT_TARGET("avx2,pclmul")
+	static std::uint64_t json_block_avx2(const unsigned char* s, json_stage1_state& st) {
+		__m256i c0 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(s));
+		__m256i c1 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(s + 32));
+		__m256i l0 = _mm256_or_si256(c0, _mm256_set1_epi8(0x20));
+		__m256i l1 = _mm256_or_si256(c1, _mm256_set1_epi8(0x20));
+		std::uint64_t quote = json_eq_avx2(c0, c1, '"');
+		std::uint64_t space = json_eq_avx2(c0, c1, ' ') | json_eq_avx2(c0, c1, '\t') | json_eq_avx2(c0, c1, '\n') | json_eq_avx2(c0, c1, '\r');
+		std::uint64_t op = json_eq_avx2(l0, l1, '{') | json_eq_avx2(l0, l1, '}') | json_eq_avx2(c0, c1, ':') | json_eq_avx2(c0, c1, ',');
+		quote &= ~json_escaped(json_eq_avx2(c0, c1, '\\'), st);
+		// 前缀异或: 与全 1 做无进位乘法
+		std::uint64_t in_string = _mm_cvtsi128_si64(_mm_clmulepi64_si128(
+			_mm_set_epi64x(0, static_cast<std::int64_t>(quote)), _mm_set1_epi8(static_cast<char>(0xFF)), 0));
+		return json_structurals(quote, in_string, space, op, st);
+	}
+#endif
+	static json_block_fn json_block_select() {
+#ifdef PHPEXT_SIMD_X86
+		if(cpu_support(cpu_feature::AVX2) && cpu_support(cpu_feature::PCLMUL)) return json_block_avx2;
+		if(cpu_support(cpu_feature::SSE2)) return json_block_sse2;
+#endif
+		return json_block_none;
+	}
+	// 写入掩码中各位置, 返回写入数量 (dst 至少 64 空间)
+	static inline std::size_t json_flatten(std::uint32_t* dst, std::uint64_t bits, std::uint32_t base) {
+		std::uint32_t* p = dst;
+		while(bits) {
+			*p++ = base + __builtin_ctzll(bits);
+			bits &= bits - 1;
+		}
+		return p - dst;
+	}
+	// 不含转义及控制字符的 ASCII 字符串可直接复制
+	static inline bool json_plain_ascii(const char* s, std::size_t n) {
+		for(std::size_t i=0;i<n;++i) {
+			unsigned char c = s[i];
+			if(c < 0x20 || c >= 0x80 || c == '\\') return false;
+		}
+		return true;
+	}
+
+	json_document::json_document(const string& str, int depth)
+	: str_(str)
+	, depth_(depth) {
+		build();
+	}
+	json_document::json_document(const char* str, std::size_t size, int depth)
+	: str_(str, size)
+	, depth_(depth) {
+		build();
+	}
+	void json_document::build() {
+		static json_block_fn block = json_block_select();
+		const unsigned char* s = reinterpret_cast<const unsigned char*>(str_.c_str());
+		std::size_t len = str_.size(), n = 0;
+		json_stage1_state st {0, 0, 0};
+		if(len < 0xffffffffu) {
+			std::size_t count = 0;
+			idx_.resize(len / 4 + 64);
+			for(; n < len; n += 64) {
+				if(idx_.size() - count < 64) idx_.resize(idx_.size() * 2);
+				if(len - n >= 64) {
+					count += json_flatten(idx_.data() + count, block(s + n, st), n);
+				}else{
+					// 不足一块时以空白填充
+					unsigned char tail[64];
+					std::memset(tail, ' ', sizeof(tail));
+					std::memcpy(tail, s + n, len - n);
+					count += json_flatten(idx_.data() + count, block(tail, st), n);
+				}
+			}
+			idx_.resize(count);
+			idx_.push_back(len); // 哨兵
+		}
+		if(len >= 0xffffffffu || st.in_string || !structure()) {
+			idx_.clear();
+			end_.clear();
+			// 结构无效时由 PHP 解析器给出一致的错误码
+			decode(str_.c_str(), len);
+		}else{
+			JSON_G(error_code) = PHP_JSON_ERROR_NONE;
+		}
+	}
+	// 按下标遍历结构索引, 校验语法并记录括号的配对位置
+	bool json_document::structure() {
+		const char* s = str_.c_str();
+		const std::uint32_t* idx = idx_.data();
+		std::uint32_t n = idx_.size() - 1, i = 0;
+		std::vector<std::uint32_t> stack(depth_ + 1);
+		std::uint32_t* top = stack.data(); // top[0] 为哨兵
+		char c, open = '\0';
+		end_.resize(n);
+VALUE:
+		if(i >= n) return false;
+		c = s[idx[i]];
+		if(c == '{' || c == '[') {
+			if(top - stack.data() >= depth_) return false;
+			*++top = i;
+			open = c;
+			if(++i >= n) return false;
+			if(s[idx[i]] == c + 2) goto CLOSE; // '{' + 2 == '}', '[' + 2 == ']'
+			if(c == '[') goto VALUE;
+			goto KEY;
+		}
+		if(!json_scalar_start(c)) return false;
+		++i;
+NEXT:
+		if(top == stack.data()) return i == n;
+		if(i >= n) return false;
+		c = s[idx[i]];
+		if(c == ',') {
+			if(++i >= n) return false;
+			if(open == '[') goto VALUE;
+			goto KEY;
+		}
+CLOSE:
+		if(s[idx[i]] != open + 2) return false;
+		end_[*top--] = i;
+		open = s[idx[*top]];
+		++i;
+		goto NEXT;
+KEY:
+		if(s[idx[i]] != '"' || ++i >= n || s[idx[i]] != ':') return false;
+		++i;
+		goto VALUE;
+	}
+	bool json_document::valid() const {
+		return !idx_.empty();
+	}
+	char json_document::token(std::uint32_t i) const {
+		return str_.c_str()[idx_[i]];
+	}
+	std::uint32_t json_document::skip(std::uint32_t i) const {
+		char c = token(i);
+		return c == '{' || c == '[' ? end_[i] + 1 : i + 1;
+	}
+	std::size_t json_document::extent(std::uint32_t i) const {
+		char c = token(i);
+		if(c == '{' || c == '[') return idx_[end_[i]] + 1;
+		const char* s = str_.c_str();
+		std::size_t e = idx_[i + 1];
+		while(e > idx_[i] && json_space(s[e - 1])) --e;
+		return e;
+	}
+	value json_document::key(std::uint32_t i) const {
+		const char* s = str_.c_str() + idx_[i];
+		std::size_t n = extent(i) - idx_[i];
+		if(n >= 2 && s[n - 1] == '"' && !std::memchr(s + 1, '\\', n - 2)) {
+			return php::string(s + 1, n - 2);
+		}
+		return decode(s, n);
+	}
+	bool json_document::key_equal(std::uint32_t i, const char* key, std::size_t len) const {
+		const char* s = str_.c_str() + idx_[i];
+		std::size_t n = extent(i) - idx_[i];
+		if(n < 2 || s[n - 1] != '"') return false;
+		if(!std::memchr(s + 1, '\\', n - 2)) {
+			return n - 2 == len && std::memcmp(s + 1, key, len) == 0;
+		}
+		php::value k = decode(s, n);
+		return k.type_of(TYPE::STRING) && k.size() == len && std::memcmp(static_cast<zend_string*>(k)->val, key, len) == 0;
+	}
+	value json_document::decode(const char* str, std::size_t size) const {
+		php::value rv;
+		// PHP 解析器依赖结尾的 '\0', 片段需要复制
+		php::string s = str == str_.c_str() && size == str_.size() ? str_ : php::string(str, size);
+		if(FAILURE == php_json_decode_ex(rv, s.data(), size, PHP_JSON_OBJECT_AS_ARRAY, depth_)) {
+			php::exception::rethrow();
+			return nullptr;
+		}
+		return rv;
+	}
+	json_node json_document::root() const {
+		return valid() ? json_node(this, 0) : json_node();
+	}
+	json_node json_document::operator [](const char* key) const {
+		return root()[key];
+	}
+	json_node json_document::operator [](const string& key) const {
+		return root()[key];
+	}
+	json_node json_document::operator [](std::size_t idx) const {
+		return root()[idx];
+	}
+	json_node json_document::operator [](int idx) const {
+		return root()[idx];
+	}
+	value json_document::to_value() const {
+		return decode(str_.c_str(), str_.size());
+	}
+	// ---------------------------------------------------------------------
+	json_node::json_node()
+	: doc_(nullptr)
+	, i_(0) {
+
+	}
+	json_node::json_node(const json_document* doc, std::uint32_t i)
+	: doc_(doc)
+	, i_(i) {
+
+	}
+	bool json_node::exists() const {
+		return doc_ != nullptr;
+	}
+	json_node::operator bool() const {
+		return doc_ != nullptr;
+	}
+	TYPE json_node::type_of() const {
+		if(!doc_) return TYPE::UNDEFINED;
+		switch(doc_->token(i_)) {
+		case '{':
+		case '[':
+			return TYPE::ARRAY;
+		case '"':
+			return TYPE::STRING;
+		case 't':
+			return TYPE::YES;
+		case 'f':
+			return TYPE::NO;
+		case 'n':
+			return TYPE::NULLABLE;
+		}
+		const char* s = raw();
+		std::size_t n = raw_size();
+		for(std::size_t i=0;i<n;++i) {
+			if(s[i] == '.' || s[i] == 'e' || s[i] == 'E') return TYPE::FLOAT;
+		}
+		return TYPE::INTEGER;
+	}
+	json_node json_node::find(const char* key, std::size_t len) const {
+		if(!doc_ || doc_->token(i_) != '{') return json_node();
+		json_node r;
+		std::uint32_t k = i_ + 1;
+		while(doc_->token(k) == '"') {
+			if(doc_->key_equal(k, key, len)) r = json_node(doc_, k + 2);
+			k = doc_->skip(k + 2);
+			if(doc_->token(k) == ',') ++k;
+		}
+		return r;
+	}
+	json_node json_node::operator [](const char* key) const {
+		return find(key, std::strlen(key));
+	}
+	json_node json_node::operator [](const string& key) const {
+		return find(key.c_str(), key.size());
+	}
+	json_node json_node::operator [](std::size_t idx) const {
+		if(!doc_ || doc_->token(i_) != '[') return json_node();
+		std::uint32_t k = i_ + 1;
+		for(std::size_t n = 0; doc_->token(k) != ']'; ++n) {
+			if(n == idx) return json_node(doc_, k);
+			k = doc_->skip(k);
+			if(doc_->token(k) == ',') ++k;
+		}
+		return json_node();
+	}
+	json_node json_node::operator [](int idx) const {
+		return idx < 0 ? json_node() : (*this)[static_cast<std::size_t>(idx)];
+	}
+	std::size_t json_node::size() const {
+		if(!doc_) return 0;
+		char c = doc_->token(i_);
+		if(c != '{' && c != '[') return 0;
+		std::size_t n = 0;
+		for(std::uint32_t k = i_ + 1; k < doc_->end_[i_]; ++n) {
+			k = doc_->skip(c == '{' ? k + 2 : k);
+			if(doc_->token(k) == ',') ++k;
+		}
+		return n;
+	}
+	const char* json_node::raw() const {
+		return doc_ ? doc_->str_.c_str() + doc_->idx_[i_] : nullptr;
+	}
+	std::size_t json_node::raw_size() const {
+		return doc_ ? doc_->extent(i_) - doc_->idx_[i_] : 0;
+	}
+	value json_node::to_value() const {
+		if(!doc_) return nullptr;
+		const char* s = raw();
+		std::size_t n = raw_size();
+		// 常见简单值不经过 PHP 解析器
+		switch(s[0]) {
+		case 'n':
+			if(n == 4 && std::memcmp(s, "null", 4) == 0) return nullptr;
+			break;
+		case 't':
+			if(n == 4 && std::memcmp(s, "true", 4) == 0) return true;
+			break;
+		case 'f':
+			if(n == 5 && std::memcmp(s, "false", 5) == 0) return false;
+			break;
+		case '"':
+			if(n >= 2 && s[n - 1] == '"' && json_plain_ascii(s + 1, n - 2)) return php::string(s + 1, n - 2);
+			break;
+		}
+		return doc_->decode(s, n);
+	}
+	json_node_iterator json_node::begin() const {
+		if(!doc_) return json_node_iterator(nullptr, 0, false);
+		char c = doc_->token(i_);
+		if(c != '{' && c != '[') return json_node_iterator(doc_, i_, false);
+		return json_node_iterator(doc_, i_ + 1, c == '{');
+	}
+	json_node_iterator json_node::end() const {
+		if(!doc_) return json_node_iterator(nullptr, 0, false);
+		char c = doc_->token(i_);
+		if(c != '{' && c != '[') return json_node_iterator(doc_, i_, false);
+		return json_node_iterator(doc_, doc_->end_[i_], c == '{');
+	}
+	// ---------------------------------------------------------------------
+	json_node_iterator::json_node_iterator(const json_document* doc, std::uint32_t i, bool object)
+	: doc_(doc)
+	, i_(i)
+	, n_(0)
+	, object_(object) {
+
+	}
+	void json_node_iterator::create() {
+		if(object_) {
+			entry_.reset(new value_type {doc_->key(i_), json_node(doc_, i_ + 2)});
+		}else{
+			entry_.reset(new value_type {static_cast<std::int64_t>(n_), json_node(doc_, i_)});
+		}
+	}
+	json_node_iterator& json_node_iterator::operator++() {
+		i_ = doc_->skip(object_ ? i_ + 2 : i_);
+		if(doc_->token(i_) == ',') ++i_;
+		++n_;
+		entry_.reset();
+		return *this;
+	}
+	json_node_iterator json_node_iterator::operator++(int) {
+		json_node_iterator ni = *this;
+		++(*this);
+		return ni;
+	}
+	json_node_iterator::value_type& json_node_iterator::operator*() {
+		if(!entry_) create();
+		return *entry_;
+	}
+	json_node_iterator::value_type* json_node_iterator::operator->() {
+		if(!entry_) create();
+		return entry_.get();
+	}
+	bool json_node_iterator::operator==(const json_node_iterator& ni) const {
+		return doc_ == ni.doc_ && i_ == ni.i_;
+	}
+	bool json_node_iterator::operator!=(const json_node_iterator& ni) const {
+		return doc_ != ni.doc_ || i_ != ni.i_;
+	}
+}
@@ -0,0 +1,103 @@
+#pragma once
+
+#include "value.h"
+#include "string.h"
+
+namespace php {
+	class json_document;
+	class json_node_iterator;
+	// 文档中某个值的只读视图 (不持有数据, 须在 json_document 生命周期内使用)
+	class json_node {
+	public:
+		json_node(); // 不存在的节点
+		// 路径查找失败或文档无效时为 false
+		bool exists() const;
+		operator bool() const;
+		// 按字面判定类型 (不解析): NULLABLE / YES / NO / INTEGER / FLOAT / STRING / ARRAY (对象同样作为 ARRAY)
+		TYPE type_of() const;
+		// 对象按键查找 (重复键时取最后一个, 与 json_decode 一致), 数组按下标查找
+		json_node operator [](const char* key) const;
+		json_node operator [](const string& key) const;
+		json_node operator [](std::size_t idx) const;
+		json_node operator [](int idx) const;
+		// 数组或对象的元素数量 (需遍历当前层级)
+		std::size_t size() const;
+		// 原始 JSON 片段
+		const char* raw() const;
+		std::size_t raw_size() const;
+		// 仅解析当前子树, 结果同 json_decode() (失败时返回 null 并设置 json_last_error())
+		value to_value() const;
+		// 遍历数组或对象: first 为下标或键, second 为元素节点
+		json_node_iterator begin() const;
+		json_node_iterator end() const;
+	private:
+		json_node(const json_document* doc, std::uint32_t i);
+		json_node find(const char* key, std::size_t len) const;
+
+		const json_document* doc_;
+		std::uint32_t        i_; // 结构索引下标
+
+		friend class json_document;
+		friend class json_node_iterator;
+	};
+	class json_node_iterator {
+	public:
+		typedef std::pair<value, json_node> value_type;
+		typedef value_type& reference;
+		typedef value_type* pointer;
+
+		json_node_iterator& operator++();
+		json_node_iterator  operator++(int);
+		value_type& operator*();
+		value_type* operator->();
+		bool operator==(const json_node_iterator& ni) const;
+		bool operator!=(const json_node_iterator& ni) const;
+	private:
+		json_node_iterator(const json_document* doc, std::uint32_t i, bool object);
+		void create();
+
+		const json_document* doc_;
+		std::uint32_t        i_; // 当前元素 (对象为键) 的结构索引下标, 结束时指向闭合符号
+		std::size_t          n_;
+		bool                 object_;
+		std::shared_ptr<value_type> entry_;
+
+		friend class json_node;
+	};
+	// 惰性 JSON 文档: 构建时仅以 SIMD 扫描出结构索引并校验结构 (括号、分隔符、深度),
+	// 标量及字符串内容在物化时校验; 路径查找与遍历只物化访问到的子树
+	class json_document {
+	public:
+		// 结构无效时 valid() 为 false, 并设置与 json_decode() 一致的 json_last_error()
+		json_document(const string& str, int depth = PHP_JSON_PARSER_DEFAULT_DEPTH);
+		json_document(const char* str, std::size_t size, int depth = PHP_JSON_PARSER_DEFAULT_DEPTH);
+		bool valid() const;
+		json_node root() const;
+		json_node operator [](const char* key) const;
+		json_node operator [](const string& key) const;
+		json_node operator [](std::size_t idx) const;
+		json_node operator [](int idx) const;
+		// 完整解析, 同 json_decode()
+		value to_value() const;
+	private:
+		string                     str_;
+		int                        depth_;
+		std::vector<std::uint32_t> idx_; // 结构字符及值起始位置 (末尾为哨兵: 文档长度)
+		std::vector<std::uint32_t> end_; // '{' '[' 对应闭合符号的结构索引下标
+
+		void build();
+		bool structure();
+		char token(std::uint32_t i) const;
+		// 跳过下标 i 处的值, 返回其后的结构索引下标
+		std::uint32_t skip(std::uint32_t i) const;
+		// 下标 i 处值的原始片段结束位置
+		std::size_t extent(std::uint32_t i) const;
+		// 下标 i 处的对象键
+		value key(std::uint32_t i) const;
+		bool key_equal(std::uint32_t i, const char* key, std::size_t len) const;
+		value decode(const char* str, std::size_t size) const;
+
+		friend class json_node;
+		friend class json_node_iterator;
+	};
+}
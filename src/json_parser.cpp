@@ -0,0 +1,503 @@
+#include "vendor.h"
+#include "json_parser.h"
+#include "exception.h"
+#include "numeric.h"
+#include "simd.h"
+
+namespace php {
+	// 批量扫描字符串内容: 返回起始处的普通字节长度 (遇到 '"'、'\\' 或控制字符为止, 仅处理完整的块)
+	typedef std::size_t (*json_string_scan_fn)(const char* s, std::size_t len);
+
+	static inline bool json_string_plain(unsigned char c) {
+		return c >= 0x20 && c != '"' && c != '\\';
+	}
+	static std::size_t json_string_scan_none(const char* s, std::size_t len) {
+		return 0;
+	}
+#ifdef PHPEXT_SIMD_X86
+	PHPEXT_TARGET("sse2")
+	static std::size_t json_string_scan_sse2(const char* s, std::size_t len) {
+		const __m128i ctrl = _mm_set1_epi8(0x1f);
+		std::size_t n = 0;
+		for(; len - n >= 16; n += 16) {
+			__m128i c = _mm_loadu_si128(reinterpret_cast<const __m128i*>(s + n));
+			__m128i m = _mm_cmpeq_epi8(_mm_min_epu8(c, ctrl), c);
+			m = _mm_or_si128(m, _mm_cmpeq_epi8(c, _mm_set1_epi8('"')));
+			m = _mm_or_si128(m, _mm_cmpeq_epi8(c, _mm_set1_epi8('\\')));
+			int mask = _mm_movemask_epi8(m);
+			if(mask) return n + __builtin_ctz(mask);
+		}
+		return n;
+	}
+	PHPEXT_TARGET("avx2")
+	static std::size_t json_string_scan_avx2(const char* s, std::size_t len) {
+		const __m256i ctrl = _mm256_set1_epi8(0x1f);
+		std::size_t n = 0;
+		for(; len - n >= 32; n += 32) {
+			__m256i c = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(s + n));
+			__m256i m = _mm256_cmpeq_epi8(_mm256_min_epu8(c, ctrl), c);
+			m = _mm256_or_si256(m, _mm256_cmpeq_epi8(c, _mm256_set1_epi8('"')));
+			m = _mm256_or_si256(m, _mm256_cmpeq_epi8(c, _mm256_set1_epi8('\\')));
+			std::uint32_t mask = _mm256_movemask_epi8(m);
+			if(mask) return n + __builtin_ctz(mask);
+		}
+		return n + json_string_scan_sse2(s + n, len - n);
+	}
+#endif
+	static json_string_scan_fn json_string_scan_select() {
+#ifdef PHPEXT_SIMD_X86
+		if(cpu_support(cpu_feature::AVX2)) return json_string_scan_avx2;
+		if(cpu_support(cpu_feature::SSE2)) return json_string_scan_sse2;
+#endif
+		return json_string_scan_none;
+	}
+	// UTF-8 校验 (规则同 php_next_utf8_char), ASCII 部分按 8 字节一组跳过
+	static bool json_utf8_valid(const char* str, std::size_t len) {
+		const unsigned char* s = reinterpret_cast<const unsigned char*>(str);
+		std::size_t i = 0;
+		while(i < len) {
+			if(len - i >= 8) {
+				std::uint64_t w;
+				std::memcpy(&w, s + i, 8);
+				if(!(w & 0x8080808080808080ull)) {
+					i += 8;
+					continue;
+				}
+			}
+			unsigned char c = s[i];
+			if(c < 0x80) {
+				++i;
+				continue;
+			}
+			std::uint32_t cp;
+			if(c < 0xc2) return false;
+			if(c < 0xe0) {
+				if(len - i < 2 || (s[i+1] & 0xc0) != 0x80) return false;
+				i += 2;
+			}else if(c < 0xf0) {
+				if(len - i < 3 || (s[i+1] & 0xc0) != 0x80 || (s[i+2] & 0xc0) != 0x80) return false;
+				cp = ((c & 0x0f) << 12) | ((s[i+1] & 0x3f) << 6) | (s[i+2] & 0x3f);
+				if(cp < 0x800 || (cp >= 0xd800 && cp <= 0xdfff)) return false;
+				i += 3;
+			}else if(c < 0xf5) {
+				if(len - i < 4 || (s[i+1] & 0xc0) != 0x80 || (s[i+2] & 0xc0) != 0x80 || (s[i+3] & 0xc0) != 0x80) return false;
+				cp = ((c & 0x07) << 18) | ((s[i+1] & 0x3f) << 12) | ((s[i+2] & 0x3f) << 6) | (s[i+3] & 0x3f);
+				if(cp < 0x10000 || cp > 0x10ffff) return false;
+				i += 4;
+			}else{
+				return false;
+			}
+		}
+		return true;
+	}
+	static inline int json_hex(char c) {
+		if(c >= '0' && c <= '9') return c - '0';
+		if(c >= 'a' && c <= 'f') return c - 'a' + 10;
+		if(c >= 'A' && c <= 'F') return c - 'A' + 10;
+		return -1;
+	}
+	static inline std::size_t json_utf8_encode(char* dst, std::uint32_t cp) {
+		if(cp < 0x80) {
+			dst[0] = static_cast<char>(cp);
+			return 1;
+		}
+		if(cp < 0x800) {
+			dst[0] = static_cast<char>(0xc0 | (cp >> 6));
+			dst[1] = static_cast<char>(0x80 | (cp & 0x3f));
+			return 2;
+		}
+		if(cp < 0x10000) {
+			dst[0] = static_cast<char>(0xe0 | (cp >> 12));
+			dst[1] = static_cast<char>(0x80 | ((cp >> 6) & 0x3f));
+			dst[2] = static_cast<char>(0x80 | (cp & 0x3f));
+			return 3;
+		}
+		dst[0] = static_cast<char>(0xf0 | (cp >> 18));
+		dst[1] = static_cast<char>(0x80 | ((cp >> 12) & 0x3f));
+		dst[2] = static_cast<char>(0x80 | ((cp >> 6) & 0x3f));
+		dst[3] = static_cast<char>(0x80 | (cp & 0x3f));
+		return 4;
+	}
+	static inline bool json_space(char c) {
+		return c == ' ' || c == '\t' || c == '\n' || c == '\r';
+	}
+	// 数字及字面量之后须为空白、',' 或闭合符号 (同 json_decode, 拒绝 "truefalse"、"1true" 等)
+	static inline bool json_delimiter(char c) {
+		return json_space(c) || c == ',' || c == ']' || c == '}';
+	}
+	static inline bool json_number_char(char c) {
+		return (c >= '0' && c <= '9') || c == '-' || c == '+' || c == '.' || c == 'e' || c == 'E';
+	}
+	// 数字语法: -?(0|[1-9][0-9]*)(\.[0-9]+)?([eE][+-]?[0-9]+)?
+	static bool json_number_valid(const char* s, std::size_t n, bool& integer) {
+		std::size_t i = 0, d;
+		integer = true;
+		if(i < n && s[i] == '-') ++i;
+		if(i >= n) return false;
+		if(s[i] == '0') ++i;
+		else if(s[i] >= '1' && s[i] <= '9') while(i < n && s[i] >= '0' && s[i] <= '9') ++i;
+		else return false;
+		if(i < n && s[i] == '.') {
+			integer = false;
+			d = ++i;
+			while(i < n && s[i] >= '0' && s[i] <= '9') ++i;
+			if(i == d) return false;
+		}
+		if(i < n && (s[i] == 'e' || s[i] == 'E')) {
+			integer = false;
+			++i;
+			if(i < n && (s[i] == '+' || s[i] == '-')) ++i;
+			d = i;
+			while(i < n && s[i] >= '0' && s[i] <= '9') ++i;
+			if(i == d) return false;
+		}
+		return i == n;
+	}
+	// ---------------------------------------------------------------------
+	json_parser::json_parser(handler* h, int depth, std::size_t max_token)
+	: h_(h)
+	, depth_(depth)
+	, max_token_(max_token) {
+		reset();
+	}
+	void json_parser::parse(const char* data, std::size_t size) {
+		const char* p = data, * e = data + size;
+		while(p < e) {
+			switch(lex_) {
+			case LEX_STRING:
+				p = parse_string(p, e);
+				break;
+			case LEX_NUMBER:
+				p = parse_number(p, e);
+				break;
+			case LEX_LITERAL:
+				p = parse_literal(p, e);
+				break;
+			default:
+				if(json_space(*p)) ++p;
+				else p = token(p);
+			}
+		}
+	}
+	void json_parser::parse(stream_buffer& buf) {
+		std::size_t n = buf.size();
+		parse(buf.data(), n);
+		buf.consume(n);
+	}
+	void json_parser::finish() {
+		if(lex_ == LEX_NUMBER) end_number();
+		else if(lex_ == LEX_LITERAL && literal_[matched_] == '\0') end_literal();
+		if(!idle()) error(PHP_JSON_ERROR_SYNTAX, "Syntax error");
+	}
+	void json_parser::reset() {
+		expect_ = EXPECT_VALUE;
+		lex_ = LEX_NONE;
+		key_ = false;
+		escape_ = 0;
+		unicode_ = 0;
+		literal_ = nullptr;
+		matched_ = 0;
+		token_.clear();
+		stack_.clear();
+	}
+	bool json_parser::idle() const {
+		return lex_ == LEX_NONE && expect_ == EXPECT_VALUE && stack_.empty();
+	}
+	const char* json_parser::token(const char* p) {
+		char c = *p;
+		bool value = expect_ == EXPECT_VALUE || expect_ == EXPECT_VALUE_OR_END;
+		switch(c) {
+		case '{':
+		case '[':
+			if(!value) error(PHP_JSON_ERROR_SYNTAX, "Syntax error");
+			if(stack_.size() >= static_cast<std::size_t>(depth_)) error(PHP_JSON_ERROR_DEPTH, "Maximum stack depth exceeded");
+			stack_.push_back(c);
+			if(c == '{') {
+				expect_ = EXPECT_KEY_OR_END;
+				h_->on_object_start();
+			}else{
+				expect_ = EXPECT_VALUE_OR_END;
+				h_->on_array_start();
+			}
+			break;
+		case '}':
+		case ']':
+			// 闭合符号与开启符号相差 2 ('[' + 2 = ']', '{' + 2 = '}')
+			if((expect_ != EXPECT_NEXT && expect_ != (c == '}' ? EXPECT_KEY_OR_END : EXPECT_VALUE_OR_END))
+				|| stack_.empty() || stack_.back() + 2 != c) error(PHP_JSON_ERROR_SYNTAX, "Syntax error");
+			stack_.pop_back();
+			if(c == '}') h_->on_object_end();
+			else h_->on_array_end();
+			end_value();
+			break;
+		case ',':
+			if(expect_ != EXPECT_NEXT) error(PHP_JSON_ERROR_SYNTAX, "Syntax error");
+			expect_ = stack_.back() == '{' ? EXPECT_KEY : EXPECT_VALUE;
+			break;
+		case ':':
+			if(expect_ != EXPECT_COLON) error(PHP_JSON_ERROR_SYNTAX, "Syntax error");
+			expect_ = EXPECT_VALUE;
+			break;
+		case '"':
+			if(expect_ == EXPECT_KEY || expect_ == EXPECT_KEY_OR_END) key_ = true;
+			else if(value) key_ = false;
+			else error(PHP_JSON_ERROR_SYNTAX, "Syntax error");
+			token_.clear();
+			escape_ = 0;
+			lex_ = LEX_STRING;
+			break;
+		case 't':
+		case 'f':
+		case 'n':
+			if(!value) error(PHP_JSON_ERROR_SYNTAX, "Syntax error");
+			literal_ = c == 't' ? "true" : (c == 'f' ? "false" : "null");
+			matched_ = 1;
+			lex_ = LEX_LITERAL;
+			break;
+		default:
+			if(!value || (c != '-' && (c < '0' || c > '9'))) error(PHP_JSON_ERROR_SYNTAX, "Syntax error");
+			token_.assign(1, c);
+			lex_ = LEX_NUMBER;
+		}
+		return p + 1;
+	}
+	const char* json_parser::parse_string(const char* p, const char* e) {
+		static json_string_scan_fn scan = json_string_scan_select();
+		while(p < e) {
+			if(escape_) {
+				escape(*p++);
+				continue;
+			}
+			const char* q = p + scan(p, e - p);
+			while(q < e && json_string_plain(*q)) ++q;
+			append(p, q - p);
+			if(q == e) return q;
+			p = q + 1;
+			if(*q == '"') {
+				end_string();
+				return p;
+			}
+			if(*q == '\\') escape_ = 1;
+			else error(PHP_JSON_ERROR_CTRL_CHAR, "Control character error, possibly incorrectly encoded");
+		}
+		return p;
+	}
+	const char* json_parser::parse_number(const char* p, const char* e) {
+		const char* q = p;
+		while(q < e && json_number_char(*q)) ++q;
+		append(p, q - p);
+		// 遇到其他字符时数字结束 (该字符不消费); 否则数字可能在下一段输入中继续
+		if(q < e) {
+			if(!json_delimiter(*q)) error(PHP_JSON_ERROR_SYNTAX, "Syntax error");
+			end_number();
+		}
+		return q;
+	}
+	const char* json_parser::parse_literal(const char* p, const char* e) {
+		for(; p < e && literal_[matched_]; ++p, ++matched_) {
+			if(*p != literal_[matched_]) error(PHP_JSON_ERROR_SYNTAX, "Syntax error");
+		}
+		// 与数字相同, 遇到分隔字符 (不消费) 时字面量结束
+		if(literal_[matched_] == '\0' && p < e) {
+			if(!json_delimiter(*p)) error(PHP_JSON_ERROR_SYNTAX, "Syntax error");
+			end_literal();
+		}
+		return p;
+	}
+	// 转义状态: 1 '\\' 之后; 2~5 \uXXXX 的 4 位; 6/7 高代理项之后的 '\\' 'u'; 8~11 低代理项的 4 位
+	void json_parser::escape(char c) {
+		char utf8[4];
+		if(escape_ == 1) {
+			switch(c) {
+			case '"':
+			case '\\':
+			case '/':
+				break;
+			case 'b':
+				c = '\b';
+				break;
+			case 'f':
+				c = '\f';
+				break;
+			case 'n':
+				c = '\n';
+				break;
+			case 'r':
+				c = '\r';
+				break;
+			case 't':
+				c = '\t';
+				break;
+			case 'u':
+				escape_ = 2;
+				unicode_ = 0;
+				return;
+			default:
+				error(PHP_JSON_ERROR_SYNTAX, "Syntax error");
+			}
+			escape_ = 0;
+			append(&c, 1);
+			return;
+		}
+		if(escape_ == 6 || escape_ == 7) {
+			if(c != (escape_ == 6 ? '\\' : 'u')) error(PHP_JSON_ERROR_UTF16, "Single unpaired UTF-16 surrogate in unicode escape");
+			++escape_;
+			return;
+		}
+		int h = json_hex(c);
+		// 同 json_decode: \u 之后不足 4 位十六进制为语法错误, 高代理项之后的 \u 不完整则为孤立的代理项
+		if(h < 0) {
+			if(escape_ < 8) error(PHP_JSON_ERROR_SYNTAX, "Syntax error");
+			error(PHP_JSON_ERROR_UTF16, "Single unpaired UTF-16 surrogate in unicode escape");
+		}
+		unicode_ = (unicode_ << 4) | h;
+		if(escape_ == 5) {
+			if(unicode_ >= 0xd800 && unicode_ <= 0xdbff) { // 高代理项, 须紧跟低代理项
+				escape_ = 6;
+				return;
+			}
+			if(unicode_ >= 0xdc00 && unicode_ <= 0xdfff) error(PHP_JSON_ERROR_UTF16, "Single unpaired UTF-16 surrogate in unicode escape");
+			escape_ = 0;
+			append(utf8, json_utf8_encode(utf8, unicode_));
+		}else if(escape_ == 11) {
+			std::uint32_t high = unicode_ >> 16, low = unicode_ & 0xffff;
+			if(low < 0xdc00 || low > 0xdfff) error(PHP_JSON_ERROR_UTF16, "Single unpaired UTF-16 surrogate in unicode escape");
+			escape_ = 0;
+			append(utf8, json_utf8_encode(utf8, 0x10000 + ((high - 0xd800) << 10) + (low - 0xdc00)));
+		}else{
+			++escape_;
+		}
+	}
+	void json_parser::append(const char* p, std::size_t n) {
+		if(token_.size() + n > max_token_) error(PHP_JSON_ERROR_SYNTAX, "Token too long");
+		token_.append(p, n);
+	}
+	void json_parser::end_string() {
+		// 转义产生的字节均为完整字符, 不会与原始字节拼接出合法序列, 可统一校验
+		if(!json_utf8_valid(token_.data(), token_.size())) error(PHP_JSON_ERROR_UTF8, "Malformed UTF-8 characters, possibly incorrectly encoded");
+		lex_ = LEX_NONE;
+		if(key_) {
+			expect_ = EXPECT_COLON;
+			h_->on_key(token_.data(), token_.size());
+		}else{
+			h_->on_string(token_.data(), token_.size());
+			end_value();
+		}
+	}
+	void json_parser::end_number() {
+		bool integer;
+		if(!json_number_valid(token_.data(), token_.size(), integer)) error(PHP_JSON_ERROR_SYNTAX, "Syntax error");
+		lex_ = LEX_NONE;
+		std::int64_t i;
+		double d;
+		// 超出 zend_long 范围的整数转为浮点数 (同 json_decode 未指定 JSON_BIGINT_AS_STRING 时)
+		if(integer && parse_integer(token_.data(), token_.size(), i)) h_->on_integer(i);
+		else if(parse_float(token_.data(), token_.size(), d)) h_->on_float(d);
+		end_value();
+	}
+	void json_parser::end_literal() {
+		lex_ = LEX_NONE;
+		if(literal_[0] == 'n') h_->on_null();
+		else h_->on_boolean(literal_[0] == 't');
+		end_value();
+	}
+	void json_parser::end_value() {
+		if(stack_.empty()) {
+			expect_ = EXPECT_VALUE;
+			h_->on_document_end();
+		}else{
+			expect_ = EXPECT_NEXT;
+		}
+	}
+	void json_parser::error(int code, const char* message) {
+		JSON_G(error_code) = static_cast<php_json_error_code>(code);
+		throw php::exception(zend_ce_error, message, code);
+	}
+	// ---------------------------------------------------------------------
+	json_value_builder::json_value_builder() {
+
+	}
+	json_value_builder::~json_value_builder() {
+		reset();
+	}
+	std::size_t json_value_builder::size() const {
+		return values_.size();
+	}
+	bool json_value_builder::empty() const {
+		return values_.empty();
+	}
+	value json_value_builder::pop() {
+		value v = std::move(values_.front());
+		values_.pop_front();
+		return v;
+	}
+	void json_value_builder::reset() {
+		for(auto& z : stack_) zval_ptr_dtor(&z);
+		for(auto k : keys_) if(k) zend_string_release(k);
+		stack_.clear();
+		keys_.clear();
+	}
+	void json_value_builder::on_null() {
+		zval z;
+		ZVAL_NULL(&z);
+		add(&z);
+	}
+	void json_value_builder::on_boolean(bool v) {
+		zval z;
+		ZVAL_BOOL(&z, v);
+		add(&z);
+	}
+	void json_value_builder::on_integer(std::int64_t v) {
+		zval z;
+		ZVAL_LONG(&z, v);
+		add(&z);
+	}
+	void json_value_builder::on_float(double v) {
+		zval z;
+		ZVAL_DOUBLE(&z, v);
+		add(&z);
+	}
+	void json_value_builder::on_string(const char* str, std::size_t len) {
+		zval z;
+		ZVAL_STRINGL(&z, str, len);
+		add(&z);
+	}
+	void json_value_builder::on_key(const char* str, std::size_t len) {
+		if(keys_.back()) zend_string_release(keys_.back());
+		keys_.back() = zend_string_init(str, len, 0);
+	}
+	void json_value_builder::on_array_start() {
+		zval z;
+		array_init(&z);
+		stack_.push_back(z);
+		keys_.push_back(nullptr);
+	}
+	void json_value_builder::on_array_end() {
+		zval z = stack_.back();
+		stack_.pop_back();
+		keys_.pop_back();
+		add(&z);
+	}
+	void json_value_builder::on_object_start() {
+		on_array_start();
+	}
+	void json_value_builder::on_object_end() {
+		on_array_end();
+	}
+	void json_value_builder::add(zval* v) {
+		if(stack_.empty()) {
+			values_.push_back(value(v));
+			zval_ptr_dtor(v);
+			return;
+		}
+		HashTable* ht = Z_ARRVAL(stack_.back());
+		zend_string*& key = keys_.back();
+		if(key) {
+			zend_symtable_update(ht, key, v);
+			zend_string_release(key);
+			key = nullptr;
+		}else{
+			zend_hash_next_index_insert(ht, v);
+		}
+	}
+}
@@ -0,0 +1,111 @@
+#pragma once
+
+#include "value.h"
+#include "stream_buffer.h"
+
+namespace php {
+	// 可恢复的增量 (推送式) JSON 解析器: 输入可在任意位置切分, 分多次送入
+	// 支持连续的多个顶层值 (NDJSON / 直接拼接), 内存占用仅与嵌套深度及单个字符串/数字的长度相关
+	// 语法错误时抛出异常 (code 为 JSON_ERROR_* 错误码) 并设置 json_last_error(), 之后须 reset() 才能继续使用
+	class json_parser {
+	public:
+		// 事件处理 (SAX)
+		class handler {
+		public:
+			virtual ~handler() {}
+			virtual void on_null() {}
+			virtual void on_boolean(bool v) {}
+			virtual void on_integer(std::int64_t v) {}
+			virtual void on_float(double v) {}
+			// 已完成转义处理的完整字符串
+			virtual void on_string(const char* str, std::size_t len) {}
+			virtual void on_key(const char* str, std::size_t len) {}
+			virtual void on_array_start() {}
+			virtual void on_array_end() {}
+			virtual void on_object_start() {}
+			virtual void on_object_end() {}
+			// 一个顶层值结束
+			virtual void on_document_end() {}
+		};
+		json_parser(handler* h, int depth = PHP_JSON_PARSER_DEFAULT_DEPTH, std::size_t max_token = 16 * 1024 * 1024);
+		// 解析一段输入 (全部消费, 不完整的字符串、数字等会被暂存)
+		void parse(const char* data, std::size_t size);
+		// 解析缓冲区中的全部可读数据并消费
+		void parse(stream_buffer& buf);
+		// 输入结束: 完成末尾的顶层数字或字面量; 存在未完成的值时抛出异常
+		void finish();
+		// 丢弃未完成的数据, 重新开始
+		void reset();
+		// 当前位于两个顶层值之间
+		bool idle() const;
+	private:
+		enum {
+			EXPECT_VALUE,
+			EXPECT_VALUE_OR_END, // '[' 之后
+			EXPECT_KEY_OR_END,   // '{' 之后
+			EXPECT_KEY,
+			EXPECT_COLON,
+			EXPECT_NEXT,         // ',' 或 闭合
+		};
+		enum {
+			LEX_NONE,
+			LEX_STRING,
+			LEX_NUMBER,
+			LEX_LITERAL,
+		};
+		handler*          h_;
+		int               depth_;
+		std::size_t       max_token_;
+		int               expect_;
+		int               lex_;
+		bool              key_;     // 当前字符串为对象键
+		int               escape_;  // 字符串转义状态
+		std::uint32_t     unicode_; // \uXXXX 累积值
+		const char*       literal_; // 当前字面量 (true / false / null)
+		std::size_t       matched_; // 字面量已匹配长度
+		std::string       token_;   // 未完成的字符串或数字
+		std::vector<char> stack_;   // 容器类型 '{' / '['
+
+		const char* token(const char* p);
+		const char* parse_string(const char* p, const char* e);
+		const char* parse_number(const char* p, const char* e);
+		const char* parse_literal(const char* p, const char* e);
+		void escape(char c);
+		void append(const char* p, std::size_t n);
+		void end_string();
+		void end_number();
+		void end_literal();
+		void end_value();
+		void error(int code, const char* message);
+	};
+	// 将事件构建为 PHP 值 (对象构建为关联数组, 与 json_decode($json, true) 一致), 完整的顶层值依次进入队列
+	class json_value_builder: public json_parser::handler {
+	public:
+		json_value_builder();
+		~json_value_builder();
+		// 已完成的顶层值数量
+		std::size_t size() const;
+		bool empty() const;
+		// 取出最早完成的顶层值
+		value pop();
+		// 丢弃未完成的值
+		void reset();
+
+		void on_null() override;
+		void on_boolean(bool v) override;
+		void on_integer(std::int64_t v) override;
+		void on_float(double v) override;
+		void on_string(const char* str, std::size_t len) override;
+		void on_key(const char* str, std::size_t len) override;
+		void on_array_start() override;
+		void on_array_end() override;
+		void on_object_start() override;
+		void on_object_end() override;
+	private:
+		std::vector<zval>         stack_; // 构建中的容器
+		std::vector<zend_string*> keys_;  // 各层对象的当前键
+		std::list<value>          values_;
+
+		void add(zval* v);
+	};
+}
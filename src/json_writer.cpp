@@ -0,0 +1,176 @@
+#include "vendor.h"
+#include "json_writer.h"
+#include "json.h"
+#include "exception.h"
+
+namespace php {
+	json_writer::json_writer(buffer& buf, bool pretty, int flags)
+	: str_(buf)
+	, pretty_(pretty)
+	, flags_(flags)
+	, first_(true)
+	, key_(false)
+	, done_(false) {
+
+	}
+	json_writer& json_writer::begin_object() {
+		open('{');
+		return *this;
+	}
+	json_writer& json_writer::end_object() {
+		close('}');
+		return *this;
+	}
+	json_writer& json_writer::begin_array() {
+		open('[');
+		return *this;
+	}
+	json_writer& json_writer::end_array() {
+		close(']');
+		return *this;
+	}
+	json_writer& json_writer::key(const char* str) {
+		return key(str, std::strlen(str));
+	}
+	json_writer& json_writer::key(const char* str, std::size_t len) {
+		assert(!stack_.empty() && stack_.back() == '{' && !key_);
+		if(first_) first_ = false;
+		else smart_str_appendc(str_, ',');
+		if(pretty_) indent();
+		if(!json_encode_string_to(str_, str, len, flags_)) error();
+		if(pretty_) smart_str_appendl(str_, ": ", 2);
+		else smart_str_appendc(str_, ':');
+		key_ = true;
+		return *this;
+	}
+	json_writer& json_writer::key(const std::string& str) {
+		return key(str.c_str(), str.size());
+	}
+	json_writer& json_writer::key(const string& str) {
+		return key(str.c_str(), str.size());
+	}
+	json_writer& json_writer::value(std::nullptr_t v) {
+		prefix();
+		smart_str_appendl(str_, "null", 4);
+		suffix();
+		return *this;
+	}
+	json_writer& json_writer::value(bool v) {
+		prefix();
+		if(v) smart_str_appendl(str_, "true", 4);
+		else smart_str_appendl(str_, "false", 5);
+		suffix();
+		return *this;
+	}
+	json_writer& json_writer::value(int v) {
+		return value(static_cast<std::int64_t>(v));
+	}
+	json_writer& json_writer::value(std::uint32_t v) {
+		return value(static_cast<std::int64_t>(v));
+	}
+	json_writer& json_writer::value(std::int64_t v) {
+		prefix();
+		json_encode_long_to(str_, v);
+		suffix();
+		return *this;
+	}
+	json_writer& json_writer::value(std::size_t v) {
+		// 超出 zend_long 范围时同 PHP 按浮点数输出
+		if(v > static_cast<std::size_t>(ZEND_LONG_MAX)) return value(static_cast<double>(v));
+		return value(static_cast<std::int64_t>(v));
+	}
+	json_writer& json_writer::value(double v) {
+		prefix();
+		if(!json_encode_double_to(str_, v)) error();
+		suffix();
+		return *this;
+	}
+	json_writer& json_writer::value(const char* str) {
+		return value(str, std::strlen(str));
+	}
+	json_writer& json_writer::value(const char* str, std::size_t len) {
+		prefix();
+		if(!json_encode_string_to(str_, str, len, flags_)) error();
+		suffix();
+		return *this;
+	}
+	json_writer& json_writer::value(const std::string& str) {
+		return value(str.c_str(), str.size());
+	}
+	json_writer& json_writer::value(const string& str) {
+		return value(str.c_str(), str.size());
+	}
+	json_writer& json_writer::value(const php::value& v) {
+		prefix();
+		JSON_G(error_code) = PHP_JSON_ERROR_NONE;
+		json_encode_to(str_, v, flags_);
+		if(JSON_G(error_code) != PHP_JSON_ERROR_NONE) error();
+		suffix();
+		return *this;
+	}
+	json_writer& json_writer::raw(const char* json, std::size_t len) {
+		prefix();
+		smart_str_appendl(str_, json, len);
+		suffix();
+		return *this;
+	}
+	bool json_writer::complete() const {
+		return done_;
+	}
+	void json_writer::prefix() {
+		if(stack_.empty()) {
+			assert(!done_);
+		}else if(stack_.back() == '{') {
+			assert(key_);
+			key_ = false;
+		}else{
+			if(first_) first_ = false;
+			else smart_str_appendc(str_, ',');
+			if(pretty_) indent();
+		}
+	}
+	void json_writer::suffix() {
+		if(stack_.empty()) done_ = true;
+	}
+	void json_writer::indent() {
+		std::size_t n = stack_.size() * 4;
+		smart_str_alloc(str_, n + 1, 0);
+		char* out = ZSTR_VAL(str_->s) + ZSTR_LEN(str_->s);
+		out[0] = '\n';
+		std::memset(out + 1, ' ', n);
+		ZSTR_LEN(str_->s) += n + 1;
+	}
+	void json_writer::open(char c) {
+		prefix();
+		smart_str_appendc(str_, c);
+		stack_.push_back(c);
+		first_ = true;
+	}
+	void json_writer::close(char c) {
+		// 闭合符号与开启符号相差 2 ('[' + 2 = ']', '{' + 2 = '}')
+		assert(!stack_.empty() && stack_.back() + 2 == c && !key_);
+		stack_.pop_back();
+		// 空容器同 JSON_PRETTY_PRINT 输出为 {} / []
+		if(pretty_ && !first_) indent();
+		smart_str_appendc(str_, c);
+		first_ = false;
+		suffix();
+	}
+	void json_writer::error() {
+		php::exception::rethrow();
+		switch(JSON_G(error_code)) {
+		case PHP_JSON_ERROR_UTF8:
+			throw php::exception(zend_ce_error, "Malformed UTF-8 characters, possibly incorrectly encoded", PHP_JSON_ERROR_UTF8);
+		case PHP_JSON_ERROR_INF_OR_NAN:
+			throw php::exception(zend_ce_error, "Inf and NaN cannot be JSON encoded", PHP_JSON_ERROR_INF_OR_NAN);
+		case PHP_JSON_ERROR_DEPTH:
+			throw php::exception(zend_ce_error, "Maximum stack depth exceeded", PHP_JSON_ERROR_DEPTH);
+		case PHP_JSON_ERROR_RECURSION:
+			throw php::exception(zend_ce_error, "Recursion detected", PHP_JSON_ERROR_RECURSION);
+		case PHP_JSON_ERROR_UNSUPPORTED_TYPE:
+			throw php::exception(zend_ce_error, "Type is not supported", PHP_JSON_ERROR_UNSUPPORTED_TYPE);
+		default:
+			throw php::exception(zend_ce_error, "Syntax error", JSON_G(error_code));
+		}
+	}
+}
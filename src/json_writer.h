@@ -0,0 +1,58 @@
+#pragma once
+
+#include "value.h"
+#include "string.h"
+#include "buffer.h"
+
+namespace php {
+	// 流式 JSON 写入: 由原生数据直接输出到 buffer, 不构建中间 PHP 值
+	// 转义及数值格式同 json_encode(); 调用顺序 (键/值/闭合) 仅在调试构建中以 assert 校验
+	// 字符串含非法 UTF-8 或浮点数为 INF/NAN 时抛出异常 (code 为 JSON_ERROR_* 错误码)
+	class json_writer {
+	public:
+		// pretty: 格式同 JSON_PRETTY_PRINT (4 空格缩进); flags: json_flag
+		json_writer(buffer& buf, bool pretty = false, int flags = 0);
+		json_writer& begin_object();
+		json_writer& end_object();
+		json_writer& begin_array();
+		json_writer& end_array();
+		json_writer& key(const char* str);
+		json_writer& key(const char* str, std::size_t len);
+		json_writer& key(const std::string& str);
+		json_writer& key(const string& str);
+		json_writer& value(std::nullptr_t v);
+		json_writer& value(bool v);
+		json_writer& value(int v);
+		json_writer& value(std::uint32_t v);
+		json_writer& value(std::int64_t v);
+		json_writer& value(std::size_t v);
+		json_writer& value(double v);
+		json_writer& value(const char* str);
+		json_writer& value(const char* str, std::size_t len);
+		json_writer& value(const std::string& str);
+		json_writer& value(const string& str);
+		// 任意 PHP 值 (经由 json_encode_to 编码, 不进行美化)
+		json_writer& value(const php::value& v);
+		// 已编码的 JSON 片段, 原样写入
+		json_writer& raw(const char* json, std::size_t len);
+		// 顶层值已完整写入
+		bool complete() const;
+	private:
+		smart_str*        str_;
+		bool              pretty_;
+		int               flags_;
+		bool              first_; // 当前容器尚无元素
+		bool              key_;   // 已写入键, 等待值
+		bool              done_;  // 顶层值已完成
+		std::vector<char> stack_; // 容器类型 '{' / '['
+
+		// 写入值之前: 分隔符及缩进
+		void prefix();
+		// 写入值之后
+		void suffix();
+		void indent();
+		void open(char c);
+		void close(char c);
+		void error();
+	};
+}
@@ -0,0 +1,221 @@
+#include "vendor.h"
+#include "lru_cache.h"
+#include "persistent.h"
+#include "extension_entry.h"
+#include "exception.h"
+#include "array.h"
+
+namespace php {
+	// 未被读取过的数据
+	static const std::uint64_t lru_cache_unread = std::numeric_limits<std::uint64_t>::max();
+
+	lru_cache::lru_cache(std::size_t capacity)
+	: retired_seq_(0)
+	, capacity_(capacity)
+	, memory_(0)
+	, hits_(0)
+	, misses_(0)
+	, evictions_(0) {
+		zend_hash_init(&index_, 8, nullptr, nullptr, 1);
+		head_.prev = &head_;
+		head_.next = &head_;
+	}
+	lru_cache::~lru_cache() {
+		for(node_t* n = head_.next; n != &head_;) {
+			node_t* next = n->next;
+			destroy(n);
+			n = next;
+		}
+		// 进程 (线程) 结束时不再有请求引用
+		for(auto i=retired_.begin(); i!=retired_.end(); ++i) destroy(*i);
+		zend_hash_destroy(&index_);
+	}
+	lru_cache::node_t* lru_cache::find(const char* key, std::size_t len) const {
+		return static_cast<node_t*>(zend_hash_str_find_ptr(&index_, key, len));
+	}
+	void lru_cache::unlink(node_t* n) {
+		n->prev->next = n->next;
+		n->next->prev = n->prev;
+	}
+	void lru_cache::push_front(node_t* n) {
+		n->prev = &head_;
+		n->next = head_.next;
+		head_.next->prev = n;
+		head_.next = n;
+	}
+	void lru_cache::retire(node_t* n) {
+		unlink(n);
+		zend_hash_del(&index_, n->key);
+		memory_ -= n->bytes;
+		// 当前请求中读取过的数据可能仍被引用
+		if(n->seq == extension_entry::request_sequence()) {
+			retired_seq_ = n->seq;
+			retired_.push_back(n);
+		}else{
+			destroy(n);
+		}
+	}
+	void lru_cache::collect() {
+		if(retired_.empty() || retired_seq_ == extension_entry::request_sequence()) return;
+		for(auto i=retired_.begin(); i!=retired_.end(); ++i) destroy(*i);
+		retired_.clear();
+	}
+	void lru_cache::destroy(node_t* n) {
+		persistent_free(&n->val);
+		persistent_free(n->key);
+		delete n;
+	}
+	bool lru_cache::set(const char* key, std::size_t len, const value& val) {
+		collect();
+		node_t* n = new node_t;
+		try {
+			n->bytes = persistent_copy(&n->val, val);
+		}catch(...) {
+			delete n;
+			throw;
+		}
+		n->bytes += sizeof(node_t) + sizeof(Bucket) + _ZSTR_STRUCT_SIZE(len);
+		if(n->bytes > capacity_) {
+			persistent_free(&n->val);
+			delete n;
+			return false;
+		}
+		n->key = persistent_string(key, len);
+		n->seq = lru_cache_unread;
+		node_t* o = find(key, len);
+		if(o) retire(o);
+		zend_hash_add_new_ptr(&index_, n->key, n);
+		push_front(n);
+		memory_ += n->bytes;
+		while(memory_ > capacity_) {
+			retire(head_.prev);
+			++evictions_;
+		}
+		return true;
+	}
+	bool lru_cache::set(const string& key, const value& val) {
+		return set(key.c_str(), key.size(), val);
+	}
+	bool lru_cache::get(const char* key, std::size_t len, value& val) {
+		collect();
+		node_t* n = find(key, len);
+		if(!n) {
+			++misses_;
+			return false;
+		}
+		++hits_;
+		if(n != head_.next) {
+			unlink(n);
+			push_front(n);
+		}
+		n->seq = extension_entry::request_sequence();
+		val = value(&n->val);
+		return true;
+	}
+	bool lru_cache::get(const string& key, value& val) {
+		return get(key.c_str(), key.size(), val);
+	}
+	value lru_cache::get(const string& key) {
+		value val(nullptr);
+		get(key.c_str(), key.size(), val);
+		return val;
+	}
+	bool lru_cache::exists(const char* key, std::size_t len) const {
+		return find(key, len) != nullptr;
+	}
+	bool lru_cache::exists(const string& key) const {
+		return exists(key.c_str(), key.size());
+	}
+	bool lru_cache::remove(const char* key, std::size_t len) {
+		collect();
+		node_t* n = find(key, len);
+		if(!n) return false;
+		retire(n);
+		return true;
+	}
+	bool lru_cache::remove(const string& key) {
+		return remove(key.c_str(), key.size());
+	}
+	void lru_cache::clear() {
+		collect();
+		while(head_.next != &head_) retire(head_.next);
+	}
+	std::size_t lru_cache::size() const {
+		return zend_hash_num_elements(&index_);
+	}
+	std::size_t lru_cache::memory() const {
+		return memory_;
+	}
+	std::size_t lru_cache::capacity() const {
+		return capacity_;
+	}
+	std::uint64_t lru_cache::hits() const {
+		return hits_;
+	}
+	std::uint64_t lru_cache::misses() const {
+		return misses_;
+	}
+	std::uint64_t lru_cache::evictions() const {
+		return evictions_;
+	}
+	lru_cache& lru_cache::named(const std::string& name, std::size_t capacity) {
+#ifdef ZTS
+		static thread_local std::map<std::string, std::unique_ptr<lru_cache>> caches;
+#else
+		static std::map<std::string, std::unique_ptr<lru_cache>> caches;
+#endif
+		std::unique_ptr<lru_cache>& c = caches[name];
+		if(!c) c.reset(new lru_cache(capacity));
+		return *c;
+	}
+	// 非字符串键按 PHP 规则转换
+	static string lru_cache_key(const parameter& p) {
+		string key = p;
+		if(!key.type_of(TYPE::STRING)) key.to_string();
+		return key;
+	}
+	lru_cache_object::lru_cache_object()
+	: cache_(nullptr) {}
+	lru_cache* lru_cache_object::cache() const {
+		if(!cache_) throw php::exception(zend_ce_error, "lru_cache: object not constructed");
+		return cache_;
+	}
+	value lru_cache_object::__construct(parameters& params) {
+		string       name = params[0];
+		std::int64_t capacity = params[1];
+		if(!name.type_of(TYPE::STRING)) throw php::exception(zend_ce_type_error, "lru_cache: name must be of type string");
+		if(capacity <= 0) throw php::exception(zend_ce_type_error, "lru_cache: capacity must be greater than 0");
+		cache_ = &lru_cache::named(std::string(name.c_str(), name.size()), capacity);
+		return nullptr;
+	}
+	value lru_cache_object::get(parameters& params) {
+		value val;
+		if(cache()->get(lru_cache_key(params[0]), val)) return val;
+		if(params.size() > 1) return params[1];
+		return nullptr;
+	}
+	value lru_cache_object::set(parameters& params) {
+		return cache()->set(lru_cache_key(params[0]), params[1]);
+	}
+	value lru_cache_object::has(parameters& params) {
+		return cache()->exists(lru_cache_key(params[0]));
+	}
+	value lru_cache_object::remove(parameters& params) {
+		return cache()->remove(lru_cache_key(params[0]));
+	}
+	value lru_cache_object::clear(parameters& params) {
+		cache()->clear();
+		return nullptr;
+	}
+	value lru_cache_object::stats(parameters& params) {
+		lru_cache* c = cache();
+		array rv(8);
+		rv["size"] = c->size();
+		rv["memory"] = c->memory();
+		rv["capacity"] = c->capacity();
+		rv["hits"] = static_cast<std::int64_t>(c->hits());
+		rv["misses"] = static_cast<std::int64_t>(c->misses());
+		rv["evictions"] = static_cast<std::int64_t>(c->evictions());
+		return rv;
+	}
+}
@@ -0,0 +1,87 @@
+#pragma once
+
+#include "value.h"
+#include "string.h"
+#include "class_base.h"
+#include "parameters.h"
+
+namespace php {
+	// 工作进程内跨请求保留的 LRU 缓存 (按字节限制容量, 查找、淘汰均为 O(1))
+	// 值被深复制为持久不可变数据 (见 persistent_copy()), 读取时不复制、不修改引用计数
+	// 被替换或淘汰的数据若已在当前请求中读取过, 延迟至下一请求开始后释放
+	// 非线程安全: ZTS 环境下应每线程一个实例 (如 named() 或置于模块全局数据中)
+	class lru_cache {
+	public:
+		explicit lru_cache(std::size_t capacity);
+		~lru_cache();
+		lru_cache(const lru_cache& c) = delete;
+		lru_cache& operator =(const lru_cache& c) = delete;
+		// 类型不支持时抛出异常 (同 persistent_copy()); 单项超过容量时返回 false
+		bool set(const char* key, std::size_t len, const value& val);
+		bool set(const string& key, const value& val);
+		// val 直接引用缓存数据
+		bool get(const char* key, std::size_t len, value& val);
+		bool get(const string& key, value& val);
+		// 不存在时返回 null
+		value get(const string& key);
+		bool exists(const char* key, std::size_t len) const;
+		bool exists(const string& key) const;
+		bool remove(const char* key, std::size_t len);
+		bool remove(const string& key);
+		void clear();
+		// 数据项数量
+		std::size_t size() const;
+		// 占用的持久内存 (估算, 不含待释放的数据)
+		std::size_t memory() const;
+		std::size_t capacity() const;
+		std::uint64_t hits() const;
+		std::uint64_t misses() const;
+		std::uint64_t evictions() const;
+		// 当前进程 (ZTS 为当前线程) 中指定名称的实例, 不存在时以 capacity 创建
+		static lru_cache& named(const std::string& name, std::size_t capacity);
+	private:
+		struct node_t {
+			node_t*       prev;
+			node_t*       next;
+			zend_string*  key;
+			zval          val;
+			std::size_t   bytes;
+			std::uint64_t seq; // 最近一次被读取时的请求序号
+		};
+		HashTable            index_;   // key -> node_t*
+		node_t               head_;    // 环形链表哨兵, head_.next 为最近使用
+		std::vector<node_t*> retired_; // 待释放
+		std::uint64_t        retired_seq_;
+		std::size_t          capacity_;
+		std::size_t          memory_;
+		std::uint64_t        hits_;
+		std::uint64_t        misses_;
+		std::uint64_t        evictions_;
+
+		node_t* find(const char* key, std::size_t len) const;
+		void unlink(node_t* n);
+		void push_front(node_t* n);
+		// 自索引及链表中移除
+		void retire(node_t* n);
+		void collect();
+		static void destroy(node_t* n);
+	};
+	// PHP 类封装 (以 class_entry<lru_cache_object> 注册):
+	// __construct(string $name, int $capacity) 取得当前工作进程中同名的缓存实例 (见 lru_cache::named())
+	// get($key, $default = null), set($key, $value): bool, has($key): bool, delete($key): bool, clear(), stats(): array
+	class lru_cache_object: public class_base {
+	public:
+		lru_cache_object();
+		value __construct(parameters& params);
+		value get(parameters& params);
+		value set(parameters& params);
+		value has(parameters& params);
+		value remove(parameters& params);
+		value clear(parameters& params);
+		value stats(parameters& params);
+	private:
+		lru_cache* cache_;
+
+		lru_cache* cache() const;
+	};
+}
@@ -0,0 +1,42 @@
+#pragma once
+
+namespace php {
+	// 模块全局数据: 每个扩展至多一个类型, 由 extension_entry::declare_globals<T>() 声明
+	struct module_globals_id {
+#ifdef ZTS
+		static ts_rsrc_id          id;
+		// 当前线程的 TSRM 存储 (同 ZEND_TSRMLS_CACHE), 避免每次访问调用 tsrm_get_ls_cache()
+		static thread_local void*  cache;
+#endif
+	};
+	template <class T>
+	struct module_globals {
+		static typename std::aligned_storage<sizeof(T), alignof(T)>::type data; // NTS 存储
+		static std::function<void (T&)> ctor;
+		static std::function<void (T&)> dtor;
+		// 当前线程的实例 (NTS 为静态存储的直接访问, ZTS 为缓存的 TSRM 存储下标访问)
+		static T& get() {
+#ifdef ZTS
+			if(!module_globals_id::cache) module_globals_id::cache = tsrm_get_ls_cache();
+			return *static_cast<T*>((*static_cast<void***>(module_globals_id::cache))[TSRM_UNSHUFFLE_RSRC_ID(module_globals_id::id)]);
+#else
+			return *reinterpret_cast<T*>(&data);
+#endif
+		}
+		static void on_ctor_handler(void* g) {
+			T* t = new (g) T();
+			if(ctor) ctor(*t);
+		}
+		static void on_dtor_handler(void* g) {
+			T* t = static_cast<T*>(g);
+			if(dtor) dtor(*t);
+			t->~T();
+		}
+	};
+	template <class T>
+	typename std::aligned_storage<sizeof(T), alignof(T)>::type module_globals<T>::data;
+	template <class T>
+	std::function<void (T&)> module_globals<T>::ctor;
+	template <class T>
+	std::function<void (T&)> module_globals<T>::dtor;
+}
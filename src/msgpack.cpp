@@ -0,0 +1,481 @@
+#include "vendor.h"
+#include "msgpack.h"
+#include "exception.h"
+
+namespace php {
+	static const int msgpack_max_depth = 512;
+	// 键引用的扩展类型
+	static const char msgpack_ext_key = 'K';
+	// 需要加入去重表的最短键长度 (引用最少占 3 字节)
+	static const std::size_t msgpack_dedupe_min = 3;
+
+	static inline void msgpack_store(char* out, std::uint64_t v, int bytes) {
+		for(int i=bytes-1; i>=0; --i) {
+			out[i] = static_cast<char>(v & 0xff);
+			v >>= 8;
+		}
+	}
+	static inline std::uint64_t msgpack_load(const unsigned char* in, int bytes) {
+		std::uint64_t v = 0;
+		for(int i=0; i<bytes; ++i) v = (v << 8) | in[i];
+		return v;
+	}
+	// 同 json_is_list()
+	static inline bool msgpack_is_list(HashTable* ht) {
+		if(zend_hash_num_elements(ht) == 0 || (HT_IS_PACKED(ht) && HT_IS_WITHOUT_HOLES(ht))) {
+			return true;
+		}
+		zend_string* key;
+		zend_ulong   index, idx = 0;
+		ZEND_HASH_FOREACH_KEY(ht, index, key) {
+			if(key || index != idx) return false;
+			++idx;
+		} ZEND_HASH_FOREACH_END();
+		return true;
+	}
+	class msgpack_encoder {
+	public:
+		msgpack_encoder(smart_str* str, int flags)
+		: str_(str)
+		, flags_(flags)
+		, depth_(0)
+		, keys_(nullptr) {
+
+		}
+		~msgpack_encoder() {
+			if(keys_) {
+				zend_hash_destroy(keys_);
+				FREE_HASHTABLE(keys_);
+			}
+		}
+		void encode(zval* val) {
+again:
+			switch(Z_TYPE_P(val)) {
+			case IS_NULL:
+				smart_str_appendc(str_, '\xc0');
+				break;
+			case IS_FALSE:
+				smart_str_appendc(str_, '\xc2');
+				break;
+			case IS_TRUE:
+				smart_str_appendc(str_, '\xc3');
+				break;
+			case IS_LONG:
+				encode_long(Z_LVAL_P(val));
+				break;
+			case IS_DOUBLE:
+				encode_double(Z_DVAL_P(val));
+				break;
+			case IS_STRING:
+				encode_string(Z_STRVAL_P(val), Z_STRLEN_P(val));
+				break;
+			case IS_ARRAY:
+				encode_array(Z_ARRVAL_P(val), false);
+				break;
+			case IS_OBJECT:
+				encode_array(Z_OBJPROP_P(val), true);
+				break;
+			case IS_REFERENCE:
+				val = Z_REFVAL_P(val);
+				goto again;
+			default:
+				throw php::exception(zend_ce_type_error, "failed to pack: unsupported type");
+			}
+		}
+	private:
+		smart_str* str_;
+		int        flags_;
+		int        depth_;
+		HashTable* keys_; // 键 => 引用序号
+
+		char* prepare(std::size_t size) {
+			smart_str_alloc(str_, size, 0);
+			return ZSTR_VAL(str_->s) + ZSTR_LEN(str_->s);
+		}
+		// 类型标记 + 大端定长数据
+		void put(unsigned char tag, std::uint64_t v, int bytes) {
+			char* out = prepare(bytes + 1);
+			out[0] = static_cast<char>(tag);
+			msgpack_store(out + 1, v, bytes);
+			ZSTR_LEN(str_->s) += bytes + 1;
+		}
+		// 按长度选择 fix / 8 / 16 / 32 位格式
+		void header(std::size_t n, unsigned char fix, std::size_t fix_max, unsigned char tag8, unsigned char tag16) {
+			if(n <= fix_max) smart_str_appendc(str_, static_cast<char>(fix | n));
+			else if(n < 0x100 && tag8) put(tag8, n, 1);
+			else if(n < 0x10000) put(tag16, n, 2);
+			else if(n <= 0xffffffffu) put(tag16 + 1, n, 4);
+			else throw php::exception(zend_ce_error, "failed to pack: length exceeds 4G");
+		}
+		void encode_long(zend_long v) {
+			if(v >= 0) {
+				if(v < 0x80) smart_str_appendc(str_, static_cast<char>(v));
+				else if(v < 0x100) put(0xcc, v, 1);
+				else if(v < 0x10000) put(0xcd, v, 2);
+				else if(v <= 0xffffffffll) put(0xce, v, 4);
+				else put(0xcf, v, 8);
+			}else{
+				if(v >= -32) smart_str_appendc(str_, static_cast<char>(v));
+				else if(v >= -0x80) put(0xd0, static_cast<std::uint8_t>(v), 1);
+				else if(v >= -0x8000) put(0xd1, static_cast<std::uint16_t>(v), 2);
+				else if(v >= -0x80000000ll) put(0xd2, static_cast<std::uint32_t>(v), 4);
+				else put(0xd3, static_cast<std::uint64_t>(v), 8);
+			}
+		}
+		void encode_double(double d) {
+			std::uint64_t u;
+			std::memcpy(&u, &d, 8);
+			put(0xcb, u, 8);
+		}
+		void encode_string(const char* s, std::size_t len) {
+			header(len, 0xa0, 31, 0xd9, 0xda);
+			smart_str_appendl(str_, s, len);
+		}
+		void encode_key(zend_string* key) {
+			if(!(flags_ & MSGPACK_DEDUPE_KEYS) || ZSTR_LEN(key) < msgpack_dedupe_min) {
+				encode_string(ZSTR_VAL(key), ZSTR_LEN(key));
+				return;
+			}
+			if(!keys_) {
+				ALLOC_HASHTABLE(keys_);
+				zend_hash_init(keys_, 64, nullptr, nullptr, 0);
+			}
+			zval* ref = zend_hash_find(keys_, key);
+			if(ref) {
+				zend_ulong i = Z_LVAL_P(ref);
+				if(i < 0x100) put(0xd4, (msgpack_ext_key << 8) | i, 2);
+				else if(i < 0x10000) put(0xd5, (msgpack_ext_key << 16) | i, 3);
+				else put(0xd6, (static_cast<std::uint64_t>(msgpack_ext_key) << 32) | i, 5);
+				return;
+			}
+			zval idx;
+			ZVAL_LONG(&idx, zend_hash_num_elements(keys_));
+			zend_hash_add_new(keys_, key, &idx);
+			encode_string(ZSTR_VAL(key), ZSTR_LEN(key));
+		}
+		void encode_array(HashTable* ht, bool object) {
+			if(++depth_ > msgpack_max_depth) {
+				throw php::exception(zend_ce_error, "failed to pack: maximum depth exceeded");
+			}
+			zend_string* key;
+			zend_ulong   index;
+			zval*        data;
+			if(!ht) {
+				smart_str_appendc(str_, '\x80');
+			}else if(!object && msgpack_is_list(ht)) {
+				header(zend_hash_num_elements(ht), 0x90, 15, 0, 0xdc);
+				ZEND_HASH_FOREACH_VAL_IND(ht, data) {
+					encode(data);
+				} ZEND_HASH_FOREACH_END();
+			}else{
+				std::size_t n = 0;
+				if(object) {
+					// 跳过 protected / private 属性
+					ZEND_HASH_FOREACH_KEY_VAL_IND(ht, index, key, data) {
+						if(!key || ZSTR_LEN(key) == 0 || ZSTR_VAL(key)[0] != '\0') ++n;
+					} ZEND_HASH_FOREACH_END();
+				}else{
+					n = zend_hash_num_elements(ht);
+				}
+				header(n, 0x80, 15, 0, 0xde);
+				ZEND_HASH_FOREACH_KEY_VAL_IND(ht, index, key, data) {
+					if(key) {
+						if(object && ZSTR_LEN(key) > 0 && ZSTR_VAL(key)[0] == '\0') continue;
+						encode_key(key);
+					}else{
+						encode_long(static_cast<zend_long>(index));
+					}
+					encode(data);
+				} ZEND_HASH_FOREACH_END();
+			}
+			--depth_;
+		}
+	};
+	class msgpack_decoder {
+	public:
+		msgpack_decoder(const char* data, std::size_t size, int flags)
+		: p_(reinterpret_cast<const unsigned char*>(data))
+		, e_(p_ + size)
+		, flags_(flags)
+		, depth_(0) {
+
+		}
+		~msgpack_decoder() {
+			for(auto key : keys_) zend_string_release(key);
+		}
+		// 解码一个值到 rv (失败时抛出异常, rv 保持未定义)
+		void decode(zval* rv) {
+			unsigned char c = byte();
+			if(c < 0x80) {
+				ZVAL_LONG(rv, c);
+			}else if(c >= 0xe0) {
+				ZVAL_LONG(rv, static_cast<std::int8_t>(c));
+			}else if(c >= 0xa0 && c < 0xc0) {
+				decode_string(rv, c & 0x1f);
+			}else if(c < 0x90) {
+				decode_map(rv, c & 0x0f);
+			}else if(c < 0xa0) {
+				decode_list(rv, c & 0x0f);
+			}else switch(c) {
+			case 0xc0:
+				ZVAL_NULL(rv);
+				break;
+			case 0xc2:
+				ZVAL_FALSE(rv);
+				break;
+			case 0xc3:
+				ZVAL_TRUE(rv);
+				break;
+			case 0xc4: // bin 8 / 16 / 32
+			case 0xd9: // str 8 / 16 / 32
+				decode_string(rv, load(1));
+				break;
+			case 0xc5:
+			case 0xda:
+				decode_string(rv, load(2));
+				break;
+			case 0xc6:
+			case 0xdb:
+				decode_string(rv, load(4));
+				break;
+			case 0xca: {
+				std::uint32_t u = static_cast<std::uint32_t>(load(4));
+				float f;
+				std::memcpy(&f, &u, 4);
+				ZVAL_DOUBLE(rv, f);
+				break;
+			}
+			case 0xcb: {
+				std::uint64_t u = load(8);
+				double d;
+				std::memcpy(&d, &u, 8);
+				ZVAL_DOUBLE(rv, d);
+				break;
+			}
+			case 0xcc:
+				ZVAL_LONG(rv, load(1));
+				break;
+			case 0xcd:
+				ZVAL_LONG(rv, load(2));
+				break;
+			case 0xce:
+				ZVAL_LONG(rv, static_cast<zend_long>(load(4)));
+				break;
+			case 0xcf: {
+				std::uint64_t u = load(8);
+				// 超出 zend_long 范围时转为浮点数
+				if(u > static_cast<std::uint64_t>(ZEND_LONG_MAX)) ZVAL_DOUBLE(rv, static_cast<double>(u));
+				else ZVAL_LONG(rv, static_cast<zend_long>(u));
+				break;
+			}
+			case 0xd0:
+				ZVAL_LONG(rv, static_cast<std::int8_t>(load(1)));
+				break;
+			case 0xd1:
+				ZVAL_LONG(rv, static_cast<std::int16_t>(load(2)));
+				break;
+			case 0xd2:
+				ZVAL_LONG(rv, static_cast<std::int32_t>(load(4)));
+				break;
+			case 0xd3:
+				ZVAL_LONG(rv, static_cast<zend_long>(static_cast<std::int64_t>(load(8))));
+				break;
+			case 0xdc:
+				decode_list(rv, load(2));
+				break;
+			case 0xdd:
+				decode_list(rv, load(4));
+				break;
+			case 0xde:
+				decode_map(rv, load(2));
+				break;
+			case 0xdf:
+				decode_map(rv, load(4));
+				break;
+			default:
+				// 扩展类型仅允许出现在键位置
+				error();
+			}
+		}
+		bool done() const {
+			return p_ == e_;
+		}
+	private:
+		const unsigned char* p_;
+		const unsigned char* e_;
+		int                  flags_;
+		int                  depth_;
+		std::vector<zend_string*> keys_; // 可被引用的键 (按首次出现顺序)
+
+		[[noreturn]] void error() {
+			throw php::exception(zend_ce_error, "failed to unpack: malformed data");
+		}
+		const unsigned char* take(std::size_t n) {
+			if(static_cast<std::size_t>(e_ - p_) < n) error();
+			const unsigned char* p = p_;
+			p_ += n;
+			return p;
+		}
+		unsigned char byte() {
+			return *take(1);
+		}
+		std::uint64_t load(int bytes) {
+			return msgpack_load(take(bytes), bytes);
+		}
+		void decode_string(zval* rv, std::size_t n) {
+			const char* s = reinterpret_cast<const char*>(take(n));
+			if(n == 0) ZVAL_EMPTY_STRING(rv);
+			else ZVAL_STRINGL(rv, s, n);
+		}
+		// 元素数量来自输入, 预分配前确认剩余数据足够 (每个元素至少 1 字节), 防止恶意的超大数量
+		void check(std::size_t n, std::size_t min) {
+			if(static_cast<std::size_t>(e_ - p_) / min < n) error();
+			if(++depth_ > msgpack_max_depth) {
+				throw php::exception(zend_ce_error, "failed to unpack: maximum depth exceeded");
+			}
+		}
+		void decode_list(zval* rv, std::size_t n) {
+			check(n, 1);
+			array_init_size(rv, static_cast<std::uint32_t>(n));
+			zend_hash_real_init(Z_ARRVAL_P(rv), 1);
+			try {
+				for(std::size_t i=0; i<n; ++i) {
+					zval v;
+					decode(&v);
+					zend_hash_next_index_insert_new(Z_ARRVAL_P(rv), &v);
+				}
+			}catch(...) {
+				zval_ptr_dtor(rv);
+				throw;
+			}
+			--depth_;
+		}
+		void decode_map(zval* rv, std::size_t n) {
+			check(n, 2);
+			array_init_size(rv, static_cast<std::uint32_t>(n));
+			try {
+				for(std::size_t i=0; i<n; ++i) {
+					zend_string* key = nullptr;
+					zend_long    index;
+					decode_key(key, index);
+					zval v;
+					try {
+						decode(&v);
+					}catch(...) {
+						if(key) zend_string_release(key);
+						throw;
+					}
+					if(key) {
+						zend_symtable_update(Z_ARRVAL_P(rv), key, &v);
+						zend_string_release(key);
+					}else{
+						zend_hash_index_update(Z_ARRVAL_P(rv), index, &v);
+					}
+				}
+			}catch(...) {
+				zval_ptr_dtor(rv);
+				throw;
+			}
+			--depth_;
+		}
+		// 字符串键 (持有引用) 或整数键
+		void decode_key(zend_string*& key, zend_long& index) {
+			unsigned char c = byte();
+			std::size_t n;
+			if(c < 0x80) {
+				index = c;
+				return;
+			}
+			if(c >= 0xe0) {
+				index = static_cast<std::int8_t>(c);
+				return;
+			}
+			if(c >= 0xa0 && c < 0xc0) n = c & 0x1f;
+			else switch(c) {
+			case 0xc4:
+			case 0xd9:
+				n = load(1);
+				break;
+			case 0xc5:
+			case 0xda:
+				n = load(2);
+				break;
+			case 0xc6:
+			case 0xdb:
+				n = load(4);
+				break;
+			case 0xcc:
+			case 0xcd:
+			case 0xce:
+			case 0xcf:
+				index = static_cast<zend_long>(load(1 << (c - 0xcc)));
+				return;
+			case 0xd0:
+				index = static_cast<std::int8_t>(load(1));
+				return;
+			case 0xd1:
+				index = static_cast<std::int16_t>(load(2));
+				return;
+			case 0xd2:
+				index = static_cast<std::int32_t>(load(4));
+				return;
+			case 0xd3:
+				index = static_cast<zend_long>(static_cast<std::int64_t>(load(8)));
+				return;
+			case 0xd4:
+			case 0xd5:
+			case 0xd6: {
+				int bytes = 1 << (c - 0xd4);
+				if(static_cast<char>(byte()) != msgpack_ext_key) error();
+				std::uint64_t i = load(bytes);
+				if(i >= keys_.size()) error();
+				key = zend_string_copy(keys_[i]);
+				return;
+			}
+			default:
+				error();
+			}
+			const char* s = reinterpret_cast<const char*>(take(n));
+			key = zend_string_init(s, n, 0);
+			if(flags_ & MSGPACK_INTERN_KEYS) key = zend_new_interned_string(key);
+			// 解码端无法得知编码时是否去重, 始终按相同规则登记
+			if(n >= msgpack_dedupe_min) keys_.push_back(zend_string_copy(key));
+		}
+	};
+	// ---------------------------------------------------------------------
+	php::string msgpack_pack(const php::value& v, int flags) {
+		smart_str str {nullptr, 0};
+		try {
+			msgpack_encoder encoder(&str, flags);
+			encoder.encode(v);
+		}catch(...) {
+			smart_str_free(&str);
+			throw;
+		}
+		return &str;
+	}
+	void msgpack_pack_to(smart_str* str, const php::value& v, int flags) {
+		std::size_t checkpoint = str->s ? ZSTR_LEN(str->s) : 0;
+		try {
+			msgpack_encoder encoder(str, flags);
+			encoder.encode(v);
+		}catch(...) {
+			if(str->s) ZSTR_LEN(str->s) = checkpoint;
+			throw;
+		}
+	}
+	php::value msgpack_unpack(const char* data, std::size_t size, int flags) {
+		msgpack_decoder decoder(data, size, flags);
+		zval rv;
+		decoder.decode(&rv);
+		php::value v(&rv);
+		zval_ptr_dtor(&rv);
+		if(!decoder.done()) {
+			throw php::exception(zend_ce_error, "failed to unpack: extra data");
+		}
+		return v;
+	}
+	php::value msgpack_unpack(const php::string& str, int flags) {
+		return msgpack_unpack(str.c_str(), str.size(), flags);
+	}
+}
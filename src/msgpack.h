@@ -0,0 +1,22 @@
+#pragma once
+
+#include "value.h"
+#include "string.h"
+
+namespace php {
+	enum msgpack_flag {
+		// 编码: 重复出现的字符串键 (不短于 3 字节) 写为对首次出现位置的引用 (扩展类型 'K'), 标准解码器无法识别
+		MSGPACK_DEDUPE_KEYS = 0x01,
+		// 解码: 字符串键使用 interned 字符串 (请求内共享, 哈希值已缓存; 请求结束时释放, ZTS 下不驻留)
+		MSGPACK_INTERN_KEYS = 0x02,
+	};
+	// MessagePack 编码: 整数/浮点数/字符串/数组类型无损往返; 连续下标 (0..n-1) 的数组编码为 array, 其余为 map
+	// 对象编码为其公开属性构成的 map (解码为数组); 嵌套过深 (含循环引用) 或类型不支持时抛出异常
+	string msgpack_pack(const value& v, int flags = 0);
+	// buffer& -> smart_str*
+	// 失败时写入的数据被撤销
+	void msgpack_pack_to(smart_str* str, const value& v, int flags = 0);
+	// 直接自输入内存解码 (无需复制为 string), 数组按元素数量预先分配; 数据非法或未完全消费时抛出异常
+	value msgpack_unpack(const char* data, std::size_t size, int flags = 0);
+	value msgpack_unpack(const string& str, int flags = 0);
+}
@@ -0,0 +1,24 @@
+#pragma once
+
+#include "string.h"
+#include "array.h"
+
+namespace php {
+	// 解析整数 (进制 2 ~ 36, 字母大小写均可), 可带正负号, 须完整匹配 (不允许空白)
+	// base 为 0 时按前缀识别: 0x / 0o / 0b, 以 0 开头为八进制, 否则为十进制
+	// 格式错误或超出 int64 范围时返回 false
+	bool parse_integer(const char* str, std::size_t len, std::int64_t& v, int base = 10);
+	bool parse_integer(const string& str, std::int64_t& v, int base = 10);
+	// 同 intval($str, $base) (strtol 语义): 跳过前导空白, 解析至首个非法字符, 溢出时取 int64 边界值
+	std::int64_t parse_integer_prefix(const char* str, std::size_t len, int base);
+	// 解析十进制浮点数: [+-]digits[.digits][(e|E)[+-]digits] (".5" / "5." 亦可), 须完整匹配
+	// 结果正确舍入 (同 zend_strtod): 一般情况由 Clinger / Eisel-Lemire 算法直接得出, 少数无法判定的输入回退至 zend_strtod
+	bool parse_float(const char* str, std::size_t len, double& v);
+	bool parse_float(const string& str, double& v);
+	// 批量解析: 依次写入 out, 返回首个解析失败的下标 (全部成功时返回 count)
+	std::size_t parse_integer_batch(const char* const* str, const std::size_t* len, std::size_t count, std::int64_t* out, int base = 10);
+	std::size_t parse_float_batch(const char* const* str, const std::size_t* len, std::size_t count, double* out);
+	// 批量解析数组元素 (按遍历顺序写入 out, 至少 arr.size() 空间): 整数元素直接使用, 解析浮点数时也接受浮点元素
+	std::size_t parse_integer_batch(const array& arr, std::int64_t* out, int base = 10);
+	std::size_t parse_float_batch(const array& arr, double* out);
+}
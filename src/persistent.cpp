@@ -0,0 +1,113 @@
+#include "vendor.h"
+#include "persistent.h"
+#include "exception.h"
+
+namespace php {
+	static const int persistent_max_depth = 512;
+
+	static std::size_t persistent_copy_value(zval* dst, zval* src, int depth);
+	static std::size_t persistent_copy_array(zval* dst, HashTable* src, int depth) {
+		if(depth > persistent_max_depth) throw php::exception(zend_ce_error, "persistent_copy: maximum depth exceeded");
+		HashTable* ht = static_cast<HashTable*>(pemalloc(sizeof(HashTable), 1));
+		// 请求中分离 (zend_array_dup) 得到的副本沿用此析构函数
+		zend_hash_init(ht, zend_hash_num_elements(src), nullptr, ZVAL_PTR_DTOR, 1);
+		zend_hash_real_init(ht, HT_IS_PACKED(src));
+		ZVAL_ARR(dst, ht);
+		std::size_t   bytes = 0;
+		zend_string*  key;
+		zend_ulong    index;
+		zval*         val;
+		try {
+			ZEND_HASH_FOREACH_KEY_VAL_IND(src, index, key, val) {
+				zval v;
+				bytes += persistent_copy_value(&v, val, depth + 1);
+				if(key) {
+					zend_string* k = persistent_string(ZSTR_VAL(key), ZSTR_LEN(key));
+					bytes += _ZSTR_STRUCT_SIZE(ZSTR_LEN(key));
+					zend_hash_add_new(ht, k, &v);
+				}else{
+					zend_hash_index_add_new(ht, index, &v);
+				}
+			} ZEND_HASH_FOREACH_END();
+		}catch(...) {
+			persistent_free(dst);
+			throw;
+		}
+		bytes += sizeof(HashTable) + HT_SIZE(ht);
+#if PHP_VERSION_ID < 70300
+		GC_REFCOUNT(ht) = 2;
+		GC_FLAGS(ht) |= IS_ARRAY_IMMUTABLE;
+		ht->u.flags |= HASH_FLAG_STATIC_KEYS;
+		ht->u.flags &= ~HASH_FLAG_APPLY_PROTECTION;
+		Z_TYPE_FLAGS_P(dst) = IS_TYPE_COPYABLE;
+#else
+		GC_SET_REFCOUNT(ht, 2);
+		GC_ADD_FLAGS(ht, IS_ARRAY_IMMUTABLE);
+		HT_FLAGS(ht) |= HASH_FLAG_STATIC_KEYS;
+		Z_TYPE_FLAGS_P(dst) = 0;
+#endif
+		return bytes;
+	}
+	static std::size_t persistent_copy_value(zval* dst, zval* src, int depth) {
+		ZVAL_DEREF(src);
+		switch(Z_TYPE_P(src)) {
+		case IS_UNDEF:
+		case IS_NULL:
+			ZVAL_NULL(dst);
+			return 0;
+		case IS_FALSE:
+		case IS_TRUE:
+		case IS_LONG:
+		case IS_DOUBLE:
+			ZVAL_COPY_VALUE(dst, src);
+			return 0;
+		case IS_STRING:
+			ZVAL_INTERNED_STR(dst, persistent_string(Z_STRVAL_P(src), Z_STRLEN_P(src)));
+			return _ZSTR_STRUCT_SIZE(Z_STRLEN_P(src));
+		case IS_ARRAY:
+			return persistent_copy_array(dst, Z_ARRVAL_P(src), depth);
+		default:
+			throw php::exception(zend_ce_type_error, "persistent_copy: unsupported type");
+		}
+	}
+	std::size_t persistent_copy(zval* dst, zval* src) {
+		return persistent_copy_value(dst, src, 0);
+	}
+	std::size_t persistent_copy(zval* dst, const value& src) {
+		return persistent_copy_value(dst, static_cast<zval*>(src), 0);
+	}
+	zend_string* persistent_string(const char* str, std::size_t len) {
+		zend_string* s = zend_string_init(str, len, 1);
+		zend_string_hash_val(s);
+#if PHP_VERSION_ID < 70300
+		GC_FLAGS(s) |= IS_STR_INTERNED;
+#else
+		GC_ADD_FLAGS(s, IS_STR_INTERNED);
+#endif
+		return s;
+	}
+	void persistent_free(zend_string* str) {
+		pefree(str, 1);
+	}
+	void persistent_free(zval* val) {
+		switch(Z_TYPE_P(val)) {
+		case IS_STRING:
+			persistent_free(Z_STR_P(val));
+			break;
+		case IS_ARRAY: {
+			HashTable*   ht = Z_ARRVAL_P(val);
+			zend_string* key;
+			zval*        v;
+			ZEND_HASH_FOREACH_STR_KEY_VAL(ht, key, v) {
+				if(key) persistent_free(key);
+				persistent_free(v);
+			} ZEND_HASH_FOREACH_END();
+			// 不经 zend_hash_destroy() (不可变数组的引用计数为 2, 且元素析构须使用 pefree)
+			pefree(HT_GET_DATA_ADDR(ht), 1);
+			pefree(ht, 1);
+			break;
+		}
+		}
+		ZVAL_UNDEF(val);
+	}
+}
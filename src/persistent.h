@@ -0,0 +1,17 @@
+#pragma once
+
+#include "value.h"
+
+namespace php {
+	// 持久 (跨请求) 不可变数据: 字符串标记为 interned, 数组标记为 immutable (同 opcache),
+	// 请求中读取 (复制 zval) 时不修改引用计数; 写入时由引擎自动分离为请求内存中的副本
+	// 仅支持 null / bool / 整数 / 浮点数 / 字符串 / 数组 (引用被解除), 嵌套过深或含对象、资源等时抛出异常
+	// 返回分配的字节数
+	std::size_t persistent_copy(zval* dst, zval* src);
+	std::size_t persistent_copy(zval* dst, const value& src);
+	// 持久 interned 字符串 (哈希值已计算)
+	zend_string* persistent_string(const char* str, std::size_t len);
+	// 释放 persistent_copy() / persistent_string() 生成的数据 (须确保请求中不再引用)
+	void persistent_free(zval* val);
+	void persistent_free(zend_string* str);
+}
@@ -28,9 +28,31 @@
 #include "delegate.h"
 #include "property_entry.h"
 #include "constant_entry.h"
-#include "class_entry.h"
-#include "ini_entry.h"
+#include "ascii.h" // -> string
+#include "class_entry.h" // -> ascii
+#include "module_globals.h"
+#include "ini_entry.h" // -> module_globals
 #include "extension_entry.h"
 #include "util.h"
+#include "datetime.h" // -> string object
+#include "crc32.h" // -> string buffer stream_buffer
+#include "hash.h" // -> string buffer stream_buffer
+#include "digest.h" // -> string buffer stream_buffer
+#include "shm_cache.h" // -> string hash msgpack
+#include "persistent.h"
+#include "lru_cache.h" // -> class_base parameters persistent
+#include "snapshot.h" // -> string
+#include "deferred.h" // -> callable
+#include "thread_pool.h" // -> class_base parameters
+#include "event_loop.h" // -> callable class_base parameters stream_buffer
+#include "base64.h" // -> string buffer stream_buffer
+#include "hex.h" // -> string buffer
+#include "numeric.h" // -> string array
+#include "url.h" // -> string buffer array
+#include "json.h" // -> value string
+#include "json_document.h" // -> value string
+#include "json_parser.h" // -> value stream_buffer
+#include "json_writer.h" // -> value string buffer
+#include "msgpack.h" // -> value string
 #include "ini.h"
 #include "global.h"
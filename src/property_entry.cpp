@@ -1,5 +1,6 @@
 #include "vendor.h"
 #include "property_entry.h"
+#include "persistent.h"
 
 namespace php {
 	property_entry::property_entry(const php::string& name, const php::value& v, int access)
@@ -18,6 +19,9 @@ namespace php {
 			ZVAL_NEW_STR(val_, zend_string_init(s->val, s->len, 1));
 			break;
 		}
+		case IS_ARRAY:
+			persistent_copy(val_, v);
+			break;
 		default:
 			assert(0 && "属性类型受限");
 		}
@@ -29,8 +33,27 @@ namespace php {
 		// entry.acc_ = 0;
 	}
 	void property_entry::declare(zend_class_entry* entry) {
-		zend_declare_property_ex(entry, key_, val_, acc_, nullptr);
+		if(Z_TYPE_P(static_cast<zval*>(val_)) == IS_ARRAY) {
+			// PHP < 7.3 内部类属性默认值不接受数组: 以 null 声明后替换默认值 (不可变数组不计引用, 创建对象时直接复制)
+			std::string name(key_.c_str(), key_.size());
+			zval        n;
+			ZVAL_NULL(&n);
+			zend_declare_property_ex(entry, key_, &n, acc_, nullptr);
+			zend_property_info* info = static_cast<zend_property_info*>(zend_hash_str_find_ptr(&entry->properties_info, name.c_str(), name.size()));
+			ZVAL_COPY_VALUE(&entry->default_properties_table[OBJ_PROP_TO_NUM(info->offset)], static_cast<zval*>(val_));
+		}else{
+			zend_declare_property_ex(entry, key_, val_, acc_, nullptr);
+		}
 		ZVAL_UNDEF(static_cast<zval*>(key_));
 		ZVAL_UNDEF(static_cast<zval*>(val_));
 	}
+	void property_entry::reserve(const string& class_name) {
+		key_ = string(zend_new_interned_string(zend_string_copy(key_)));
+		// 非公开属性以修饰后的名称记录
+		if(acc_ & ZEND_ACC_PRIVATE) {
+			zend_new_interned_string(zend_mangle_property_name(class_name.c_str(), class_name.size(), key_.c_str(), key_.size(), 1));
+		}else if(acc_ & ZEND_ACC_PROTECTED) {
+			zend_new_interned_string(zend_mangle_property_name("*", 1, key_.c_str(), key_.size(), 1));
+		}
+	}
 }
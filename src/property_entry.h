@@ -7,9 +7,12 @@
 namespace php {
 	class property_entry {
 	public:
+		// 默认值限于 null / bool / 整数 / 浮点数 / 字符串 / 数组 (深复制为持久不可变数组)
 		property_entry(const php::string& name, const php::value& v, int access = PUBLIC);
 		property_entry(property_entry&& entry);
 		void declare(zend_class_entry* entry);
+		// 预先生成 interned 属性名 (延迟声明的类, 见 class_entry_base::declare_lazy())
+		void reserve(const string& class_name);
 	private:
 		string key_;
 		value  val_;
@@ -0,0 +1,461 @@
+#include "vendor.h"
+#include "shm_cache.h"
+#include "hash.h"
+#include "msgpack.h"
+#include "exception.h"
+
+namespace php {
+	static const std::uint32_t shm_slot_empty   = 0;
+	static const std::uint32_t shm_slot_deleted = 1; // 合法数据偏移不小于分段头部大小, 不会与标记冲突
+	static const std::uint32_t shm_chunk_free   = 0xffffffff;
+	static const std::uint8_t  shm_page_unused  = 0xff;
+	static const int           shm_max_classes  = 32;
+	static const std::uint32_t shm_min_chunk    = 64;
+	static const std::uint32_t shm_max_page     = 1024 * 1024;
+	static const std::uint32_t shm_min_page     = 4096;
+	// 单次分配 CLOCK 扫描的最多槽数量, 超出后改为整页回收
+	static const std::uint32_t shm_max_scan     = 4096;
+	enum {
+		SHM_ITEM_RAW,
+		SHM_ITEM_MSGPACK,
+	};
+	struct shm_header {
+		std::uint32_t stripes;
+		std::uint32_t page_size;
+		std::uint32_t classes;
+		std::uint32_t chunk[shm_max_classes]; // 各规格的块大小
+		std::size_t   stripe_size;
+	};
+	struct shm_stripe {
+		pthread_mutex_t lock;
+		std::uint32_t   slots;      // 哈希表槽数量 (2 的幂)
+		std::uint32_t   live;
+		std::uint32_t   deleted;    // 删除标记数量
+		std::uint32_t   hand;       // CLOCK 指针 (槽下标)
+		std::uint32_t   pages;
+		std::uint32_t   pages_used;
+		std::uint32_t   page_hand;  // 整页回收指针
+		std::uint32_t   data;       // 首页偏移
+		std::uint32_t   free[shm_max_classes]; // 各规格的空闲块链表
+		std::uint64_t   hits;
+		std::uint64_t   misses;
+		std::uint64_t   evictions;
+		std::uint64_t   expired;
+	};
+	struct shm_slot {
+		std::uint32_t tag; // 哈希高位
+		std::uint32_t off; // 数据相对分段起始的偏移
+	};
+	struct shm_item {
+		std::uint32_t klen;   // shm_chunk_free 为空闲块
+		std::uint32_t vlen;   // 空闲块: 下一空闲块偏移
+		std::uint64_t hash;
+		std::uint32_t expire; // UNIX 时间 (秒), 0 为不过期
+		std::uint8_t  cls;
+		std::uint8_t  ref;    // CLOCK 访问位
+		std::uint8_t  type;
+		std::uint8_t  reserved;
+
+		char* key() {
+			return reinterpret_cast<char*>(this + 1);
+		}
+		char* data() {
+			return key() + klen;
+		}
+	};
+	static inline std::size_t shm_align(std::size_t n, std::size_t a) {
+		return (n + a - 1) & ~(a - 1);
+	}
+	static inline shm_slot* shm_slots(shm_stripe* s) {
+		return reinterpret_cast<shm_slot*>(s + 1);
+	}
+	static inline std::uint8_t* shm_page_class(shm_stripe* s) {
+		return reinterpret_cast<std::uint8_t*>(shm_slots(s) + s->slots);
+	}
+	static inline shm_item* shm_item_at(shm_stripe* s, std::uint32_t off) {
+		return reinterpret_cast<shm_item*>(reinterpret_cast<char*>(s) + off);
+	}
+	static inline std::uint32_t shm_page_off(shm_header* h, shm_stripe* s, std::uint32_t page) {
+		return s->data + page * h->page_size;
+	}
+	static inline shm_stripe* shm_stripe_of(shm_header* h, std::uint64_t hash) {
+		char* base = reinterpret_cast<char*>(h) + shm_align(sizeof(shm_header), 64);
+		return reinterpret_cast<shm_stripe*>(base + ((hash >> 48) & (h->stripes - 1)) * h->stripe_size);
+	}
+	static inline shm_stripe* shm_stripe_at(shm_header* h, std::uint32_t i) {
+		char* base = reinterpret_cast<char*>(h) + shm_align(sizeof(shm_header), 64);
+		return reinterpret_cast<shm_stripe*>(base + i * h->stripe_size);
+	}
+	static int shm_class_of(shm_header* h, std::size_t size) {
+		for(std::uint32_t i=0; i<h->classes; ++i) {
+			if(size <= h->chunk[i]) return i;
+		}
+		return -1;
+	}
+	static void shm_stripe_reset(shm_stripe* s) {
+		std::memset(shm_slots(s), 0, sizeof(shm_slot) * s->slots);
+		std::memset(shm_page_class(s), shm_page_unused, s->pages);
+		std::memset(s->free, 0, sizeof(s->free));
+		s->live = 0;
+		s->deleted = 0;
+		s->hand = 0;
+		s->pages_used = 0;
+		s->page_hand = 0;
+	}
+	// 加锁; 前一持有者异常退出时数据可能不完整, 清空该分段
+	static bool shm_lock(shm_stripe* s) {
+		int r = pthread_mutex_lock(&s->lock);
+		if(r == EOWNERDEAD) {
+			shm_stripe_reset(s);
+			pthread_mutex_consistent(&s->lock);
+			return true;
+		}
+		return r == 0;
+	}
+	static void shm_unlock(shm_stripe* s) {
+		pthread_mutex_unlock(&s->lock);
+	}
+	class shm_guard {
+	public:
+		shm_guard(shm_stripe* s)
+		: s_(s)
+		, locked_(shm_lock(s)) {}
+		~shm_guard() {
+			if(locked_) shm_unlock(s_);
+		}
+		operator bool() const {
+			return locked_;
+		}
+	private:
+		shm_stripe* s_;
+		bool        locked_;
+	};
+	static void shm_chunk_release(shm_stripe* s, std::uint32_t off) {
+		shm_item* item = shm_item_at(s, off);
+		item->klen = shm_chunk_free;
+		item->vlen = s->free[item->cls];
+		s->free[item->cls] = off;
+	}
+	static std::uint32_t shm_find(shm_stripe* s, std::uint64_t hash, const char* key, std::size_t klen) {
+		shm_slot*     slots = shm_slots(s);
+		std::uint32_t mask = s->slots - 1, tag = static_cast<std::uint32_t>(hash >> 32);
+		for(std::uint32_t i = hash & mask;; i = (i + 1) & mask) {
+			if(slots[i].off == shm_slot_empty) return shm_slot_empty;
+			if(slots[i].off == shm_slot_deleted || slots[i].tag != tag) continue;
+			shm_item* item = shm_item_at(s, slots[i].off);
+			if(item->hash == hash && item->klen == klen && std::memcmp(item->key(), key, klen) == 0) {
+				return i + 1; // 槽下标 + 1, 与 shm_slot_empty 区分
+			}
+		}
+	}
+	// 移除槽 i 处的数据
+	static void shm_erase(shm_stripe* s, std::uint32_t i) {
+		shm_slot* slots = shm_slots(s);
+		shm_chunk_release(s, slots[i].off);
+		--s->live;
+		// 后继为空时探测链在此终止, 无需删除标记
+		if(slots[(i + 1) & (s->slots - 1)].off == shm_slot_empty) {
+			slots[i].off = shm_slot_empty;
+		}else{
+			slots[i].off = shm_slot_deleted;
+			++s->deleted;
+		}
+	}
+	static void shm_insert(shm_stripe* s, std::uint64_t hash, std::uint32_t off) {
+		shm_slot*     slots = shm_slots(s);
+		std::uint32_t mask = s->slots - 1, i = hash & mask;
+		while(slots[i].off > shm_slot_deleted) i = (i + 1) & mask;
+		if(slots[i].off == shm_slot_deleted) --s->deleted;
+		slots[i].tag = static_cast<std::uint32_t>(hash >> 32);
+		slots[i].off = off;
+		++s->live;
+	}
+	// 清除删除标记
+	static void shm_rehash(shm_stripe* s) {
+		shm_slot* slots = shm_slots(s);
+		std::vector<std::uint32_t> live;
+		live.reserve(s->live);
+		for(std::uint32_t i=0; i<s->slots; ++i) {
+			if(slots[i].off > shm_slot_deleted) live.push_back(slots[i].off);
+		}
+		std::memset(slots, 0, sizeof(shm_slot) * s->slots);
+		s->live = 0;
+		s->deleted = 0;
+		for(auto i=live.begin(); i!=live.end(); ++i) {
+			shm_insert(s, shm_item_at(s, *i)->hash, *i);
+		}
+	}
+	// CLOCK: 淘汰一项 (cls < 0 时不限规格), 过期数据随扫描一并清除
+	static bool shm_evict(shm_stripe* s, int cls, std::uint32_t now) {
+		shm_slot*     slots = shm_slots(s);
+		std::uint32_t mask = s->slots - 1;
+		std::uint32_t scan = std::min(s->slots * 2, shm_max_scan);
+		for(std::uint32_t n=0; n<scan; ++n) {
+			std::uint32_t i = s->hand;
+			s->hand = (i + 1) & mask;
+			if(slots[i].off <= shm_slot_deleted) continue;
+			shm_item* item = shm_item_at(s, slots[i].off);
+			if(item->expire && item->expire <= now) {
+				bool match = cls < 0 || item->cls == cls;
+				shm_erase(s, i);
+				++s->expired;
+				if(match) return true;
+			}else if(cls < 0 || item->cls == cls) {
+				if(item->ref) {
+					item->ref = 0;
+				}else{
+					shm_erase(s, i);
+					++s->evictions;
+					return true;
+				}
+			}
+		}
+		return false;
+	}
+	static void shm_carve(shm_header* h, shm_stripe* s, std::uint32_t page, int cls) {
+		std::uint32_t off = shm_page_off(h, s, page), size = h->chunk[cls];
+		shm_page_class(s)[page] = cls;
+		for(std::uint32_t n = h->page_size / size; n > 0; --n, off += size) {
+			shm_item_at(s, off)->cls = cls;
+			shm_chunk_release(s, off);
+		}
+	}
+	// 整页回收: 淘汰其他规格的一页数据, 改为 cls 规格
+	static bool shm_reassign(shm_header* h, shm_stripe* s, int cls) {
+		std::uint8_t* page_class = shm_page_class(s);
+		std::uint32_t page = s->pages;
+		for(std::uint32_t n=0; n<s->pages_used; ++n) {
+			std::uint32_t i = s->page_hand;
+			s->page_hand = (i + 1) % s->pages_used;
+			if(page_class[i] != cls) {
+				page = i;
+				break;
+			}
+		}
+		if(page == s->pages) return false;
+		int           old = page_class[page];
+		std::uint32_t begin = shm_page_off(h, s, page), end = begin + h->page_size, size = h->chunk[old];
+		shm_slot*     slots = shm_slots(s);
+		std::uint32_t mask = s->slots - 1;
+		for(std::uint32_t off = begin; off + size <= end; off += size) {
+			shm_item* item = shm_item_at(s, off);
+			if(item->klen == shm_chunk_free) continue;
+			std::uint32_t i = item->hash & mask;
+			while(slots[i].off != off) i = (i + 1) & mask;
+			shm_erase(s, i);
+			++s->evictions;
+		}
+		// 自空闲链表中摘除该页的块
+		for(std::uint32_t* p = &s->free[old]; *p;) {
+			if(*p >= begin && *p < end) *p = shm_item_at(s, *p)->vlen;
+			else p = &shm_item_at(s, *p)->vlen;
+		}
+		shm_carve(h, s, page, cls);
+		return true;
+	}
+	static std::uint32_t shm_alloc(shm_header* h, shm_stripe* s, int cls, std::uint32_t now) {
+		if(!s->free[cls]) {
+			if(s->pages_used < s->pages) shm_carve(h, s, s->pages_used++, cls);
+			else if(!shm_evict(s, cls, now) && !shm_reassign(h, s, cls)) return 0;
+		}
+		std::uint32_t off = s->free[cls];
+		s->free[cls] = shm_item_at(s, off)->vlen;
+		return off;
+	}
+	static inline std::uint32_t shm_now() {
+		return static_cast<std::uint32_t>(std::time(nullptr));
+	}
+
+	shm_cache::shm_cache(std::size_t size, std::size_t stripes) {
+		std::size_t n = 1;
+		while(n < stripes) n <<= 1;
+		std::size_t head = shm_align(sizeof(shm_header), 64), stripe = (size - std::min(size, head)) / n & ~std::size_t(63);
+		// 分段内偏移为 32 位
+		while(stripe > 0x80000000) {
+			n <<= 1;
+			stripe = (size - head) / n & ~std::size_t(63);
+		}
+		std::uint32_t slots = 64, page_size = shm_max_page;
+		// 哈希表按数据区全部为最小规格块时的项数计算, 装载率不超过 3/4
+		while((stripe - std::min<std::size_t>(stripe, sizeof(shm_slot) * slots)) / shm_min_chunk > slots / 4 * 3) slots <<= 1;
+		std::size_t fixed = sizeof(shm_stripe) + sizeof(shm_slot) * slots;
+		std::size_t remain = stripe > fixed ? stripe - fixed : 0;
+		while(page_size > shm_min_page && remain / page_size < 8) page_size >>= 1;
+		// 每页另占 1 字节记录规格
+		std::size_t pages = remain / (page_size + 1);
+		while(pages > 0 && shm_align(fixed + pages, 64) + pages * page_size > stripe) --pages;
+		if(pages < 2) throw php::exception(zend_ce_error, "shm_cache: size too small");
+
+		size_ = head + n * stripe;
+		void* base = ::mmap(nullptr, size_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+		if(base == MAP_FAILED) throw php::exception(zend_ce_error, "shm_cache: failed to map shared memory");
+		base_ = static_cast<char*>(base);
+
+		shm_header* h = reinterpret_cast<shm_header*>(base_);
+		h->stripes     = n;
+		h->page_size   = page_size;
+		h->stripe_size = stripe;
+		h->classes     = 0;
+		// 块大小: 64, 96, 128, 192, 256 ... page_size
+		for(std::uint32_t c = shm_min_chunk; c <= page_size; c <<= 1) {
+			h->chunk[h->classes++] = c;
+			if(c + c / 2 <= page_size) h->chunk[h->classes++] = c + c / 2;
+		}
+		pthread_mutexattr_t attr;
+		pthread_mutexattr_init(&attr);
+		pthread_mutexattr_setpshared(&attr, PTHREAD_PROCESS_SHARED);
+		pthread_mutexattr_setrobust(&attr, PTHREAD_MUTEX_ROBUST);
+		for(std::uint32_t i=0; i<n; ++i) {
+			shm_stripe* s = shm_stripe_at(h, i);
+			pthread_mutex_init(&s->lock, &attr);
+			s->slots = slots;
+			s->pages = pages;
+			s->data  = shm_align(fixed + pages, 64);
+			s->hits = s->misses = s->evictions = s->expired = 0;
+			shm_stripe_reset(s);
+		}
+		pthread_mutexattr_destroy(&attr);
+	}
+	shm_cache::~shm_cache() {
+		// 其他进程可能仍在使用, 不销毁锁
+		::munmap(base_, size_);
+	}
+	bool shm_cache::store(const char* key, std::size_t klen, const char* data, std::size_t size, std::uint32_t ttl, int type) {
+		shm_header* h = reinterpret_cast<shm_header*>(base_);
+		std::size_t need = sizeof(shm_item) + klen + size;
+		if(need > h->page_size) return false;
+		int           cls = shm_class_of(h, need);
+		std::uint64_t hash = xxh64(key, klen);
+		shm_stripe*   s = shm_stripe_of(h, hash);
+		std::uint32_t now = shm_now();
+
+		shm_guard guard(s);
+		if(!guard) return false;
+		std::uint32_t i = shm_find(s, hash, key, klen);
+		// 装载率不超过 3/4 (替换已存在的项时数量不变)
+		if(!i && (s->live + s->deleted + 1) * 4 > s->slots * 3) {
+			if(s->deleted > 0) shm_rehash(s);
+			if((s->live + 1) * 4 > s->slots * 3 && !shm_evict(s, -1, now)) return false;
+		}
+		// 先分配再移除旧数据: 分配失败时保留原有的值
+		std::uint32_t off = shm_alloc(h, s, cls, now);
+		if(!off) return false;
+		// 分配时可能已淘汰旧数据, 重新查找
+		i = shm_find(s, hash, key, klen);
+		if(i) shm_erase(s, i - 1);
+		shm_item* item = shm_item_at(s, off);
+		item->klen   = klen;
+		item->vlen   = size;
+		item->hash   = hash;
+		item->expire = ttl ? now + ttl : 0;
+		item->ref    = 0;
+		item->type   = type;
+		std::memcpy(item->key(), key, klen);
+		std::memcpy(item->data(), data, size);
+		shm_insert(s, hash, off);
+		return true;
+	}
+	bool shm_cache::fetch(const char* key, std::size_t klen, std::string* data, int* type) {
+		shm_header*   h = reinterpret_cast<shm_header*>(base_);
+		std::uint64_t hash = xxh64(key, klen);
+		shm_stripe*   s = shm_stripe_of(h, hash);
+
+		shm_guard guard(s);
+		if(!guard) return false;
+		std::uint32_t i = shm_find(s, hash, key, klen);
+		if(!i) {
+			++s->misses;
+			return false;
+		}
+		shm_item* item = shm_item_at(s, shm_slots(s)[i - 1].off);
+		if(item->expire && item->expire <= shm_now()) {
+			shm_erase(s, i - 1);
+			++s->expired;
+			++s->misses;
+			return false;
+		}
+		item->ref = 1;
+		++s->hits;
+		// 复制后即释放锁, 反序列化在锁外进行
+		if(data) data->assign(item->data(), item->vlen);
+		if(type) *type = item->type;
+		return true;
+	}
+	bool shm_cache::set(const char* key, std::size_t klen, const value& val, std::uint32_t ttl) {
+		string packed = msgpack_pack(val);
+		return store(key, klen, packed.c_str(), packed.size(), ttl, SHM_ITEM_MSGPACK);
+	}
+	bool shm_cache::set(const string& key, const value& val, std::uint32_t ttl) {
+		return set(key.c_str(), key.size(), val, ttl);
+	}
+	bool shm_cache::get(const char* key, std::size_t klen, value& val) {
+		std::string data;
+		int         type;
+		if(!fetch(key, klen, &data, &type)) return false;
+		if(type == SHM_ITEM_MSGPACK) val = msgpack_unpack(data.data(), data.size());
+		else val = string(data);
+		return true;
+	}
+	bool shm_cache::get(const string& key, value& val) {
+		return get(key.c_str(), key.size(), val);
+	}
+	value shm_cache::get(const string& key) {
+		value val(nullptr);
+		get(key.c_str(), key.size(), val);
+		return val;
+	}
+	bool shm_cache::set_raw(const char* key, std::size_t klen, const char* data, std::size_t size, std::uint32_t ttl) {
+		return store(key, klen, data, size, ttl, SHM_ITEM_RAW);
+	}
+	bool shm_cache::get_raw(const char* key, std::size_t klen, std::string& data) {
+		return fetch(key, klen, &data, nullptr);
+	}
+	bool shm_cache::exists(const char* key, std::size_t klen) {
+		return fetch(key, klen, nullptr, nullptr);
+	}
+	bool shm_cache::exists(const string& key) {
+		return exists(key.c_str(), key.size());
+	}
+	bool shm_cache::remove(const char* key, std::size_t klen) {
+		shm_header*   h = reinterpret_cast<shm_header*>(base_);
+		std::uint64_t hash = xxh64(key, klen);
+		shm_stripe*   s = shm_stripe_of(h, hash);
+
+		shm_guard guard(s);
+		if(!guard) return false;
+		std::uint32_t i = shm_find(s, hash, key, klen);
+		if(!i) return false;
+		shm_erase(s, i - 1);
+		return true;
+	}
+	bool shm_cache::remove(const string& key) {
+		return remove(key.c_str(), key.size());
+	}
+	void shm_cache::clear() {
+		shm_header* h = reinterpret_cast<shm_header*>(base_);
+		for(std::uint32_t i=0; i<h->stripes; ++i) {
+			shm_stripe* s = shm_stripe_at(h, i);
+			shm_guard guard(s);
+			if(guard) shm_stripe_reset(s);
+		}
+	}
+	shm_cache::stats_t shm_cache::stats() const {
+		shm_header* h = reinterpret_cast<shm_header*>(base_);
+		stats_t st {size_, 0, 0, 0, 0, 0, 0};
+		for(std::uint32_t i=0; i<h->stripes; ++i) {
+			shm_stripe* s = shm_stripe_at(h, i);
+			shm_guard guard(s);
+			if(!guard) continue;
+			st.memory    += static_cast<std::size_t>(s->pages_used) * h->page_size;
+			st.entries   += s->live;
+			st.hits      += s->hits;
+			st.misses    += s->misses;
+			st.evictions += s->evictions;
+			st.expired   += s->expired;
+		}
+		return st;
+	}
+	std::size_t shm_cache::max_item() const {
+		return reinterpret_cast<shm_header*>(base_)->page_size - sizeof(shm_item);
+	}
+}
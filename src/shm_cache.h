@@ -0,0 +1,54 @@
+#pragma once
+
+#include "value.h"
+#include "string.h"
+
+namespace php {
+	// 跨进程共享内存键值缓存 (如 PHP-FPM 各工作进程间共享路由表、配置等派生数据)
+	// 须在 fork 之前 (on_module_startup) 创建, 子进程继承同一匿名共享映射; 析构仅解除当前进程的映射
+	// 内存划分为若干分段, 各自持有 (进程间、持有者崩溃可恢复的) 锁、开放寻址哈希表及 slab 分配器;
+	// 空间不足时按 CLOCK (近似 LRU) 淘汰同规格的数据, 仍不足时整页回收其他规格的数据
+	class shm_cache {
+	public:
+		struct stats_t {
+			std::size_t   size;      // 共享内存总大小
+			std::size_t   memory;    // 已分配给数据的页大小
+			std::size_t   entries;
+			std::uint64_t hits;
+			std::uint64_t misses;
+			std::uint64_t evictions; // 因空间不足淘汰
+			std::uint64_t expired;
+		};
+		// stripes: 分段 (锁) 数量, 向上取整为 2 的幂
+		explicit shm_cache(std::size_t size, std::size_t stripes = 16);
+		~shm_cache();
+		shm_cache(const shm_cache& c) = delete;
+		shm_cache& operator =(const shm_cache& c) = delete;
+		// 值以 MessagePack 序列化存储 (同 msgpack_pack(), 类型不支持时抛出异常)
+		// ttl: 有效秒数, 0 为不过期; 空间不足或单项 (键 + 值) 超过 max_item() 时返回 false (已存在的值保留)
+		bool set(const char* key, std::size_t klen, const value& val, std::uint32_t ttl = 0);
+		bool set(const string& key, const value& val, std::uint32_t ttl = 0);
+		// 不存在或已过期时返回 false
+		bool get(const char* key, std::size_t klen, value& val);
+		bool get(const string& key, value& val);
+		// 不存在或已过期时返回 null
+		value get(const string& key);
+		// 原始数据 (以 get() 读取时为字符串)
+		bool set_raw(const char* key, std::size_t klen, const char* data, std::size_t size, std::uint32_t ttl = 0);
+		bool get_raw(const char* key, std::size_t klen, std::string& data);
+		bool exists(const char* key, std::size_t klen);
+		bool exists(const string& key);
+		bool remove(const char* key, std::size_t klen);
+		bool remove(const string& key);
+		void clear();
+		stats_t stats() const;
+		// 单项 (键 + 值) 的最大长度
+		std::size_t max_item() const;
+	private:
+		char*       base_;
+		std::size_t size_;
+
+		bool store(const char* key, std::size_t klen, const char* data, std::size_t size, std::uint32_t ttl, int type);
+		bool fetch(const char* key, std::size_t klen, std::string* data, int* type);
+	};
+}
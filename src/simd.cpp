@@ -0,0 +1,35 @@
+#include "vendor.h"
+#include "simd.h"
+
+#ifdef PHPEXT_SIMD_X86
+#include <cpuid.h>
+#endif
+
+namespace php {
+	static std::uint32_t cpu_detect() {
+		std::uint32_t fs = 0;
+#ifdef PHPEXT_SIMD_X86
+		unsigned int eax, ebx, ecx, edx;
+		if(!__get_cpuid(1, &eax, &ebx, &ecx, &edx)) return 0;
+		if(edx & (1u << 26)) fs |= 1u << static_cast<int>(cpu_feature::SSE2);
+		if(ecx & (1u <<  9)) fs |= 1u << static_cast<int>(cpu_feature::SSSE3);
+		if(ecx & (1u << 19)) fs |= 1u << static_cast<int>(cpu_feature::SSE41);
+		if(ecx & (1u << 20)) fs |= 1u << static_cast<int>(cpu_feature::SSE42);
+		if(ecx & (1u <<  1)) fs |= 1u << static_cast<int>(cpu_feature::PCLMUL);
+		// AVX2 还需要操作系统保存 YMM 寄存器状态 (OSXSAVE + XCR0)
+		if((ecx & (1u << 27)) && (ecx & (1u << 28))) {
+			unsigned int xlo, xhi;
+			__asm__ volatile("xgetbv" : "=a"(xlo), "=d"(xhi) : "c"(0));
+			if((xlo & 0x06) == 0x06 && __get_cpuid_max(0, nullptr) >= 7) {
+				__cpuid_count(7, 0, eax, ebx, ecx, edx);
+				if(ebx & (1u << 5)) fs |= 1u << static_cast<int>(cpu_feature::AVX2);
+			}
+		}
+#endif
+		return fs;
+	}
+	bool cpu_support(cpu_feature f) {
+		static std::uint32_t fs = cpu_detect();
+		return fs & (1u << static_cast<int>(f));
+	}
+}
@@ -0,0 +1,22 @@
+#pragma once
+
+// 内部头文件: 仅由实现文件引用 (不包含在 phpext.h 中)
+#if defined(__x86_64__) || defined(__i386__)
+#define PHPEXT_SIMD_X86 1
+#include <immintrin.h>
+// 单独为函数开启指令集 (运行时检测 CPU 支持后才会被调用)
+#define PHPEXT_TARGET(t) __attribute__((target(t)))
+#endif
+
+namespace php {
+	enum class cpu_feature {
+		SSE2,
+		SSSE3,
+		SSE41,
+		SSE42,
+		PCLMUL,
+		AVX2,
+	};
+	// 运行时检测 CPU 特性支持 (首次调用时检测并缓存)
+	bool cpu_support(cpu_feature f);
+}
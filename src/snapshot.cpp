@@ -0,0 +1,476 @@
+#include "vendor.h"
+#include "snapshot.h"
+#include "persistent.h"
+#include "exception.h"
+
+namespace php {
+	static const char          snapshot_magic[8] = {'P', 'H', 'P', 'X', 'S', 'N', 'A', 'P'};
+	static const std::uint32_t snapshot_version = 1;
+	static const int           snapshot_max_depth = 512;
+	enum {
+		SNAPSHOT_NULL,
+		SNAPSHOT_FALSE,
+		SNAPSHOT_TRUE,
+		SNAPSHOT_LONG,
+		SNAPSHOT_DOUBLE,
+		SNAPSHOT_STRING,
+		SNAPSHOT_LIST, // 下标为 0..n-1 的数组
+		SNAPSHOT_MAP,
+	};
+	// 文件中所有记录按 8 字节对齐, 偏移均相对文件起始
+	struct snapshot_slot {
+		std::uint32_t type;
+		std::uint32_t reserved;
+		std::uint64_t payload; // 整数 / 浮点数位模式 / 字符串或数组记录的偏移
+	};
+	struct snapshot_header {
+		char          magic[8];
+		std::uint32_t version;
+		std::uint32_t php_version; // PHP_VERSION_ID
+		std::uint32_t string_size; // sizeof(zend_string)
+		std::uint32_t reserved;
+		std::uint64_t size;
+		snapshot_slot root;
+	};
+	// 数组记录: 其后为 count 个元素 (LIST: snapshot_slot, MAP: snapshot_entry);
+	// MAP 随后为 buckets 个开放寻址索引 (元素下标 + 1, 0 为空)
+	struct snapshot_array {
+		std::uint32_t count;
+		std::uint32_t buckets;
+	};
+	struct snapshot_entry {
+		std::uint64_t key;    // 整数键 / 字符串键记录的偏移
+		std::uint32_t string; // 字符串键
+		std::uint32_t hash;   // 字符串键为 zend_string 哈希值的低 32 位
+		snapshot_slot val;
+	};
+	// 字符串记录即 zend_string (persistent + interned, 哈希值已计算)
+
+	static inline std::uint32_t snapshot_index_hash(std::int64_t key) {
+		std::uint64_t x = static_cast<std::uint64_t>(key);
+		x ^= x >> 33;
+		x *= 0xff51afd7ed558ccdull;
+		x ^= x >> 33;
+		return static_cast<std::uint32_t>(x);
+	}
+	static inline const snapshot_array* snapshot_array_at(const char* base, std::uint64_t off) {
+		return reinterpret_cast<const snapshot_array*>(base + off);
+	}
+	static inline const snapshot_slot* snapshot_items(const snapshot_array* a) {
+		return reinterpret_cast<const snapshot_slot*>(a + 1);
+	}
+	static inline const snapshot_entry* snapshot_entries(const snapshot_array* a) {
+		return reinterpret_cast<const snapshot_entry*>(a + 1);
+	}
+	static inline const std::uint32_t* snapshot_index(const snapshot_array* a) {
+		return reinterpret_cast<const std::uint32_t*>(snapshot_entries(a) + a->count);
+	}
+	static inline zend_string* snapshot_string_at(const char* base, std::uint64_t off) {
+		return reinterpret_cast<zend_string*>(const_cast<char*>(base + off));
+	}
+	static void snapshot_materialize(zval* dst, const char* base, const snapshot_slot* slot) {
+		switch(slot->type) {
+		case SNAPSHOT_FALSE:
+			ZVAL_FALSE(dst);
+			break;
+		case SNAPSHOT_TRUE:
+			ZVAL_TRUE(dst);
+			break;
+		case SNAPSHOT_LONG:
+			ZVAL_LONG(dst, static_cast<zend_long>(slot->payload));
+			break;
+		case SNAPSHOT_DOUBLE: {
+			double d;
+			std::memcpy(&d, &slot->payload, sizeof(d));
+			ZVAL_DOUBLE(dst, d);
+			break;
+		}
+		case SNAPSHOT_STRING:
+			ZVAL_INTERNED_STR(dst, snapshot_string_at(base, slot->payload));
+			break;
+		case SNAPSHOT_LIST: {
+			const snapshot_array* a = snapshot_array_at(base, slot->payload);
+			const snapshot_slot*  items = snapshot_items(a);
+			array_init_size(dst, a->count);
+			zend_hash_real_init(Z_ARRVAL_P(dst), 1);
+			for(std::uint32_t i=0; i<a->count; ++i) {
+				zval v;
+				snapshot_materialize(&v, base, &items[i]);
+				zend_hash_next_index_insert_new(Z_ARRVAL_P(dst), &v);
+			}
+			break;
+		}
+		case SNAPSHOT_MAP: {
+			const snapshot_array* a = snapshot_array_at(base, slot->payload);
+			const snapshot_entry* entries = snapshot_entries(a);
+			array_init_size(dst, a->count);
+			for(std::uint32_t i=0; i<a->count; ++i) {
+				zval v;
+				snapshot_materialize(&v, base, &entries[i].val);
+				// 键为 interned 字符串, 不复制
+				if(entries[i].string) zend_hash_add_new(Z_ARRVAL_P(dst), snapshot_string_at(base, entries[i].key), &v);
+				else zend_hash_index_add_new(Z_ARRVAL_P(dst), static_cast<zend_ulong>(entries[i].key), &v);
+			}
+			break;
+		}
+		default:
+			ZVAL_NULL(dst);
+		}
+	}
+
+	snapshot_node::snapshot_node()
+	: base_(nullptr)
+	, slot_(nullptr) {}
+	snapshot_node::snapshot_node(const char* base, const snapshot_slot* slot)
+	: base_(base)
+	, slot_(slot) {}
+	bool snapshot_node::exists() const {
+		return slot_ != nullptr;
+	}
+	snapshot_node::operator bool() const {
+		return slot_ != nullptr;
+	}
+	TYPE snapshot_node::type_of() const {
+		if(!slot_) return TYPE::UNDEFINED;
+		switch(slot_->type) {
+		case SNAPSHOT_FALSE:
+			return TYPE::NO;
+		case SNAPSHOT_TRUE:
+			return TYPE::YES;
+		case SNAPSHOT_LONG:
+			return TYPE::INTEGER;
+		case SNAPSHOT_DOUBLE:
+			return TYPE::FLOAT;
+		case SNAPSHOT_STRING:
+			return TYPE::STRING;
+		case SNAPSHOT_LIST:
+		case SNAPSHOT_MAP:
+			return TYPE::ARRAY;
+		default:
+			return TYPE::NULLABLE;
+		}
+	}
+	snapshot_node snapshot_node::find(const char* key, std::size_t len, zend_ulong h) const {
+		if(!slot_ || slot_->type != SNAPSHOT_MAP) return snapshot_node();
+		const snapshot_array* a = snapshot_array_at(base_, slot_->payload);
+		if(a->count == 0) return snapshot_node();
+		const snapshot_entry* entries = snapshot_entries(a);
+		const std::uint32_t*  index = snapshot_index(a);
+		std::uint32_t hash = static_cast<std::uint32_t>(h), mask = a->buckets - 1;
+		for(std::uint32_t i = hash & mask; index[i]; i = (i + 1) & mask) {
+			const snapshot_entry& e = entries[index[i] - 1];
+			if(!e.string || e.hash != hash) continue;
+			zend_string* s = snapshot_string_at(base_, e.key);
+			if(ZSTR_LEN(s) == len && std::memcmp(ZSTR_VAL(s), key, len) == 0) return snapshot_node(base_, &e.val);
+		}
+		return snapshot_node();
+	}
+	snapshot_node snapshot_node::operator [](const char* key) const {
+		std::size_t len = std::strlen(key);
+		zend_ulong  idx;
+		// 数字字符串键同 PHP 数组转换为整数下标
+		if(ZEND_HANDLE_NUMERIC_STR_EX(key, len, idx)) return (*this)[static_cast<std::int64_t>(idx)];
+		return find(key, len, zend_inline_hash_func(key, len));
+	}
+	snapshot_node snapshot_node::operator [](const string& key) const {
+		zend_string* s = key;
+		zend_ulong   idx;
+		if(ZEND_HANDLE_NUMERIC_STR_EX(ZSTR_VAL(s), ZSTR_LEN(s), idx)) return (*this)[static_cast<std::int64_t>(idx)];
+		return find(ZSTR_VAL(s), ZSTR_LEN(s), zend_string_hash_val(s));
+	}
+	snapshot_node snapshot_node::operator [](std::int64_t idx) const {
+		if(!slot_) return snapshot_node();
+		if(slot_->type == SNAPSHOT_LIST) {
+			const snapshot_array* a = snapshot_array_at(base_, slot_->payload);
+			if(idx < 0 || idx >= a->count) return snapshot_node();
+			return snapshot_node(base_, &snapshot_items(a)[idx]);
+		}
+		if(slot_->type != SNAPSHOT_MAP) return snapshot_node();
+		const snapshot_array* a = snapshot_array_at(base_, slot_->payload);
+		if(a->count == 0) return snapshot_node();
+		const snapshot_entry* entries = snapshot_entries(a);
+		const std::uint32_t*  index = snapshot_index(a);
+		std::uint32_t hash = snapshot_index_hash(idx), mask = a->buckets - 1;
+		for(std::uint32_t i = hash & mask; index[i]; i = (i + 1) & mask) {
+			const snapshot_entry& e = entries[index[i] - 1];
+			if(!e.string && static_cast<std::int64_t>(e.key) == idx) return snapshot_node(base_, &e.val);
+		}
+		return snapshot_node();
+	}
+	snapshot_node snapshot_node::operator [](int idx) const {
+		return (*this)[static_cast<std::int64_t>(idx)];
+	}
+	std::size_t snapshot_node::size() const {
+		if(!slot_) return 0;
+		switch(slot_->type) {
+		case SNAPSHOT_STRING:
+			return ZSTR_LEN(snapshot_string_at(base_, slot_->payload));
+		case SNAPSHOT_LIST:
+		case SNAPSHOT_MAP:
+			return snapshot_array_at(base_, slot_->payload)->count;
+		default:
+			return 0;
+		}
+	}
+	bool snapshot_node::to_boolean() const {
+		return slot_ && slot_->type == SNAPSHOT_TRUE;
+	}
+	std::int64_t snapshot_node::to_integer() const {
+		if(!slot_) return 0;
+		if(slot_->type == SNAPSHOT_LONG) return static_cast<std::int64_t>(slot_->payload);
+		if(slot_->type == SNAPSHOT_DOUBLE) return static_cast<std::int64_t>(to_float());
+		return 0;
+	}
+	double snapshot_node::to_float() const {
+		if(!slot_) return 0;
+		if(slot_->type == SNAPSHOT_DOUBLE) {
+			double d;
+			std::memcpy(&d, &slot_->payload, sizeof(d));
+			return d;
+		}
+		if(slot_->type == SNAPSHOT_LONG) return static_cast<double>(static_cast<std::int64_t>(slot_->payload));
+		return 0;
+	}
+	const char* snapshot_node::data() const {
+		if(!slot_ || slot_->type != SNAPSHOT_STRING) return nullptr;
+		return ZSTR_VAL(snapshot_string_at(base_, slot_->payload));
+	}
+	value snapshot_node::to_value() const {
+		if(!slot_) return value(nullptr);
+		zval rv;
+		snapshot_materialize(&rv, base_, slot_);
+		value v(&rv);
+		zval_ptr_dtor(&rv);
+		return v;
+	}
+	snapshot_node_iterator snapshot_node::begin() const {
+		return snapshot_node_iterator(*this, 0);
+	}
+	snapshot_node_iterator snapshot_node::end() const {
+		bool array = slot_ && (slot_->type == SNAPSHOT_LIST || slot_->type == SNAPSHOT_MAP);
+		return snapshot_node_iterator(*this, array ? size() : 0);
+	}
+
+	snapshot_node_iterator::snapshot_node_iterator(const snapshot_node& node, std::uint32_t i)
+	: node_(node)
+	, i_(i) {
+
+	}
+	void snapshot_node_iterator::create() {
+		const snapshot_array* a = snapshot_array_at(node_.base_, node_.slot_->payload);
+		if(node_.slot_->type == SNAPSHOT_LIST) {
+			entry_.reset(new value_type {static_cast<std::int64_t>(i_), snapshot_node(node_.base_, &snapshot_items(a)[i_])});
+		}else{
+			const snapshot_entry& e = snapshot_entries(a)[i_];
+			if(e.string) entry_.reset(new value_type {value(snapshot_string_at(node_.base_, e.key)), snapshot_node(node_.base_, &e.val)});
+			else entry_.reset(new value_type {static_cast<std::int64_t>(e.key), snapshot_node(node_.base_, &e.val)});
+		}
+	}
+	snapshot_node_iterator& snapshot_node_iterator::operator++() {
+		++i_;
+		entry_.reset();
+		return *this;
+	}
+	snapshot_node_iterator snapshot_node_iterator::operator++(int) {
+		snapshot_node_iterator ni = *this;
+		++(*this);
+		return ni;
+	}
+	snapshot_node_iterator::value_type& snapshot_node_iterator::operator*() {
+		if(!entry_) create();
+		return *entry_;
+	}
+	snapshot_node_iterator::value_type* snapshot_node_iterator::operator->() {
+		if(!entry_) create();
+		return entry_.get();
+	}
+	bool snapshot_node_iterator::operator==(const snapshot_node_iterator& ni) const {
+		return node_.slot_ == ni.node_.slot_ && i_ == ni.i_;
+	}
+	bool snapshot_node_iterator::operator!=(const snapshot_node_iterator& ni) const {
+		return node_.slot_ != ni.node_.slot_ || i_ != ni.i_;
+	}
+
+	snapshot::snapshot(const std::string& path) {
+		int fd = ::open(path.c_str(), O_RDONLY);
+		if(fd == -1) throw php::exception(zend_ce_error, "snapshot: failed to open file");
+		struct stat st;
+		if(::fstat(fd, &st) == -1 || static_cast<std::size_t>(st.st_size) < sizeof(snapshot_header)) {
+			::close(fd);
+			throw php::exception(zend_ce_error, "snapshot: invalid file");
+		}
+		size_ = st.st_size;
+		// 写时复制的私有映射: 引擎可能在 interned 字符串上设置标记 (如 UTF-8 校验结果), 未写入的页仍在进程间共享
+		void* base = ::mmap(nullptr, size_, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+		::close(fd);
+		if(base == MAP_FAILED) throw php::exception(zend_ce_error, "snapshot: failed to map file");
+		base_ = static_cast<char*>(base);
+		const snapshot_header* h = reinterpret_cast<const snapshot_header*>(base_);
+		if(std::memcmp(h->magic, snapshot_magic, sizeof(snapshot_magic)) != 0 || h->version != snapshot_version || h->size != size_) {
+			::munmap(base_, size_);
+			throw php::exception(zend_ce_error, "snapshot: invalid file");
+		}
+		if(h->php_version != PHP_VERSION_ID || h->string_size != sizeof(zend_string)) {
+			::munmap(base_, size_);
+			throw php::exception(zend_ce_error, "snapshot: file was built by a different PHP version");
+		}
+	}
+	snapshot::~snapshot() {
+		::munmap(base_, size_);
+	}
+	snapshot_node snapshot::root() const {
+		return snapshot_node(base_, &reinterpret_cast<const snapshot_header*>(base_)->root);
+	}
+	snapshot_node snapshot::operator [](const char* key) const {
+		return root()[key];
+	}
+	snapshot_node snapshot::operator [](const string& key) const {
+		return root()[key];
+	}
+	snapshot_node snapshot::operator [](std::int64_t idx) const {
+		return root()[idx];
+	}
+	snapshot_node snapshot::operator [](int idx) const {
+		return root()[idx];
+	}
+	std::size_t snapshot::size() const {
+		return size_;
+	}
+
+	snapshot_builder::snapshot_builder(const value& root) {
+		snapshot_header h;
+		std::memset(&h, 0, sizeof(h));
+		append(&h, sizeof(h));
+		snapshot_slot slot;
+		encode(static_cast<zval*>(root), slot, 0);
+		std::memcpy(h.magic, snapshot_magic, sizeof(snapshot_magic));
+		h.version     = snapshot_version;
+		h.php_version = PHP_VERSION_ID;
+		h.string_size = sizeof(zend_string);
+		h.size        = data_.size();
+		h.root        = slot;
+		std::memcpy(&data_[0], &h, sizeof(h));
+	}
+	const std::string& snapshot_builder::data() const {
+		return data_;
+	}
+	void snapshot_builder::save(const std::string& path) const {
+		std::string tmp = path + ".tmp." + std::to_string(::getpid());
+		int fd = ::open(tmp.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+		if(fd == -1) throw php::exception(zend_ce_error, "snapshot: failed to create file");
+		for(std::size_t n = 0; n < data_.size();) {
+			ssize_t r = ::write(fd, data_.data() + n, data_.size() - n);
+			if(r == -1 && errno == EINTR) continue;
+			if(r <= 0) {
+				::close(fd);
+				::unlink(tmp.c_str());
+				throw php::exception(zend_ce_error, "snapshot: failed to write file");
+			}
+			n += r;
+		}
+		if(::close(fd) == -1 || std::rename(tmp.c_str(), path.c_str()) == -1) {
+			::unlink(tmp.c_str());
+			throw php::exception(zend_ce_error, "snapshot: failed to write file");
+		}
+	}
+	std::uint64_t snapshot_builder::append(const void* data, std::size_t size) {
+		std::uint64_t off = data_.size();
+		data_.append(static_cast<const char*>(data), size);
+		data_.append((8 - size % 8) % 8, '\0');
+		return off;
+	}
+	std::uint64_t snapshot_builder::encode_string(const char* str, std::size_t len) {
+		std::pair<std::map<std::string, std::uint64_t>::iterator, bool> r = strings_.insert({std::string(str, len), 0});
+		if(r.second) {
+			zend_string* s = persistent_string(str, len);
+			r.first->second = append(s, _ZSTR_STRUCT_SIZE(len));
+			persistent_free(s);
+		}
+		return r.first->second;
+	}
+	void snapshot_builder::encode(zval* val, snapshot_slot& slot, int depth) {
+		ZVAL_DEREF(val);
+		slot.reserved = 0;
+		slot.payload  = 0;
+		switch(Z_TYPE_P(val)) {
+		case IS_UNDEF:
+		case IS_NULL:
+			slot.type = SNAPSHOT_NULL;
+			break;
+		case IS_FALSE:
+			slot.type = SNAPSHOT_FALSE;
+			break;
+		case IS_TRUE:
+			slot.type = SNAPSHOT_TRUE;
+			break;
+		case IS_LONG:
+			slot.type    = SNAPSHOT_LONG;
+			slot.payload = static_cast<std::uint64_t>(Z_LVAL_P(val));
+			break;
+		case IS_DOUBLE:
+			slot.type = SNAPSHOT_DOUBLE;
+			std::memcpy(&slot.payload, &Z_DVAL_P(val), sizeof(double));
+			break;
+		case IS_STRING:
+			slot.type    = SNAPSHOT_STRING;
+			slot.payload = encode_string(Z_STRVAL_P(val), Z_STRLEN_P(val));
+			break;
+		case IS_ARRAY: {
+			if(depth > snapshot_max_depth) throw php::exception(zend_ce_error, "snapshot: maximum depth exceeded");
+			HashTable*     ht = Z_ARRVAL_P(val);
+			snapshot_array a {zend_hash_num_elements(ht), 0};
+			zend_string*   key;
+			zend_ulong     index, next = 0;
+			zval*          v;
+			bool           list = true;
+			ZEND_HASH_FOREACH_KEY(ht, index, key) {
+				if(key || index != next++) {
+					list = false;
+					break;
+				}
+			} ZEND_HASH_FOREACH_END();
+			std::uint32_t i = 0;
+			if(list) {
+				std::vector<snapshot_slot> items(a.count);
+				ZEND_HASH_FOREACH_VAL_IND(ht, v) {
+					encode(v, items[i++], depth + 1);
+				} ZEND_HASH_FOREACH_END();
+				slot.type    = SNAPSHOT_LIST;
+				slot.payload = append(&a, sizeof(a));
+				append(items.data(), sizeof(snapshot_slot) * a.count);
+				break;
+			}
+			std::vector<snapshot_entry> entries(a.count);
+			ZEND_HASH_FOREACH_KEY_VAL_IND(ht, index, key, v) {
+				snapshot_entry& e = entries[i++];
+				if(key) {
+					e.key    = encode_string(ZSTR_VAL(key), ZSTR_LEN(key));
+					e.string = 1;
+					e.hash   = static_cast<std::uint32_t>(zend_string_hash_val(key));
+				}else{
+					e.key    = index;
+					e.string = 0;
+					e.hash   = snapshot_index_hash(static_cast<std::int64_t>(index));
+				}
+				encode(v, e.val, depth + 1);
+			} ZEND_HASH_FOREACH_END();
+			// 装载率不超过 1/2
+			a.buckets = 2;
+			while(a.buckets < a.count * 2) a.buckets <<= 1;
+			std::vector<std::uint32_t> idx(a.buckets, 0);
+			for(std::uint32_t j=0; j<a.count; ++j) {
+				std::uint32_t b = entries[j].hash & (a.buckets - 1);
+				while(idx[b]) b = (b + 1) & (a.buckets - 1);
+				idx[b] = j + 1;
+			}
+			slot.type    = SNAPSHOT_MAP;
+			slot.payload = append(&a, sizeof(a));
+			append(entries.data(), sizeof(snapshot_entry) * a.count);
+			append(idx.data(), sizeof(std::uint32_t) * a.buckets);
+			break;
+		}
+		default:
+			throw php::exception(zend_ce_type_error, "snapshot: unsupported type");
+		}
+	}
+}
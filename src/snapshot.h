@@ -0,0 +1,103 @@
+#pragma once
+
+#include "value.h"
+#include "string.h"
+
+namespace php {
+	class snapshot;
+	class snapshot_node_iterator;
+	struct snapshot_slot;
+	// 快照中某个值的只读视图 (不持有数据, 须在 snapshot 生命周期内使用)
+	class snapshot_node {
+	public:
+		snapshot_node(); // 不存在的节点
+		bool exists() const;
+		operator bool() const;
+		// NULLABLE / YES / NO / INTEGER / FLOAT / STRING / ARRAY
+		TYPE type_of() const;
+		// 关联数组按键查找 (哈希索引), 列表按下标查找; 类型不符或不存在时返回不存在的节点
+		snapshot_node operator [](const char* key) const;
+		snapshot_node operator [](const string& key) const;
+		snapshot_node operator [](std::int64_t idx) const;
+		snapshot_node operator [](int idx) const;
+		// 数组元素数量, 字符串长度
+		std::size_t size() const;
+		// 标量读取 (类型不符时为 0 / false)
+		bool         to_boolean() const;
+		std::int64_t to_integer() const;
+		double       to_float() const;
+		// 字符串视图 (非字符串时为 nullptr)
+		const char*  data() const;
+		// 字符串直接引用映射中的 interned zend_string (不复制); 数组物化为 PHP 数组 (键、字符串元素同样不复制)
+		value to_value() const;
+		// 遍历数组: first 为下标或键, second 为元素节点
+		snapshot_node_iterator begin() const;
+		snapshot_node_iterator end() const;
+	private:
+		snapshot_node(const char* base, const snapshot_slot* slot);
+		snapshot_node find(const char* key, std::size_t len, zend_ulong h) const;
+
+		const char*          base_;
+		const snapshot_slot* slot_;
+
+		friend class snapshot;
+		friend class snapshot_node_iterator;
+	};
+	class snapshot_node_iterator {
+	public:
+		typedef std::pair<value, snapshot_node> value_type;
+		typedef value_type& reference;
+		typedef value_type* pointer;
+
+		snapshot_node_iterator& operator++();
+		snapshot_node_iterator  operator++(int);
+		value_type& operator*();
+		value_type* operator->();
+		bool operator==(const snapshot_node_iterator& ni) const;
+		bool operator!=(const snapshot_node_iterator& ni) const;
+	private:
+		snapshot_node_iterator(const snapshot_node& node, std::uint32_t i);
+		void create();
+
+		snapshot_node   node_;
+		std::uint32_t   i_;
+		std::shared_ptr<value_type> entry_;
+
+		friend class snapshot_node;
+	};
+	// 只读数据快照: 以 mmap (MAP_PRIVATE) 映射由 snapshot_builder 生成的文件, 查找与遍历无需解析,
+	// 各工作进程共享同一份物理页; 文件格式与 PHP 版本相关 (字符串按 zend_string 布局存储), 不匹配时抛出异常
+	// 物化的 PHP 值引用映射内存, 快照须在其被引用期间 (通常为进程生命周期) 保持有效
+	class snapshot {
+	public:
+		explicit snapshot(const std::string& path);
+		~snapshot();
+		snapshot(const snapshot& s) = delete;
+		snapshot& operator =(const snapshot& s) = delete;
+		snapshot_node root() const;
+		snapshot_node operator [](const char* key) const;
+		snapshot_node operator [](const string& key) const;
+		snapshot_node operator [](std::int64_t idx) const;
+		snapshot_node operator [](int idx) const;
+		// 文件大小
+		std::size_t size() const;
+	private:
+		char*       base_;
+		std::size_t size_;
+	};
+	// 快照生成: 仅支持 null / bool / 整数 / 浮点数 / 字符串 / 数组 (引用被解除), 相同字符串只存储一份
+	class snapshot_builder {
+	public:
+		explicit snapshot_builder(const value& root);
+		const std::string& data() const;
+		// 写入临时文件后原子替换 (rename), 已映射旧文件的进程不受影响; 失败时抛出异常
+		void save(const std::string& path) const;
+	private:
+		std::string                          data_;
+		std::map<std::string, std::uint64_t> strings_; // 字符串 -> 偏移
+
+		void encode(zval* val, snapshot_slot& slot, int depth);
+		std::uint64_t encode_string(const char* str, std::size_t len);
+		std::uint64_t append(const void* data, std::size_t size);
+	};
+}
@@ -0,0 +1,288 @@
+#include "vendor.h"
+#include "thread_pool.h"
+#include "class_entry.h"
+#include "exception.h"
+
+namespace php {
+	struct thread_pool_worker {
+		thread_pool*                       pool;
+		std::size_t                        index;
+		pthread_t                          thread;
+		std::mutex                         mutex;
+		std::deque<std::function<void ()>> tasks;
+	};
+	static thread_pool*                     thread_pool_global = nullptr;
+	static std::mutex                       thread_pool_mutex; // 保护 thread_pool_list
+	static std::vector<thread_pool*>        thread_pool_list;
+	static thread_local thread_pool_worker* thread_pool_current = nullptr; // 当前工作线程
+
+	thread_pool::thread_pool(std::size_t threads)
+	: cond_(new std::condition_variable())
+	, pending_(0)
+	, next_(0)
+	, stop_(false)
+	, pid_(0) {
+		assert(threads > 0);
+		for(std::size_t i=0; i<threads; ++i) {
+			workers_.emplace_back(new thread_pool_worker);
+			workers_.back()->pool  = this;
+			workers_.back()->index = i;
+		}
+		static std::once_flag once;
+		std::call_once(once, [] () {
+			pthread_atfork(on_fork_prepare, on_fork_parent, on_fork_child);
+		});
+		{
+			std::lock_guard<std::mutex> lock(thread_pool_mutex);
+			thread_pool_list.push_back(this);
+		}
+		std::lock_guard<std::mutex> lock(mutex_);
+		launch();
+	}
+	thread_pool::~thread_pool() {
+		{
+			std::lock_guard<std::mutex> lock(thread_pool_mutex);
+			thread_pool_list.erase(std::find(thread_pool_list.begin(), thread_pool_list.end(), this));
+		}
+		{
+			std::lock_guard<std::mutex> lock(mutex_);
+			stop_ = true;
+		}
+		cond_->notify_all();
+		// 子进程中未重新启动时不存在工作线程
+		if(pid_ != getpid()) return;
+		for(auto i=workers_.begin(); i!=workers_.end(); ++i) pthread_join((*i)->thread, nullptr);
+	}
+	// 须持有 mutex_
+	void thread_pool::launch() {
+		pid_ = getpid();
+		// 信号由请求线程处理 (超时等)
+		sigset_t all, old;
+		sigfillset(&all);
+		pthread_sigmask(SIG_SETMASK, &all, &old);
+		for(auto i=workers_.begin(); i!=workers_.end(); ++i) {
+			int r = pthread_create(&(*i)->thread, nullptr, routine, i->get());
+			assert(r == 0 && "创建线程失败");
+		}
+		pthread_sigmask(SIG_SETMASK, &old, nullptr);
+	}
+	void* thread_pool::routine(void* data) {
+		thread_pool_worker* w = static_cast<thread_pool_worker*>(data);
+		w->pool->run(w);
+		return nullptr;
+	}
+	void thread_pool::run(thread_pool_worker* w) {
+		thread_pool_current = w;
+		std::function<void ()> task;
+		while(true) {
+			if(pop(w, task) || steal(w, task)) {
+				--pending_;
+				try {
+					task();
+				}catch(...) {}
+				task = nullptr;
+				continue;
+			}
+			std::unique_lock<std::mutex> lock(mutex_);
+			cond_->wait(lock, [this] () {
+				return stop_ || pending_ > 0;
+			});
+			if(stop_ && pending_ == 0) break;
+		}
+	}
+	bool thread_pool::pop(thread_pool_worker* w, std::function<void ()>& task) {
+		std::lock_guard<std::mutex> lock(w->mutex);
+		if(w->tasks.empty()) return false;
+		task = std::move(w->tasks.back());
+		w->tasks.pop_back();
+		return true;
+	}
+	bool thread_pool::steal(thread_pool_worker* w, std::function<void ()>& task) {
+		for(std::size_t i=1; i<workers_.size(); ++i) {
+			thread_pool_worker* v = workers_[(w->index + i) % workers_.size()].get();
+			std::lock_guard<std::mutex> lock(v->mutex);
+			if(v->tasks.empty()) continue;
+			task = std::move(v->tasks.front());
+			v->tasks.pop_front();
+			return true;
+		}
+		return false;
+	}
+	void thread_pool::submit(std::function<void ()> task) {
+		if(pid_ != getpid()) {
+			std::lock_guard<std::mutex> lock(mutex_);
+			if(pid_ != getpid()) launch();
+		}
+		thread_pool_worker* w = thread_pool_current && thread_pool_current->pool == this
+			? thread_pool_current : workers_[next_++ % workers_.size()].get();
+		{
+			std::lock_guard<std::mutex> lock(w->mutex);
+			w->tasks.push_back(std::move(task));
+		}
+		++pending_;
+		// 确保等待中的工作线程已进入等待 (或将观察到 pending_ 变化)
+		{
+			std::lock_guard<std::mutex> lock(mutex_);
+		}
+		cond_->notify_one();
+	}
+	std::size_t thread_pool::size() const {
+		return workers_.size();
+	}
+	thread_pool* thread_pool::global() {
+		return thread_pool_global;
+	}
+	// fork 时持有全部锁, 保证子进程中的状态一致
+	void thread_pool::on_fork_prepare() {
+		thread_pool_mutex.lock();
+		for(auto i=thread_pool_list.begin(); i!=thread_pool_list.end(); ++i) {
+			(*i)->mutex_.lock();
+			for(auto j=(*i)->workers_.begin(); j!=(*i)->workers_.end(); ++j) (*j)->mutex.lock();
+		}
+	}
+	void thread_pool::on_fork_parent() {
+		for(auto i=thread_pool_list.begin(); i!=thread_pool_list.end(); ++i) {
+			for(auto j=(*i)->workers_.begin(); j!=(*i)->workers_.end(); ++j) (*j)->mutex.unlock();
+			(*i)->mutex_.unlock();
+		}
+		thread_pool_mutex.unlock();
+	}
+	void thread_pool::on_fork_child() {
+		for(auto i=thread_pool_list.begin(); i!=thread_pool_list.end(); ++i) {
+			for(auto j=(*i)->workers_.begin(); j!=(*i)->workers_.end(); ++j) {
+				(*j)->tasks.clear();
+				(*j)->mutex.unlock();
+			}
+			(*i)->pending_ = 0;
+			// 条件变量可能记录了父进程中的等待线程, 弃用
+			(*i)->cond_.release();
+			(*i)->cond_.reset(new std::condition_variable());
+			(*i)->mutex_.unlock();
+		}
+		thread_pool_mutex.unlock();
+	}
+	void thread_pool::start(std::size_t threads) {
+		thread_pool_global = new thread_pool(threads);
+	}
+	void thread_pool::stop() {
+		delete thread_pool_global;
+		thread_pool_global = nullptr;
+	}
+
+	enum {
+		THREAD_POOL_PENDING,
+		THREAD_POOL_RUNNING,
+		THREAD_POOL_DONE,
+		THREAD_POOL_FAILED,
+		THREAD_POOL_CANCELLED,
+	};
+	struct thread_pool_state {
+		std::mutex              mutex;
+		std::condition_variable cond;
+		int                     status;
+		std::string             error;
+		std::function<value ()> deliver;
+	};
+	// 当前请求中创建的任务 (请求结束时取消)
+#ifdef ZTS
+	static thread_local std::vector<std::weak_ptr<thread_pool_state>> thread_pool_requested;
+#else
+	static std::vector<std::weak_ptr<thread_pool_state>> thread_pool_requested;
+#endif
+	static bool thread_pool_cancel(thread_pool_state* s) {
+		{
+			std::lock_guard<std::mutex> lock(s->mutex);
+			if(s->status != THREAD_POOL_PENDING && s->status != THREAD_POOL_RUNNING) return false;
+			s->status = THREAD_POOL_CANCELLED;
+		}
+		s->cond.notify_all();
+		return true;
+	}
+	value thread_pool_future::create(std::function<void ()> run, std::function<value ()> deliver) {
+		thread_pool* pool = thread_pool::global();
+		if(!pool) throw php::exception(zend_ce_error, "thread_pool: not configured (see extension_entry::threads())");
+		if(!class_entry<thread_pool_future>::entry()) throw php::exception(zend_ce_error, "thread_pool: class_entry<thread_pool_future> not registered");
+		std::shared_ptr<thread_pool_state> s = std::make_shared<thread_pool_state>();
+		s->status  = THREAD_POOL_PENDING;
+		s->deliver = deliver;
+		value obj(class_entry<thread_pool_future>::entry());
+		static_cast<thread_pool_future*>(native(Z_OBJ_P(static_cast<zval*>(obj))))->state_ = s;
+		// 清理已结束的任务, 避免长时间运行的请求中无限增长
+		if(thread_pool_requested.size() >= 64 && thread_pool_requested.size() == thread_pool_requested.capacity()) {
+			thread_pool_requested.erase(std::remove_if(thread_pool_requested.begin(), thread_pool_requested.end(),
+				[] (const std::weak_ptr<thread_pool_state>& w) { return w.expired(); }), thread_pool_requested.end());
+		}
+		thread_pool_requested.push_back(s);
+		pool->submit([s, run] () {
+			{
+				std::lock_guard<std::mutex> lock(s->mutex);
+				if(s->status != THREAD_POOL_PENDING) return;
+				s->status = THREAD_POOL_RUNNING;
+			}
+			std::string error;
+			bool        ok = true;
+			try {
+				run();
+			}catch(const std::exception& e) {
+				ok = false;
+				error = e.what();
+			}catch(...) {
+				ok = false;
+				error = "unknown exception";
+			}
+			{
+				std::lock_guard<std::mutex> lock(s->mutex);
+				// 执行中被取消时丢弃结果
+				if(s->status == THREAD_POOL_RUNNING) {
+					s->status = ok ? THREAD_POOL_DONE : THREAD_POOL_FAILED;
+					s->error  = error;
+				}
+			}
+			s->cond.notify_all();
+		});
+		return obj;
+	}
+	value thread_pool_future::async(std::function<std::string ()> fn) {
+		return async<std::string>(fn, [] (std::string& r) -> value {
+			return r;
+		});
+	}
+	thread_pool_state* thread_pool_future::state() const {
+		if(!state_) throw php::exception(zend_ce_error, "thread_pool: future not created by thread_pool_future::async()");
+		return state_.get();
+	}
+	value thread_pool_future::wait(parameters& params) {
+		thread_pool_state* s = state();
+		double timeout = params.size() > 0 ? params[0].to_float() : -1;
+		std::unique_lock<std::mutex> lock(s->mutex);
+		auto finished = [s] () {
+			return s->status >= THREAD_POOL_DONE;
+		};
+		if(timeout < 0) s->cond.wait(lock, finished);
+		else if(!s->cond.wait_for(lock, std::chrono::duration<double>(timeout), finished)) return nullptr;
+		if(s->status == THREAD_POOL_FAILED) throw php::exception(zend_ce_error, "thread_pool: " + s->error);
+		if(s->status == THREAD_POOL_CANCELLED) throw php::exception(zend_ce_error, "thread_pool: task cancelled");
+		lock.unlock();
+		// 首次等待时在请求线程中转换
+		if(s->deliver) {
+			result_ = s->deliver();
+			s->deliver = nullptr;
+		}
+		return result_;
+	}
+	value thread_pool_future::done(parameters& params) {
+		thread_pool_state* s = state();
+		std::lock_guard<std::mutex> lock(s->mutex);
+		return s->status >= THREAD_POOL_DONE;
+	}
+	value thread_pool_future::cancel(parameters& params) {
+		return thread_pool_cancel(state());
+	}
+	void thread_pool_future::request_shutdown() {
+		for(auto i=thread_pool_requested.begin(); i!=thread_pool_requested.end(); ++i) {
+			std::shared_ptr<thread_pool_state> s = i->lock();
+			if(s) thread_pool_cancel(s.get());
+		}
+		thread_pool_requested.clear();
+	}
+}
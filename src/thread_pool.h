@@ -0,0 +1,78 @@
+#pragma once
+
+#include "value.h"
+#include "class_base.h"
+#include "parameters.h"
+
+namespace php {
+	struct thread_pool_worker;
+	struct thread_pool_state;
+	// 工作窃取线程池: 每个工作线程持有任务队列 (自身后进先出, 窃取先进先出); 工作线程屏蔽所有信号
+	// 任务仅可访问普通 C++ 数据 (std::string 等), 不可访问 PHP 数据; 任务抛出的异常被忽略
+	// fork 后的子进程 (如 FPM 工作进程) 于首次提交任务时重新启动工作线程, 父进程中尚未执行的任务不在子进程中执行
+	class thread_pool {
+	public:
+		explicit thread_pool(std::size_t threads);
+		// 执行完已提交的任务后结束各工作线程
+		~thread_pool();
+		thread_pool(const thread_pool& p) = delete;
+		thread_pool& operator =(const thread_pool& p) = delete;
+		// 在工作线程中提交时加入当前线程的队列, 否则轮流加入各线程的队列
+		void submit(std::function<void ()> task);
+		std::size_t size() const;
+		// 由 extension_entry::threads() 配置的线程池 (模块启动时创建, 模块关闭时结束), 未配置时为 nullptr
+		static thread_pool* global();
+	private:
+		std::vector<std::unique_ptr<thread_pool_worker>> workers_;
+		std::mutex                                       mutex_;
+		std::unique_ptr<std::condition_variable>         cond_; // fork 后在子进程中重建
+		std::atomic<std::size_t>                         pending_;
+		std::atomic<std::size_t>                         next_;
+		bool                                             stop_;
+		pid_t                                            pid_;  // 工作线程所在进程
+
+		void launch();
+		void run(thread_pool_worker* w);
+		bool pop(thread_pool_worker* w, std::function<void ()>& task);
+		bool steal(thread_pool_worker* w, std::function<void ()>& task);
+		static void* routine(void* data);
+		static void on_fork_prepare();
+		static void on_fork_parent();
+		static void on_fork_child();
+		// 由 extension_entry 调用
+		static void start(std::size_t threads);
+		static void stop();
+		friend class extension_entry;
+	};
+	// 线程池任务的结果, 须以 class_entry<thread_pool_future> 注册为 PHP 类 (创建实例由 async() 完成):
+	// wait(float $timeout = -1) 等待并返回结果 (超时返回 null, 任务失败或被取消时抛出异常), done(): bool, cancel(): bool
+	// 当前请求中未完成的任务于请求结束时取消 (尚未开始的任务不再执行, 执行中的任务结果被丢弃)
+	class thread_pool_future: public class_base {
+	public:
+		// fn 在线程池 (thread_pool::global()) 中执行; convert 在请求线程中于首次 wait() 时将结果转换为 PHP 值
+		// fn、convert 均不可持有 PHP 数据 (可能在工作线程中销毁)
+		template <class R>
+		static value async(std::function<R ()> fn, std::function<value (R& r)> convert) {
+			std::shared_ptr<R> result = std::make_shared<R>();
+			return create([fn, result] () {
+				*result = fn();
+			}, [convert, result] () -> value {
+				return convert(*result);
+			});
+		}
+		// 结果为字符串
+		static value async(std::function<std::string ()> fn);
+		value wait(parameters& params);
+		value done(parameters& params);
+		value cancel(parameters& params);
+	private:
+		std::shared_ptr<thread_pool_state> state_;
+		value                              result_;
+
+		thread_pool_state* state() const;
+		static value create(std::function<void ()> run, std::function<value ()> deliver);
+		// 由 extension_entry 调用
+		static void request_shutdown();
+		friend class extension_entry;
+	};
+}
@@ -0,0 +1,373 @@
+#include "vendor.h"
+#include "url.h"
+#include "simd.h"
+
+namespace php {
+	static const char url_hex[] = "0123456789ABCDEF";
+	// 批量函数: 返回已处理的输入长度, out 指向输出结束位置
+	typedef std::size_t (*url_encode_fn)(char*& out, const unsigned char* src, std::size_t len, bool raw);
+	typedef std::size_t (*url_decode_fn)(char*& out, const char* src, std::size_t len, bool raw);
+
+	static inline int url_xdigit(unsigned char c) {
+		if(c >= '0' && c <= '9') return c - '0';
+		c |= 0x20;
+		if(c >= 'a' && c <= 'f') return c - 'a' + 10;
+		return -1;
+	}
+	// 与 php_url_encode / php_raw_url_encode 保持一致的单字节编码
+	static inline char* url_encode_byte(char* out, unsigned char c, bool raw) {
+		if((c >= '0' && c <= '9') || (c >= 'A' && c <= 'Z') || (c >= 'a' && c <= 'z')
+			|| c == '-' || c == '.' || c == '_' || (raw && c == '~')) {
+			*out++ = c;
+		}else if(c == ' ' && !raw) {
+			*out++ = '+';
+		}else{
+			out[0] = '%';
+			out[1] = url_hex[c >> 4];
+			out[2] = url_hex[c & 0x0f];
+			out += 3;
+		}
+		return out;
+	}
+	// 处理一个特殊字符 ('%' 或 '+'), 返回消费的输入长度
+	static inline std::size_t url_decode_special(char*& out, const char* src, std::size_t len) {
+		if(src[0] == '+') {
+			*out++ = ' ';
+			return 1;
+		}
+		int h, l;
+		if(len > 2 && (h = url_xdigit(src[1])) >= 0 && (l = url_xdigit(src[2])) >= 0) {
+			*out++ = static_cast<char>((h << 4) | l);
+			return 3;
+		}
+		*out++ = '%';
+		return 1;
+	}
+	static std::size_t url_encode_none(char*& out, const unsigned char* src, std::size_t len, bool raw) {
+		return 0;
+	}
+	static std::size_t url_decode_none(char*& out, const char* src, std::size_t len, bool raw) {
+		return 0;
+	}
+#ifdef PHPEXT_SIMD_X86
+	// 闭区间 [lo, hi] 判定
+	PHPEXT_TARGET("sse2")
+	static inline __m128i url_range(__m128i c, char lo, char hi) {
+		__m128i d = _mm_sub_epi8(c, _mm_set1_epi8(lo));
+		return _mm_cmpeq_epi8(_mm_min_epu8(d, _mm_set1_epi8(hi - lo)), d);
+	}
+	// 无需转义的字符掩码
+	PHPEXT_TARGET("sse2")
+	static inline int url_safe_mask(__m128i c, bool raw) {
+		__m128i safe = _mm_or_si128(url_range(c, '0', '9'), url_range(_mm_or_si128(c, _mm_set1_epi8(0x20)), 'a', 'z'));
+		safe = _mm_or_si128(safe, _mm_cmpeq_epi8(c, _mm_set1_epi8('-')));
+		safe = _mm_or_si128(safe, _mm_cmpeq_epi8(c, _mm_set1_epi8('.')));
+		safe = _mm_or_si128(safe, _mm_cmpeq_epi8(c, _mm_set1_epi8('_')));
+		if(raw) safe = _mm_or_si128(safe, _mm_cmpeq_epi8(c, _mm_set1_epi8('~')));
+		return _mm_movemask_epi8(safe);
+	}
+	PHPEXT_TARGET("sse2")
+	static std::size_t url_encode_sse2(char*& out, const unsigned char* src, std::size_t len, bool raw) {
+		std::size_t n = 0;
+		for(; len - n >= 16; n += 16) {
+			__m128i c = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + n));
+			int mask = url_safe_mask(c, raw);
+			if(mask == 0xFFFF) {
+				_mm_storeu_si128(reinterpret_cast<__m128i*>(out), c);
+				out += 16;
+				continue;
+			}
+			for(int i=0;i<16;++i) {
+				if(mask & (1 << i)) *out++ = src[n + i];
+				else out = url_encode_byte(out, src[n + i], raw);
+			}
+		}
+		return n;
+	}
+	PHPEXT_TARGET("avx2")
+	static std::size_t url_encode_avx2(char*& out, const unsigned char* src, std::size_t len, bool raw) {
+		std::size_t n = 0;
+		for(; len - n >= 32; n += 32) {
+			__m256i c = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + n));
+			__m256i d = _mm256_sub_epi8(c, _mm256_set1_epi8('0'));
+			__m256i safe = _mm256_cmpeq_epi8(_mm256_min_epu8(d, _mm256_set1_epi8(9)), d);
+			d = _mm256_sub_epi8(_mm256_or_si256(c, _mm256_set1_epi8(0x20)), _mm256_set1_epi8('a'));
+			safe = _mm256_or_si256(safe, _mm256_cmpeq_epi8(_mm256_min_epu8(d, _mm256_set1_epi8(25)), d));
+			safe = _mm256_or_si256(safe, _mm256_cmpeq_epi8(c, _mm256_set1_epi8('-')));
+			safe = _mm256_or_si256(safe, _mm256_cmpeq_epi8(c, _mm256_set1_epi8('.')));
+			safe = _mm256_or_si256(safe, _mm256_cmpeq_epi8(c, _mm256_set1_epi8('_')));
+			if(raw) safe = _mm256_or_si256(safe, _mm256_cmpeq_epi8(c, _mm256_set1_epi8('~')));
+			std::uint32_t mask = _mm256_movemask_epi8(safe);
+			if(mask == 0xFFFFFFFFu) {
+				_mm256_storeu_si256(reinterpret_cast<__m256i*>(out), c);
+				out += 32;
+				continue;
+			}
+			for(int i=0;i<32;++i) {
+				if(mask & (1u << i)) *out++ = src[n + i];
+				else out = url_encode_byte(out, src[n + i], raw);
+			}
+		}
+		return n + url_encode_sse2(out, src + n, len - n, raw);
+	}
+	// 查找特殊字符 ('%' 及非 raw 时的 '+'), 无特殊字符的区段整块复制
+	// 注意: 原地解码时 out <= src, 有特殊字符的区段不能整块写入 (会覆盖尚未读取的数据)
+	PHPEXT_TARGET("sse2")
+	static std::size_t url_decode_sse2(char*& out, const char* src, std::size_t len, bool raw) {
+		std::size_t n = 0;
+		while(len - n >= 16) {
+			__m128i c = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + n));
+			__m128i special = _mm_cmpeq_epi8(c, _mm_set1_epi8('%'));
+			if(!raw) special = _mm_or_si128(special, _mm_cmpeq_epi8(c, _mm_set1_epi8('+')));
+			int mask = _mm_movemask_epi8(special);
+			if(mask == 0) {
+				_mm_storeu_si128(reinterpret_cast<__m128i*>(out), c);
+				out += 16;
+				n += 16;
+				continue;
+			}
+			int k = __builtin_ctz(mask);
+			std::memmove(out, src + n, k);
+			out += k;
+			n += k;
+			n += url_decode_special(out, src + n, len - n);
+		}
+		return n;
+	}
+	PHPEXT_TARGET("avx2")
+	static std::size_t url_decode_avx2(char*& out, const char* src, std::size_t len, bool raw) {
+		std::size_t n = 0;
+		while(len - n >= 32) {
+			__m256i c = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + n));
+			__m256i special = _mm256_cmpeq_epi8(c, _mm256_set1_epi8('%'));
+			if(!raw) special = _mm256_or_si256(special, _mm256_cmpeq_epi8(c, _mm256_set1_epi8('+')));
+			std::uint32_t mask = _mm256_movemask_epi8(special);
+			if(mask == 0) {
+				_mm256_storeu_si256(reinterpret_cast<__m256i*>(out), c);
+				out += 32;
+				n += 32;
+				continue;
+			}
+			int k = __builtin_ctz(mask);
+			std::memmove(out, src + n, k);
+			out += k;
+			n += k;
+			n += url_decode_special(out, src + n, len - n);
+		}
+		return n + url_decode_sse2(out, src + n, len - n, raw);
+	}
+#endif
+	static url_encode_fn url_encode_select() {
+#ifdef PHPEXT_SIMD_X86
+		if(cpu_support(cpu_feature::AVX2)) return url_encode_avx2;
+		if(cpu_support(cpu_feature::SSE2)) return url_encode_sse2;
+#endif
+		return url_encode_none;
+	}
+	static url_decode_fn url_decode_select() {
+#ifdef PHPEXT_SIMD_X86
+		if(cpu_support(cpu_feature::AVX2)) return url_decode_avx2;
+		if(cpu_support(cpu_feature::SSE2)) return url_decode_sse2;
+#endif
+		return url_decode_none;
+	}
+	std::size_t url_encode_to(char* dst, const char* src, std::size_t len, bool raw) {
+		static url_encode_fn fn = url_encode_select();
+		const unsigned char* p = reinterpret_cast<const unsigned char*>(src);
+		char* out = dst;
+		for(std::size_t n = fn(out, p, len, raw); n < len; ++n) {
+			out = url_encode_byte(out, p[n], raw);
+		}
+		return out - dst;
+	}
+	void url_encode_to(buffer& dst, const char* src, std::size_t len, bool raw) {
+		char* p = dst.prepare(3 * len);
+		dst.commit(url_encode_to(p, src, len, raw));
+	}
+	php::string url_encode(const char* str, std::size_t len, bool raw) {
+		php::string s(3 * len);
+		std::size_t n = url_encode_to(s.data(), str, len, raw);
+		if(n < 3 * len) s.shrink(n);
+		return s;
+	}
+	std::size_t url_decode_to(char* dst, const char* src, std::size_t len, bool raw) {
+		static url_decode_fn fn = url_decode_select();
+		char* out = dst;
+		std::size_t n = fn(out, src, len, raw);
+		while(n < len) {
+			if(src[n] == '%' || (src[n] == '+' && !raw)) {
+				n += url_decode_special(out, src + n, len - n);
+			}else{
+				*out++ = src[n++];
+			}
+		}
+		return out - dst;
+	}
+	void url_decode_to(buffer& dst, const char* src, std::size_t len, bool raw) {
+		char* p = dst.prepare(len);
+		dst.commit(url_decode_to(p, src, len, raw));
+	}
+ 	php::string url_decode(const char* str, std::size_t len, bool raw) {
+		php::string s(len);
+		std::size_t n = url_decode_to(s.data(), str, len, raw);
+		if(n < len) s.shrink(n);
+		return s;
+	}
+	std::size_t url_decode_inplace(char* str, std::size_t len, bool raw) {
+		std::size_t n = url_decode_to(str, str, len, raw);
+		if(n < len) str[n] = '\0';
+		return n;
+	}
+	// 端口: 同 strtol() 读取 [p, e) (至多 5 个字符; 允许前导空白、符号及尾随的非数字字符), 须在 1 ~ 65535 之间
+	static bool url_port(const char* p, const char* e, int& port) {
+		while(p < e && (*p == ' ' || (*p >= '\t' && *p <= '\r'))) ++p;
+		bool negative = p < e && *p == '-';
+		if(p < e && (*p == '-' || *p == '+')) ++p;
+		int v = 0;
+		for(; p < e && *p >= '0' && *p <= '9'; ++p) v = v * 10 + (*p - '0');
+		if(negative || v <= 0 || v > 65535) return false;
+		port = v;
+		return true;
+	}
+	static inline bool url_scheme_char(char c) {
+		return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9') || c == '+' || c == '-' || c == '.';
+	}
+	static inline bool url_digit(char c) {
+		return c >= '0' && c <= '9';
+	}
+	static inline bool url_relative(const char* s, const char* ue) {
+		return ue - s > 1 && s[0] == '/' && s[1] == '/';
+	}
+	// [s, ue) 为 "path?query#fragment"; s == ue 时 path 为空串
+	static void url_path(const char* s, const char* ue, url_parts& parts) {
+		const char* e = ue, * p = static_cast<const char*>(std::memchr(s, '#', e - s));
+		if(p) {
+			if(p + 1 < e) parts.fragment = {p + 1, static_cast<std::size_t>(e - p - 1)};
+			e = p;
+		}
+		p = static_cast<const char*>(std::memchr(s, '?', e - s));
+		if(p) {
+			if(p + 1 < e) parts.query = {p + 1, static_cast<std::size_t>(e - p - 1)};
+			e = p;
+		}
+		if(s < e || s == ue) parts.path = {s, static_cast<std::size_t>(e - s)};
+	}
+	// [s, ue) 以 "user:pass@host:port" 开始, 至 '/' '?' '#' 为止, 其后为 path
+	static bool url_host(const char* s, const char* ue, url_parts& parts) {
+		const char* e = ue, * p;
+		if((p = static_cast<const char*>(std::memchr(s, '/', e - s)))) e = p;
+		if((p = static_cast<const char*>(std::memchr(s, '?', e - s)))) e = p;
+		if((p = static_cast<const char*>(std::memchr(s, '#', e - s)))) e = p;
+		for(p = e; p > s && p[-1] != '@'; --p);
+		if(p > s) {
+			const char* at = p - 1, * colon = static_cast<const char*>(std::memchr(s, ':', at - s));
+			if(colon) {
+				parts.user = {s, static_cast<std::size_t>(colon - s)};
+				parts.pass = {colon + 1, static_cast<std::size_t>(at - colon - 1)};
+			}else{
+				parts.user = {s, static_cast<std::size_t>(at - s)};
+			}
+			s = at + 1;
+		}
+		// "[...]" (IPv6) 之后无端口时不查找冒号
+		if(s < ue && *s == '[' && e[-1] == ']') {
+			p = e;
+		}else{
+			for(p = e; p > s && p[-1] != ':'; --p);
+			p = p > s ? p - 1 : e;
+		}
+		// 端口已由 url_port_prefix() 取得时不再读取; "host:" 视为无端口
+		if(p < e && parts.port < 0 && e - p > 1) {
+			if(e - p - 1 > 5 || !url_port(p + 1, e, parts.port)) return false;
+		}
+		if(p == s) return false;
+		parts.host = {s, static_cast<std::size_t>(p - s)};
+		if(e < ue) url_path(e, ue, parts);
+		return true;
+	}
+	// 冒号 e 之后为 1 ~ 5 位数字的端口 ("host:80", "//host:80/path" 等) 时记录端口并解析主机
+	static bool url_port_prefix(const char* s, const char* e, const char* ue, url_parts& parts) {
+		const char* p = e + 1, * pp = p;
+		while(pp < ue && pp - p < 6 && url_digit(*pp)) ++pp;
+		if(pp - p > 0 && pp - p < 6 && (pp == ue || *pp == '/')) {
+			if(!url_port(p, pp, parts.port)) return false;
+			if(url_relative(s, ue)) s += 2;
+		}else if(p == pp && pp == ue) {
+			return false;
+		}else if(url_relative(s, ue)) {
+			s += 2;
+		}else{
+			url_path(s, ue, parts);
+			return true;
+		}
+		return url_host(s, ue, parts);
+	}
+	// 流程同 php_url_parse_ex() (PHP 7.2)
+	bool url_parse(const char* str, std::size_t len, url_parts& parts) {
+		parts = url_parts {{nullptr, 0}, {nullptr, 0}, {nullptr, 0}, {nullptr, 0}, -1, {nullptr, 0}, {nullptr, 0}, {nullptr, 0}};
+		const char* s = str ? str : "", * ue = s + len, * p;
+		const char* e = static_cast<const char*>(std::memchr(s, ':', len));
+		if(!e) {
+			if(url_relative(s, ue)) return url_host(s + 2, ue, parts);
+			url_path(s, ue, parts);
+			return true;
+		}
+		if(e == s) return url_port_prefix(s, e, ue, parts);
+		for(p = s; p < e && url_scheme_char(*p); ++p);
+		if(p < e) {
+			// 非 scheme: 冒号位于 query / fragment (或 '\0') 之前时尝试端口, 否则为 "//host..." 或路径
+			for(p = s; p < ue && *p != '?' && *p != '#' && *p != '\0'; ++p);
+			if(e + 1 < ue && e < p) return url_port_prefix(s, e, ue, parts);
+			if(url_relative(s, ue)) return url_host(s + 2, ue, parts);
+			url_path(s, ue, parts);
+			return true;
+		}
+		if(e + 1 == ue) {
+			parts.scheme = {s, static_cast<std::size_t>(e - s)};
+			return true;
+		}
+		if(e[1] != '/') {
+			// "host:port" (至多 5 位数字, 其后为 '/' 或结束) 视为无 scheme 的主机, 否则如 "mailto:a@b" 无 '/'
+			for(p = e + 1; p < ue && url_digit(*p); ++p);
+			if((p == ue || *p == '/') && p - e < 7) return url_port_prefix(s, e, ue, parts);
+			parts.scheme = {s, static_cast<std::size_t>(e - s)};
+			url_path(e + 1, ue, parts);
+			return true;
+		}
+		parts.scheme = {s, static_cast<std::size_t>(e - s)};
+		if(e + 2 < ue && e[2] == '/') {
+			// "file:///path" 无主机, Windows 盘符 "file:///c:/dir/file.txt" 的 path 为 "c:/dir/file.txt"
+			if(e - s == 4 && strncasecmp(s, "file", 4) == 0 && e + 3 < ue && e[3] == '/') {
+				url_path(e + 5 < ue && e[5] == ':' ? e + 4 : e + 3, ue, parts);
+				return true;
+			}
+			return url_host(e + 3, ue, parts);
+		}
+		url_path(e + 1, ue, parts);
+		return true;
+	}
+	php::array url_query_parse(const char* str, std::size_t len) {
+		std::size_t n = 1;
+		for(const char* p = str, * e = str + len; p < e && (p = static_cast<const char*>(std::memchr(p, '&', e - p))) != nullptr; ++p) ++n;
+		php::array rv(n);
+		HashTable* ht = rv;
+		url_query_each(str, len, [ht] (url_slice key, url_slice val) {
+			if(key.size == 0) return;
+			zend_string* k = zend_string_alloc(key.size, 0);
+			ZSTR_LEN(k) = url_decode_to(ZSTR_VAL(k), key.data, key.size);
+			ZSTR_VAL(k)[ZSTR_LEN(k)] = '\0';
+			zval v;
+			if(val.size == 0) {
+				ZVAL_EMPTY_STRING(&v);
+			}else{
+				zend_string* s = zend_string_alloc(val.size, 0);
+				ZSTR_LEN(s) = url_decode_to(ZSTR_VAL(s), val.data, val.size);
+				ZSTR_VAL(s)[ZSTR_LEN(s)] = '\0';
+				ZVAL_NEW_STR(&v, s);
+			}
+			zend_symtable_update(ht, k, &v);
+			zend_string_release(k);
+		});
+		return rv;
+	}
+}
@@ -0,0 +1,60 @@
+#pragma once
+
+#include "string.h"
+#include "buffer.h"
+#include "array.h"
+
+namespace php {
+	// 输入内的片段 (不持有数据), data == nullptr 表示不存在
+	struct url_slice {
+		const char* data;
+		std::size_t size;
+
+		bool exists() const {
+			return data != nullptr;
+		}
+	};
+	struct url_parts {
+		url_slice scheme;
+		url_slice user;
+		url_slice pass;
+		url_slice host; // IPv6 地址包含 '[' ']'
+		int       port; // -1 表示不存在
+		url_slice path;
+		url_slice query;
+		url_slice fragment;
+	};
+	// 零分配解析, 各部分指向输入内部; 规则同 parse_url() (PHP 7.2 php_url_parse_ex(): 空的 query / fragment 视为不存在, 端口须在 1 ~ 65535 之间,
+	// "host:80" 等冒号后为至多 5 位数字时视为端口, 空输入的 path 为空串, "file:///c:/x" 的 path 为 "c:/x")
+	// 与 parse_url() 不同, 不替换控制字符; 无法解析时返回 false
+	bool url_parse(const char* str, std::size_t len, url_parts& parts);
+	// 以 '&' 分割 query string, 依次回调原始 (未解码) 的键值片段 cb(url_slice key, url_slice val), 跳过空片段; 无 '=' 时值为空
+	template <class F>
+	void url_query_each(const char* str, std::size_t len, F cb) {
+		const char* p = str, * e = str + len;
+		while(p < e) {
+			const char* q = static_cast<const char*>(std::memchr(p, '&', e - p));
+			if(!q) q = e;
+			if(q > p) {
+				const char* v = static_cast<const char*>(std::memchr(p, '=', q - p));
+				if(v) cb(url_slice {p, static_cast<std::size_t>(v - p)}, url_slice {v + 1, static_cast<std::size_t>(q - v - 1)});
+				else cb(url_slice {p, static_cast<std::size_t>(q - p)}, url_slice {q, 0});
+			}
+			p = q + 1;
+		}
+	}
+	// 解码 query string 到预分配的数组 (同 urldecode(), 数字键作为整数下标, 重复的键取最后一个)
+	// 与 parse_str() 不同, 不展开 "a[b]=c" 形式, 也不转换键中的 '.' 与 ' '; 空键被忽略
+	array url_query_parse(const char* str, std::size_t len);
+	// 编码写入 dst (至少 3 * len 空间), 返回写入长度
+	// raw = false 与 urlencode() 一致 (空格编码为 '+'), raw = true 与 rawurlencode() 一致 (RFC 3986)
+	std::size_t url_encode_to(char* dst, const char* src, std::size_t len, bool raw = false);
+	void url_encode_to(buffer& dst, const char* src, std::size_t len, bool raw = false);
+	string url_encode(const char* str, std::size_t len, bool raw = false);
+	// 解码写入 dst (至少 len 空间, 允许 dst == src), 返回写入长度
+	// raw = false 与 urldecode() 一致 ('+' 解码为空格), raw = true 与 rawurldecode() 一致
+	std::size_t url_decode_to(char* dst, const char* src, std::size_t len, bool raw = false);
+	void url_decode_to(buffer& dst, const char* src, std::size_t len, bool raw = false);
+	string url_decode(const char* str, std::size_t len, bool raw = false);
+	std::size_t url_decode_inplace(char* str, std::size_t len, bool raw = false);
+}
@@ -3,29 +3,16 @@
 #include "value.h"
 #include "string.h"
 #include "object.h"
+#include "buffer.h"
 
 namespace php {
 	extern std::ostream& operator << (std::ostream& os, const php::value& data);
 	object datetime(std::int64_t now = 0);
 	object datetime(const char* datetime);
-	string base64_encode(const unsigned char* str, std::size_t len);
-	string base64_decode(const unsigned char* str, std::size_t len);
-	string url_encode(const char* str, std::size_t len);
- 	string url_decode(const char* str, std::size_t len);
-	std::size_t url_decode_inplace(char* str, std::size_t len);
-	string bin2hex(const unsigned char *old, std::size_t len);
-	string php_hex2bin(const unsigned char *old, const size_t len);
-	string json_encode(const value& val);
-	// buffer& -> smart_str*
-	void json_encode_to(smart_str* str, const php::value& val);
-	value json_decode(const char* str, std::size_t size);
-	value json_decode(const string& str);
 	void sha1(const unsigned char* enc_str, size_t enc_len, char* output);
 	string sha1(const string& str);
-	void md5(const unsigned char* enc_str, uint32_t enc_len, char* output);
+	void md5(const unsigned char* enc_str, size_t enc_len, char* output);
 	string md5(const string& str);
-	std::uint32_t crc32(const unsigned char* src, uint32_t src_len);
-	std::uint32_t crc32(const string& str);
 	/*
 	typedef struct php_url {
 		char *scheme;
@@ -48,4 +35,14 @@ namespace php {
 	const auto uppercase_inplace = php_strtoupper;
 	// void lowercase_inplace(char* str, std::size_t len)
 	const auto lowercase_inplace = php_strtolower;
+	enum double_format_flag {
+		DOUBLE_ZERO_FRAC = 0x01, // 整数形式时追加 ".0" (同 var_export() / JSON_PRESERVE_ZERO_FRACTION)
+		DOUBLE_LOWER_E   = 0x02, // 指数使用小写 'e' (同 json_encode())
+	};
+	// 双精度浮点数的最短往返表示 (Ryu): 能还原为同一值的最少有效数字, 与 precision 设置无关
+	// 格式与 serialize_precision = -1 时的 php_gcvt() 完全一致 (serialize / var_export / json_encode), 如 0.1, 1.0E+25, -0, INF, NAN
+	// dst 至少 32 字节, 返回写入长度
+	std::size_t double_to_chars(char* dst, double d, int flags = 0);
+	void double_to_chars(buffer& buf, double d, int flags = 0);
+	string double_to_string(double d, int flags = 0);
 }
\ No newline at end of file
@@ -11,6 +11,7 @@
 #include "parameters.h"
 #include "property.h"
 #include "array_member.h"
+#include "numeric.h"
 
 namespace php {
 	// ---------------------------------------------------------------------
@@ -311,10 +312,28 @@ namespace php {
 		return type_of(TYPE::YES);
 	}
 	std::int64_t value::to_integer(int base) {
+		if(type_of(TYPE::STRING)) {
+			std::int64_t v;
+			bool r = true;
+			// 非十进制同 intval($str, $base); 十进制完整匹配时直接得出, 否则按引擎规则转换 ("1e3" 等)
+			if(base != 10) v = parse_integer_prefix(Z_STRVAL_P(ptr_), Z_STRLEN_P(ptr_), base);
+			else r = parse_integer(Z_STRVAL_P(ptr_), Z_STRLEN_P(ptr_), v);
+			if(r) {
+				zval_ptr_dtor(ptr_);
+				ZVAL_LONG(ptr_, v);
+				return v;
+			}
+		}
 		convert_to_long(ptr_);
 		return Z_LVAL_P(ptr_);
 	}
 	double value::to_float() {
+		double v;
+		if(type_of(TYPE::STRING) && parse_float(Z_STRVAL_P(ptr_), Z_STRLEN_P(ptr_), v)) {
+			zval_ptr_dtor(ptr_);
+			ZVAL_DOUBLE(ptr_, v);
+			return v;
+		}
 		convert_to_double(ptr_);
 		return Z_DVAL_P(ptr_);
 	}
@@ -4,13 +4,39 @@
 #include <vector>
 #include <functional>
 #include <memory>
+#include <type_traits>
+#include <limits>
+#include <algorithm>
 #include <initializer_list>
 #include <list>
+#include <map>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <deque>
+#include <chrono>
 #include <cmath>
 #include <cstdint>
 #include <cstring>
 #include <cmath>
 #include <ostream>
+#include <ctime>
+#include <cerrno>
+#include <pthread.h>
+#include <signal.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <cstdio>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <arpa/inet.h>
+#include <netdb.h>
+#include <cstddef>
 
 using std::isfinite;
 
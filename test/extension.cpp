@@ -1,6 +1,23 @@
 #include "../src/phpext.h"
 #include <iostream>
+#include <chrono>
+#include <stdexcept>
+#include <unistd.h>
+#include <sys/wait.h>
+#include <sys/time.h>
 
+// 基准耗时 (ms)
+static double test_ms(std::chrono::steady_clock::time_point t0) {
+	return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count();
+}
+// 基准吞吐 (MB/s)
+static double test_mbps(std::size_t bytes, std::chrono::steady_clock::time_point t0) {
+	return bytes / std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count() / 1024 / 1024;
+}
+// 校验: 不成立时抛出异常 (不受 NDEBUG 影响)
+static void test_expect(bool ok, const std::string& what) {
+	if(!ok) throw php::exception(zend_ce_error, "test failed: " + what);
+}
 // 所有导出到 PHP 的函数必须符合下面形式：
 // php::value fn(php::parameters& params);
 php::value test_function_1(php::parameters& params) {
@@ -88,7 +105,1241 @@ php::value test_function_6(php::parameters& params) {
 	}
 	return std::move(sb); // php::value 移动构造
 }
+php::value test_function_7(php::parameters& params) {
+	php::string data = params[0];
+	// 分段增量计算应与一次计算结果一致
+	php::crc32_context ctx;
+	std::size_t n = data.size() / 3;
+	ctx.update(data.c_str(), n).update(data.c_str() + n, data.size() - n);
+	test_expect(ctx.finalize() == php::crc32(data), "crc32_context");
+	return static_cast<std::int64_t>(php::crc32(data));
+}
+// 差异对比: php::base64_* (含 URL / 无填充 / 严格模式及分段编解码) 与内置 php_base64_* 结果一致, 并返回吞吐 (MB/s)
+php::value test_function_8(php::parameters& params) {
+	std::size_t size = static_cast<std::int64_t>(params[0]);
+	int times = params[1];
+	// 内置实现的结果 (解码失败时为 nullptr)
+	auto php_encode = [] (const std::string& s) -> std::string {
+		zend_string* r = php_base64_encode(reinterpret_cast<const unsigned char*>(s.data()), s.size());
+		std::string x(ZSTR_VAL(r), ZSTR_LEN(r));
+		zend_string_release(r);
+		return x;
+	};
+	auto php_decode = [] (const std::string& s, bool strict, std::string& x) -> bool {
+		zend_string* r = php_base64_decode_ex(reinterpret_cast<const unsigned char*>(s.data()), s.size(), strict);
+		if(!r) return false;
+		x.assign(ZSTR_VAL(r), ZSTR_LEN(r));
+		zend_string_release(r);
+		return true;
+	};
+	auto encode = [] (const std::string& s, int flags) -> std::string {
+		php::string r = php::base64_encode(reinterpret_cast<const unsigned char*>(s.data()), s.size(), flags);
+		return std::string(r.c_str(), r.size());
+	};
+	auto decode = [] (const std::string& s, int flags, std::string& x) -> bool {
+		try{
+			php::string r = php::base64_decode(reinterpret_cast<const unsigned char*>(s.data()), s.size(), flags);
+			x.assign(r.c_str(), r.size());
+			return true;
+		}catch(const php::exception& ex) {
+			return false;
+		}
+	};
+	// 随机切分为若干段进行分段编解码
+	auto chunked_encode = [] (const std::string& s, int flags) -> std::string {
+		php::buffer buf;
+		php::base64_encoder enc(flags);
+		for(std::size_t i=0, n; i<s.size(); i+=n) {
+			n = std::min<std::size_t>(std::rand() % 8, s.size() - i);
+			enc.update(buf, reinterpret_cast<const unsigned char*>(s.data()) + i, n);
+		}
+		enc.finalize(buf);
+		return std::string(buf.data(), buf.size());
+	};
+	auto chunked_decode = [] (const std::string& s, int flags) -> std::string {
+		php::buffer buf;
+		php::base64_decoder dec(flags);
+		for(std::size_t i=0, n; i<s.size(); i+=n) {
+			n = std::min<std::size_t>(std::rand() % 8, s.size() - i);
+			dec.update(buf, s.data() + i, n);
+		}
+		dec.finalize(buf);
+		return std::string(buf.data(), buf.size());
+	};
+	auto url = [] (std::string s, bool pad) -> std::string {
+		std::replace(s.begin(), s.end(), '+', '-');
+		std::replace(s.begin(), s.end(), '/', '_');
+		if(!pad) s.erase(s.find_last_not_of('=') + 1);
+		return s;
+	};
+	std::srand(size);
+	std::vector<std::string> samples;
+	// 全部 256 个字节值, 及覆盖批量 / 尾部路径的各长度随机数据
+	std::string all(256, '\0');
+	for(int i=0;i<256;++i) all[i] = static_cast<char>(i);
+	samples.push_back(all);
+	for(std::size_t n=0;n<200;++n) {
+		std::string s(n < 100 ? n : std::rand() % 4096, '\0');
+		for(auto& c : s) c = static_cast<char>(std::rand());
+		samples.push_back(s);
+	}
+	for(const auto& s : samples) {
+		std::string text = php_encode(s), x;
+		test_expect(encode(s, 0) == text, "base64_encode");
+		test_expect(encode(s, php::BASE64_URL) == url(text, true), "base64_encode (url)");
+		test_expect(encode(s, php::BASE64_URL | php::BASE64_NO_PAD) == url(text, false), "base64_encode (url, no pad)");
+		test_expect(decode(text, 0, x) && x == s, "base64_decode");
+		test_expect(decode(text, php::BASE64_STRICT, x) && x == s, "base64_decode (strict)");
+		test_expect(decode(url(text, false), php::BASE64_URL | php::BASE64_STRICT, x) && x == s, "base64_decode (url, no pad)");
+		test_expect(chunked_encode(s, 0) == text, "base64_encoder");
+		test_expect(chunked_encode(s, php::BASE64_URL | php::BASE64_NO_PAD) == url(text, false), "base64_encoder (url, no pad)");
+		test_expect(chunked_decode(text, php::BASE64_STRICT) == s, "base64_decoder");
+		test_expect(chunked_decode(url(text, true), php::BASE64_URL) == s, "base64_decoder (url)");
+	}
+	// 非法输入: 非严格模式结果一致, 严格模式同时失败 (抛出异常) 或结果一致
+	std::vector<std::string> invalid = {"Y", "YQ", "YQ=", "YQ===", "Y=Q=", "YQ==YQ==", "=", "====", "Zm9v\nYmFy\r\n", " Z m 9 v ",
+		"Zm9v$", "Zm9vYg=a", "Zm9v-_", "Zm9v\x80\xff", std::string("Zm\0" "9v", 5), "YQ=\n=", "YWJj\tZA=="};
+	static const char alphabet[] = "ABCxyz019+/=-_ \n$";
+	for(int i=0;i<200;++i) {
+		std::string s(std::rand() % 64, '\0');
+		for(auto& c : s) c = alphabet[std::rand() % (sizeof(alphabet) - 1)];
+		invalid.push_back(s);
+	}
+	for(const auto& s : invalid) {
+		std::string x, y;
+		test_expect(decode(s, 0, x) && php_decode(s, false, y) && x == y, "base64_decode (invalid): " + s);
+		bool ok = php_decode(s, true, y);
+		test_expect(decode(s, php::BASE64_STRICT, x) == ok && (!ok || x == y), "base64_decode (strict, invalid): " + s);
+	}
+	// 吞吐
+	php::string data(size);
+	for(std::size_t i=0;i<size;++i) {
+		data.data()[i] = static_cast<char>(i * 131 + (i >> 7));
+	}
+	const unsigned char* src = reinterpret_cast<const unsigned char*>(data.c_str());
+	php::string text = php::base64_encode(src, size);
+	php::array rv(4);
+	php::buffer buf;
+	auto t0 = std::chrono::steady_clock::now();
+	for(int i=0;i<times;++i) {
+		zend_string_release(php_base64_encode(src, size));
+	}
+	rv["php_base64_encode"] = test_mbps(size * times, t0);
+	t0 = std::chrono::steady_clock::now();
+	for(int i=0;i<times;++i) {
+		php::base64_encode_to(buf, src, size);
+		buf.consume(buf.size());
+	}
+	rv["base64_encode_to"] = test_mbps(size * times, t0);
+	t0 = std::chrono::steady_clock::now();
+	for(int i=0;i<times;++i) {
+		zend_string_release(php_base64_decode(reinterpret_cast<const unsigned char*>(text.c_str()), text.size()));
+	}
+	rv["php_base64_decode"] = test_mbps(size * times, t0);
+	t0 = std::chrono::steady_clock::now();
+	for(int i=0;i<times;++i) {
+		php::base64_decode_to(buf, text.c_str(), text.size());
+		buf.consume(buf.size());
+	}
+	rv["base64_decode_to"] = test_mbps(size * times, t0);
+	return rv;
+}
+// 差异对比: php::json_encode 与 php_json_encode(..., PHP_JSON_UNESCAPED_UNICODE) 输出一致, 并返回耗时 (ms)
+php::value test_function_9(php::parameters& params) {
+	php::value data = params[0];
+	int times = params[1];
+	smart_str s1 {nullptr, 0};
+	if(php_json_encode(&s1, data, PHP_JSON_UNESCAPED_UNICODE) == FAILURE || JSON_G(error_code) != PHP_JSON_ERROR_NONE) {
+		smart_str_free(&s1);
+		// 均应失败
+		test_expect(php::json_encode(data).type_of(php::TYPE::NULLABLE), "json_encode (failure)");
+		return nullptr;
+	}
+	php::string r1 = &s1, r2 = php::json_encode(data);
+	test_expect(r1 == r2, "json_encode");
+	php::array rv(2);
+	php::buffer buf;
+	auto t0 = std::chrono::steady_clock::now();
+	for(int i=0;i<times;++i) {
+		php_json_encode(buf, data, PHP_JSON_UNESCAPED_UNICODE);
+		buf.consume(buf.size());
+	}
+	rv["php_json_encode"] = test_ms(t0);
+	t0 = std::chrono::steady_clock::now();
+	for(int i=0;i<times;++i) {
+		php::json_encode_to(buf, data);
+		buf.consume(buf.size());
+	}
+	rv["json_encode_to"] = test_ms(t0);
+	return rv;
+}
+// 惰性解析: 按路径读取 (仅物化所访问的子树), 与完整 json_decode 结果及耗时 (ms) 对比
+php::value test_function_10(php::parameters& params) {
+	php::string json = params[0];
+	php::array path = params[1];
+	int times = params[2];
+	auto lookup = [&json, &path] () -> php::value {
+		php::json_document doc(json);
+		php::json_node node = doc.root();
+		for(auto i=path.begin(); i!=path.end(); ++i) {
+			if(i->second.type_of(php::TYPE::INTEGER)) node = node[static_cast<std::size_t>(static_cast<std::int64_t>(i->second))];
+			else node = node[php::string(i->second)];
+		}
+		return node.to_value();
+	};
+	php::array rv(4);
+	php::value found = lookup();
+	rv["value"] = found;
+	// 与完整解码后按路径读取的结果一致
+	php::value expect = php::json_decode(json);
+	for(auto i=path.begin(); i!=path.end(); ++i) {
+		php::array a = expect;
+		if(i->second.type_of(php::TYPE::INTEGER)) expect = a.get(static_cast<std::size_t>(static_cast<std::int64_t>(i->second)));
+		else expect = a.get(php::string(i->second));
+	}
+	test_expect(zend_is_identical(found, expect), "json_document");
+	auto t0 = std::chrono::steady_clock::now();
+	for(int i=0;i<times;++i) lookup();
+	rv["json_document"] = test_ms(t0);
+	t0 = std::chrono::steady_clock::now();
+	for(int i=0;i<times;++i) php::json_decode(json);
+	rv["json_decode"] = test_ms(t0);
+	return rv;
+}
+php::value test_function_11(php::parameters& params) {
+	php::string json = params[0];
+	std::size_t chunk = static_cast<int>(params[1]);
+	// 非法输入 (同样分段送入): 错误码与 json_decode() 之后的 json_last_error() 一致
+	php::callable json_decode_fn("json_decode"), json_last_error_fn("json_last_error");
+	for(std::string s : {"truefalse", "[truex]", "nullnull", "[1true]", "[1x]", "{\"a\":fals}", "[tru]", "\"\\x\"",
+		"\"\\u12G4\"", "\"\\u\"", "\"\\ud800x\"", "\"\\ud800\\u12\"", "\"\\ud800\\u0041\"", "\"\\udc00\""}) {
+		php::json_value_builder b;
+		php::json_parser p(&b);
+		int code = PHP_JSON_ERROR_NONE;
+		try{
+			for(std::size_t i=0;i<s.size();i+=chunk) p.parse(s.data() + i, std::min(chunk, s.size() - i));
+			p.finish();
+		}catch(const php::exception& ex) {
+			code = JSON_G(error_code);
+		}
+		json_decode_fn({php::string(s)});
+		test_expect(code != PHP_JSON_ERROR_NONE && code == static_cast<int>(json_last_error_fn()), "json_parser (invalid): " + s);
+	}
+	php::json_value_builder builder;
+	php::json_parser parser(&builder);
+	php::stream_buffer sb;
+	php::array rv(4);
+	// 模拟分段接收: 每次写入 chunk 字节后立即解析, 取出已完成的顶层值
+	for(std::size_t i=0;i<json.size();i+=chunk) {
+		std::size_t n = std::min(chunk, json.size() - i);
+		std::memcpy(sb.prepare(n), json.c_str() + i, n);
+		sb.commit(n);
+		parser.parse(sb);
+		while(!builder.empty()) rv[rv.size()] = builder.pop();
+	}
+	parser.finish();
+	while(!builder.empty()) rv[rv.size()] = builder.pop();
+	return rv;
+}
+php::value test_function_12(php::parameters& params) {
+	int count = params[0];
+	bool pretty = params[1];
+	int times = params[2];
+	// 由原生数据直接输出
+	auto write = [count, pretty] () -> php::string {
+		php::buffer buf;
+		php::json_writer w(buf, pretty);
+		w.begin_object().key("total").value(count).key("items").begin_array();
+		for(int i=0;i<count;++i) {
+			w.begin_object()
+				.key("id").value(i)
+				.key("name").value("item/\"" + std::to_string(i) + "\"")
+				.key("price").value(i * 0.25)
+				.key("tags").begin_array().value("a").value("b").end_array()
+			.end_object();
+		}
+		w.end_array().end_object();
+		return std::move(buf);
+	};
+	// 构建 PHP 数组后编码
+	auto build = [count] () -> php::string {
+		php::array items(count);
+		for(int i=0;i<count;++i) {
+			php::array item(4), tags(2);
+			item["id"] = i;
+			item["name"] = "item/\"" + std::to_string(i) + "\"";
+			item["price"] = i * 0.25;
+			tags[0] = "a";
+			tags[1] = "b";
+			item["tags"] = tags;
+			items[i] = item;
+		}
+		php::array root(2);
+		root["total"] = count;
+		root["items"] = items;
+		return php::json_encode(root);
+	};
+	php::array rv(4);
+	php::string json = write();
+	rv["json"] = json;
+	// 紧凑格式与 json_encode 逐字节一致, 格式化输出解码后一致
+	if(!pretty) test_expect(json == build(), "json_writer");
+	test_expect(zend_is_identical(php::json_decode(json), php::json_decode(build())), "json_writer (decode)");
+	auto t0 = std::chrono::steady_clock::now();
+	for(int i=0;i<times;++i) write();
+	rv["json_writer"] = test_ms(t0);
+	t0 = std::chrono::steady_clock::now();
+	for(int i=0;i<times;++i) build();
+	rv["array+json_encode"] = test_ms(t0);
+	return rv;
+}
+php::value test_function_13(php::parameters& params) {
+	php::value data = params[0];
+	int times = params[1];
+	php::callable serialize("serialize"), unserialize("unserialize");
+	php::string packed = php::msgpack_pack(data),
+		deduped = php::msgpack_pack(data, php::MSGPACK_DEDUPE_KEYS),
+		json = php::json_encode(data),
+		serialized = serialize({data});
+	php::array rv(16);
+	// value::operator == 仅比较 zval 指向的数据地址, 内容比较使用 zend_is_identical()
+	test_expect(zend_is_identical(php::msgpack_unpack(packed), data), "msgpack_unpack");
+	test_expect(zend_is_identical(php::msgpack_unpack(deduped, php::MSGPACK_INTERN_KEYS), data), "msgpack_unpack (dedupe)");
+	rv["size_msgpack"] = packed.size();
+	rv["size_msgpack_dedupe"] = deduped.size();
+	rv["size_json"] = json.size();
+	rv["size_serialize"] = serialized.size();
+	auto t0 = std::chrono::steady_clock::now();
+	for(int i=0;i<times;++i) php::msgpack_pack(data);
+	rv["msgpack_pack"] = test_ms(t0);
+	t0 = std::chrono::steady_clock::now();
+	for(int i=0;i<times;++i) php::msgpack_pack(data, php::MSGPACK_DEDUPE_KEYS);
+	rv["msgpack_pack_dedupe"] = test_ms(t0);
+	t0 = std::chrono::steady_clock::now();
+	for(int i=0;i<times;++i) php::json_encode(data);
+	rv["json_encode"] = test_ms(t0);
+	t0 = std::chrono::steady_clock::now();
+	for(int i=0;i<times;++i) serialize({data});
+	rv["serialize"] = test_ms(t0);
+	t0 = std::chrono::steady_clock::now();
+	for(int i=0;i<times;++i) php::msgpack_unpack(packed);
+	rv["msgpack_unpack"] = test_ms(t0);
+	t0 = std::chrono::steady_clock::now();
+	for(int i=0;i<times;++i) php::msgpack_unpack(deduped, php::MSGPACK_INTERN_KEYS);
+	rv["msgpack_unpack_dedupe"] = test_ms(t0);
+	t0 = std::chrono::steady_clock::now();
+	for(int i=0;i<times;++i) php::json_decode(json);
+	rv["json_decode"] = test_ms(t0);
+	t0 = std::chrono::steady_clock::now();
+	for(int i=0;i<times;++i) unserialize({serialized});
+	rv["unserialize"] = test_ms(t0);
+	return rv;
+}
+// 与 parse_url() 结果一致 (均失败, 或各部分相同); 成功时返回各部分
+static php::value test_url_parse(const php::string& url, php::url_parts& parts) {
+	auto slice = [] (const php::url_slice& s) -> php::value {
+		if(!s.exists()) return nullptr;
+		return php::string(s.data, s.size);
+	};
+	php::value expect = php::callable("parse_url")({url});
+	if(!php::url_parse(url.c_str(), url.size(), parts)) {
+		test_expect(expect.type_of(php::TYPE::NO), "url_parse (failure): " + std::string(url.c_str(), url.size()));
+		return false;
+	}
+	test_expect(expect.type_of(php::TYPE::ARRAY), "url_parse: " + std::string(url.c_str(), url.size()));
+	php::array rv(16);
+	rv["scheme"] = slice(parts.scheme);
+	rv["user"] = slice(parts.user);
+	rv["pass"] = slice(parts.pass);
+	rv["host"] = slice(parts.host);
+	rv["port"] = parts.port < 0 ? php::value(nullptr) : php::value(parts.port);
+	rv["path"] = slice(parts.path);
+	rv["query"] = slice(parts.query);
+	rv["fragment"] = slice(parts.fragment);
+	php::array e = expect;
+	for(const char* key : {"scheme", "user", "pass", "host", "port", "path", "query", "fragment"}) {
+		php::value v = rv.get(key), x = e.exists(key) ? e.get(key) : php::value(nullptr);
+		test_expect(zend_is_identical(v, x), "url_parse: " + std::string(url.c_str(), url.size()) + " " + key);
+	}
+	return rv;
+}
+php::value test_function_14(php::parameters& params) {
+	php::string url = params[0];
+	int times = params[1];
+	php::url_parts parts;
+	// 端口 0 / 超出范围 / 尾随字符、超过 5 位数字、路径中的冒号、空输入、Windows 盘符等
+	for(const char* edge : {"", "host:0", "host:80abc", "//host:80abc", "//host: 80", "//host:-1", "//host:0/", "a:123456", "a:12345",
+		"/p:80", "/p:80/x", "file:///c:/x", "file:///x", "FILE:///d:", "file://host/x", ":80", "a:", "mailto:a@b", "//[::1]", "http://[::1]:443/",
+		"http://host:99999/", "http://", "?q", "#f", "x?#", "a:b:80", "//u:p@h:1?q#f"}) {
+		test_url_parse(edge, parts);
+	}
+	php::value r = test_url_parse(url, parts);
+	if(!r.type_of(php::TYPE::ARRAY)) return false;
+	php::array rv = r;
+	rv["args"] = php::url_query_parse(parts.query.data, parts.query.size);
+	auto t0 = std::chrono::steady_clock::now();
+	for(int i=0;i<times;++i) php::url_parse(url.c_str(), url.size(), parts);
+	rv["url_parse"] = test_ms(t0);
+	t0 = std::chrono::steady_clock::now();
+	for(int i=0;i<times;++i) php::parse_url(url);
+	rv["parse_url"] = test_ms(t0);
+	t0 = std::chrono::steady_clock::now();
+	for(int i=0;i<times;++i) php::url_query_parse(parts.query.data, parts.query.size);
+	rv["url_query_parse"] = test_ms(t0);
+	return rv;
+}
+php::value test_function_15(php::parameters& params) {
+	php::string str = params[0];
+	int times = params[1];
+	php::string upper = php::ascii_upper(str.c_str(), str.size());
+	php::string lower = php::lowercase(str.c_str(), str.size());
+	php::array rv(16);
+	rv["lower"] = php::ascii_lower(str.c_str(), str.size());
+	rv["upper"] = upper;
+	test_expect(php::ascii_lower(str.c_str(), str.size()) == lower, "ascii_lower");
+	test_expect(php::ascii_iequal(str.c_str(), str.size(), upper.c_str(), upper.size()), "ascii_iequal");
+	// 哈希与小写形式的 zend_string_hash_val() 一致: 参数及含非 ASCII 字节的随机数据 (覆盖 8 字节分组及尾部)
+	auto ihash_same = [] (const char* s, std::size_t n) -> bool {
+		php::string l = php::lowercase(s, n);
+		return php::ascii_ihash(s, n) == zend_string_hash_val(static_cast<zend_string*>(l));
+	};
+	test_expect(ihash_same(str.c_str(), str.size()), "ascii_ihash");
+	std::srand(str.size());
+	for(int i=0;i<1000;++i) {
+		std::string s(i % 64, '\0');
+		for(auto& c : s) c = static_cast<char>(i % 2 ? std::rand() : "aZ\x80\xc3\xff"[std::rand() % 5]);
+		test_expect(ihash_same(s.data(), s.size()), "ascii_ihash (non-ascii)");
+	}
+	auto t0 = std::chrono::steady_clock::now();
+	for(int i=0;i<times;++i) php::ascii_lower(str.c_str(), str.size());
+	rv["ascii_lower"] = test_ms(t0);
+	t0 = std::chrono::steady_clock::now();
+	for(int i=0;i<times;++i) php::lowercase(str.c_str(), str.size());
+	rv["lowercase"] = test_ms(t0);
+	t0 = std::chrono::steady_clock::now();
+	for(int i=0;i<times;++i) php::ascii_iequal(str.c_str(), upper.c_str(), str.size());
+	rv["ascii_iequal"] = test_ms(t0);
+	t0 = std::chrono::steady_clock::now();
+	for(int i=0;i<times;++i) zend_binary_strcasecmp(str.c_str(), str.size(), upper.c_str(), upper.size());
+	rv["zend_binary_strcasecmp"] = test_ms(t0);
+	t0 = std::chrono::steady_clock::now();
+	for(int i=0;i<times;++i) php::ascii_ihash(str.c_str(), str.size());
+	rv["ascii_ihash"] = test_ms(t0);
+	t0 = std::chrono::steady_clock::now();
+	for(int i=0;i<times;++i) zend_inline_hash_func(php::lowercase(str.c_str(), str.size()).c_str(), str.size());
+	rv["lowercase+hash"] = test_ms(t0);
+	return rv;
+}
+php::value test_function_16(php::parameters& params) {
+	php::string data = params[0];
+	int times = params[1];
+	std::size_t bytes = data.size() * times;
+	php::array rv(16);
+	test_expect(php::xxh64("", 0) == 0xef46db3751d8e999ull && php::xxh64("abc", 3) == 0x44bc2cf5ad770999ull, "xxh64");
+	std::uint64_t h64 = php::xxh64(data);
+	php::hash128 h128 = php::murmur3_128(data);
+	rv["xxh64"] = php::bin2hex(reinterpret_cast<const unsigned char*>(&h64), 8);
+	rv["murmur3_128"] = php::bin2hex(reinterpret_cast<const unsigned char*>(&h128), 16);
+	// 分段增量计算结果须一致
+	std::size_t n = data.size() / 3;
+	test_expect(php::xxh64_context().update(data.c_str(), n).update(data.c_str() + n, data.size() - n).finalize() == h64, "xxh64_context");
+	test_expect(php::murmur3_128_context().update(data.c_str(), n).update(data.c_str() + n, data.size() - n).finalize() == h128, "murmur3_128_context");
+	auto t0 = std::chrono::steady_clock::now();
+	for(int i=0;i<times;++i) php::xxh64(data);
+	rv["xxh64 MB/s"] = test_mbps(bytes, t0);
+	t0 = std::chrono::steady_clock::now();
+	for(int i=0;i<times;++i) php::murmur3_128(data);
+	rv["murmur3_128 MB/s"] = test_mbps(bytes, t0);
+	t0 = std::chrono::steady_clock::now();
+	for(int i=0;i<times;++i) php::crc32(data);
+	rv["crc32 MB/s"] = test_mbps(bytes, t0);
+	t0 = std::chrono::steady_clock::now();
+	for(int i=0;i<times;++i) php::md5(data);
+	rv["md5 MB/s"] = test_mbps(bytes, t0);
+	// 分片: 键 => 节点
+	static php::ketama_ring ring;
+	if(ring.empty()) {
+		for(int i=0;i<8;++i) ring.add("cache-" + std::to_string(i) + ":11211", i == 0 ? 2 : 1);
+	}
+	php::array shards(8);
+	for(int i=0;i<1000;++i) {
+		php::string node(ring.get("user:" + std::to_string(i)));
+		int count = shards.exists(node) ? static_cast<int>(shards.get(node)) : 0;
+		shards.set(node, count + 1);
+	}
+	rv["ketama"] = shards;
+	t0 = std::chrono::steady_clock::now();
+	for(int i=0;i<times;++i) ring.get(data);
+	rv["ketama lookup/ms"] = times / test_ms(t0);
+	// 桶数增加时键仅可能移动到新增的桶
+	for(std::uint64_t k=0;k<1000;++k) {
+		for(std::int32_t b=1;b<64;++b) {
+			std::int32_t x = php::jump_consistent_hash(k, b), y = php::jump_consistent_hash(k, b + 1);
+			test_expect(x >= 0 && x < b && (y == x || y == b), "jump_consistent_hash");
+		}
+	}
+	t0 = std::chrono::steady_clock::now();
+	for(int i=0;i<times;++i) php::jump_consistent_hash(static_cast<std::uint64_t>(i), 64);
+	rv["jump lookup/ms"] = times / test_ms(t0);
+	return rv;
+}
+php::value test_function_17(php::parameters& params) {
+	php::array input = params[0];
+	int times = params[1];
+	std::vector<php::string> inputs;
+	for(auto i=input.begin(); i!=input.end(); ++i) inputs.push_back(i->second);
+	php::array rv(8);
+	std::vector<php::string> md5s = php::md5_batch(inputs), sha1s = php::sha1_batch(inputs);
+	php::array md5(inputs.size()), sha1(inputs.size());
+	for(std::size_t i=0;i<inputs.size();++i) {
+		md5[i] = md5s[i];
+		sha1[i] = sha1s[i];
+	}
+	// 与逐个计算及 md5() / sha1() 的结果一致
+	php::callable md5_fn("md5"), sha1_fn("sha1");
+	for(std::size_t i=0;i<inputs.size();++i) {
+		test_expect(md5s[i] == php::md5(inputs[i]) && md5s[i] == php::string(md5_fn({inputs[i]})), "md5_batch");
+		test_expect(sha1s[i] == php::sha1(inputs[i]) && sha1s[i] == php::string(sha1_fn({inputs[i]})), "sha1_batch");
+	}
+	rv["md5"] = md5;
+	rv["sha1"] = sha1;
+	// 增量计算全部输入的拼接
+	php::md5_context md5_ctx;
+	php::sha1_context sha1_ctx;
+	for(auto& str: inputs) {
+		md5_ctx.update(str);
+		sha1_ctx.update(str);
+	}
+	rv["md5_all"] = md5_ctx.hex();
+	rv["sha1_all"] = sha1_ctx.hex();
+	std::string all;
+	for(auto& str: inputs) all.append(str.c_str(), str.size());
+	test_expect(md5_ctx.hex() == php::md5(all) && sha1_ctx.hex() == php::sha1(all), "md5_context / sha1_context");
+	auto t0 = std::chrono::steady_clock::now();
+	for(int i=0;i<times;++i) php::md5_batch(inputs);
+	rv["md5_batch ms"] = test_ms(t0);
+	t0 = std::chrono::steady_clock::now();
+	for(int i=0;i<times;++i) {
+		for(auto& str: inputs) php::md5(str);
+	}
+	rv["md5 ms"] = test_ms(t0);
+	t0 = std::chrono::steady_clock::now();
+	for(int i=0;i<times;++i) php::sha1_batch(inputs);
+	rv["sha1_batch ms"] = test_ms(t0);
+	t0 = std::chrono::steady_clock::now();
+	for(int i=0;i<times;++i) {
+		for(auto& str: inputs) php::sha1(str);
+	}
+	rv["sha1 ms"] = test_ms(t0);
+	return rv;
+}
+php::value test_function_18(php::parameters& params) {
+	php::string iso = params[0];
+	int times = params[1];
+	php::array rv(12);
+	std::int64_t us;
+	int offset;
+	if(!php::iso8601_parse(iso, us, offset)) return nullptr;
+	rv["us"] = us;
+	rv["offset"] = offset;
+	rv["format"] = php::iso8601_format(us, offset, 6);
+	php::object dt = php::datetime_from_iso8601(iso);
+	rv["datetime"] = dt;
+	rv["datetime_us"] = php::datetime_to_us(dt);
+	rv["local"] = php::datetime_from_us(us);
+	rv["ms"] = php::datetime(us / 1000);
+	// 格式化结果可解析回相同的时间, 且与 DateTime::format() 一致
+	std::int64_t us2;
+	int offset2;
+	php::string format = rv.get("format");
+	test_expect(php::iso8601_parse(format, us2, offset2) && us2 == us && offset2 == offset, "iso8601_format");
+	test_expect(php::datetime_to_us(dt) == us, "datetime_to_us");
+	test_expect(php::string(dt.call("format", {"Y-m-d\\TH:i:s.uP"})) == format, "datetime_from_iso8601");
+	auto t0 = std::chrono::steady_clock::now();
+	for(int i=0;i<times;++i) php::datetime_from_iso8601(iso);
+	rv["datetime_from_iso8601 ms"] = test_ms(t0);
+	t0 = std::chrono::steady_clock::now();
+	for(int i=0;i<times;++i) php::datetime(iso.c_str());
+	rv["__construct ms"] = test_ms(t0);
+	t0 = std::chrono::steady_clock::now();
+	for(int i=0;i<times;++i) php::iso8601_format(us, offset, 6);
+	rv["iso8601_format ms"] = test_ms(t0);
+	t0 = std::chrono::steady_clock::now();
+	for(int i=0;i<times;++i) dt.call("format", {"Y-m-d\\TH:i:s.uP"});
+	rv["format ms"] = test_ms(t0);
+	return rv;
+}
+php::value test_function_19(php::parameters& params) {
+	php::array input = params[0];
+	int base = params[1];
+	int times = params[2];
+	php::array rv(8), ints(input.size()), floats(input.size());
+	for(auto i=input.begin(); i!=input.end(); ++i) {
+		php::string str = i->second;
+		std::int64_t v;
+		double d;
+		ints[ints.size()] = php::parse_integer(str, v, base) ? php::value(v) : php::value(nullptr);
+		floats[floats.size()] = php::parse_float(str, d) ? php::value(d) : php::value(nullptr);
+	}
+	// parse_integer_prefix 与 intval($str, $base) 一致 (base 10 时 intval 按数值字符串转换, 不在此对比)
+	php::callable intval_fn("intval");
+	for(const char* s : {"0b101", "0B101", "-0b101", "+0b11", " \t0b101", "0b 101", "0b-1", "-0b-1", "0b", "-0b", "0b2", "0x1f", "-0X1F",
+		"0x", "017", " -42abc", "  +0x10", "zz", "", "9223372036854775808", "-9223372036854775809", "0b" "1111111111111111111111111111111111111111111111111111111111111111"}) {
+		for(int b : {0, 2, 8, 16, 36}) {
+			test_expect(php::parse_integer_prefix(s, std::strlen(s), b) == static_cast<std::int64_t>(intval_fn({s, b})),
+				std::string("parse_integer_prefix: ") + s + " (" + std::to_string(b) + ")");
+		}
+	}
+	rv["integer"] = ints;
+	rv["float"] = floats;
+	std::vector<std::int64_t> iout(input.size());
+	std::vector<double> fout(input.size());
+	rv["integer_batch"] = php::parse_integer_batch(input, iout.data(), base);
+	rv["float_batch"] = php::parse_float_batch(input, fout.data());
+	auto t0 = std::chrono::steady_clock::now();
+	for(int i=0;i<times;++i) php::parse_float_batch(input, fout.data());
+	rv["parse_float_batch ms"] = test_ms(t0);
+	t0 = std::chrono::steady_clock::now();
+	for(int i=0;i<times;++i) {
+		for(auto j=input.begin(); j!=input.end(); ++j) {
+			php::value v = j->second;
+			v.to_float();
+		}
+	}
+	rv["to_float ms"] = test_ms(t0);
+	t0 = std::chrono::steady_clock::now();
+	for(int i=0;i<times;++i) {
+		for(auto j=input.begin(); j!=input.end(); ++j) {
+			zval v;
+			ZVAL_COPY(&v, static_cast<zval*>(j->second));
+			convert_to_double(&v);
+		}
+	}
+	rv["convert_to_double ms"] = test_ms(t0);
+	return rv;
+}
+php::value test_function_20(php::parameters& params) {
+	int count = params[0];
+	// 随机位模式 (覆盖全部指数范围) 与常见的小数
+	std::vector<double> corpus(count);
+	std::uint64_t seed = 88172645463325252ull;
+	for(int i=0;i<count;++i) {
+		seed ^= seed << 13;
+		seed ^= seed >> 7;
+		seed ^= seed << 17;
+		if(i % 2) corpus[i] = static_cast<double>(seed % 100000000) / 1000;
+		else std::memcpy(&corpus[i], &seed, sizeof(double));
+	}
+	php::array rv(8);
+	char a[32], b[ZEND_DOUBLE_MAX_LENGTH];
+	// 与 php_gcvt 输出一致, 且可精确解析回原值
+	for(double d: corpus) {
+		std::size_t n = php::double_to_chars(a, d);
+		php_gcvt(d, -1, '.', 'E', b);
+		test_expect(std::strlen(b) == n && std::memcmp(a, b, n) == 0, std::string("double_to_chars: ") + b);
+		a[n] = '\0';
+		if(std::isfinite(d)) test_expect(zend_strtod(a, nullptr) == d, std::string("double_to_chars (round-trip): ") + b);
+	}
+	rv["example"] = php::double_to_string(0.1 + 0.2);
+	std::size_t total = 0;
+	auto t0 = std::chrono::steady_clock::now();
+	for(double d: corpus) total += php::double_to_chars(a, d);
+	rv["double_to_chars ms"] = test_ms(t0);
+	t0 = std::chrono::steady_clock::now();
+	for(double d: corpus) total += std::strlen(php_gcvt(d, -1, '.', 'E', b));
+	rv["php_gcvt ms"] = test_ms(t0);
+	rv["total"] = total;
+	return rv;
+}
+// 模块全局数据 (ZTS 下每个线程一个实例)
+struct test_globals {
+	std::int64_t requests = 0; // 当前线程 (进程) 处理的请求数
+	std::int64_t calls = 0;    // 当前请求内的调用次数
+	// 绑定的 INI 项
+	std::int64_t         limit = 0;
+	bool                 debug = false;
+	double               ratio = 0;
+	std::size_t          buffer_size = 0;
+	int                  mode = 0;
+	php::ini_string_view name {"", 0};
+};
+php::value test_function_21(php::parameters& params) {
+	int times = params[0];
+	test_globals& g = php::extension_entry::globals<test_globals>();
+	++g.calls;
+	php::array rv(4);
+	rv["requests"] = g.requests;
+	rv["calls"] = g.calls;
+	auto t0 = std::chrono::steady_clock::now();
+	for(int i=0;i<times;++i) ++php::extension_entry::globals<test_globals>().calls;
+	rv["globals ms"] = test_ms(t0);
+	// 每次取得的是同一实例
+	test_expect(g.calls == static_cast<std::int64_t>(rv.get("calls")) + times, "globals");
+	php::extension_entry::globals<test_globals>().calls -= times;
+	return rv;
+}
+php::value test_function_22(php::parameters& params) {
+	int times = params[0];
+	test_globals& g = php::extension_entry::globals<test_globals>();
+	php::array rv(8);
+	rv["limit"] = g.limit;
+	rv["debug"] = g.debug;
+	rv["ratio"] = g.ratio;
+	rv["buffer_size"] = g.buffer_size;
+	rv["mode"] = g.mode;
+	rv["name"] = php::string(g.name.data, g.name.size);
+	test_expect(g.limit == static_cast<std::int64_t>(php::ini("phpext.limit")), "ini binding");
+	// 布尔值解析同 zend_ini_parse_bool(), 非法的值被拒绝且不改变绑定的字段
+	php::callable ini_set_fn("ini_set"), ini_get_fn("ini_get");
+	php::value old = ini_get_fn({"phpext.debug"});
+	bool debug = g.debug;
+	for(const char* s : {"2", "-1", " 1", "10abc", "on", "YES", "true"}) {
+		ini_set_fn({"phpext.debug", s});
+		test_expect(g.debug, std::string("ini bool: ") + s);
+	}
+	for(const char* s : {"0", "00", "", "off", "No", "false", "none", "0x1"}) {
+		ini_set_fn({"phpext.debug", s});
+		test_expect(!g.debug, std::string("ini bool: ") + s);
+	}
+	test_expect(ini_set_fn({"phpext.debug", "maybe"}).type_of(php::TYPE::NO) && !g.debug, "ini bool: maybe");
+	ini_set_fn({"phpext.debug", old});
+	test_expect(g.debug == debug, "ini bool: " + static_cast<std::string>(old));
+	std::int64_t sum = 0;
+	auto t0 = std::chrono::steady_clock::now();
+	for(int i=0;i<times;++i) sum += php::extension_entry::globals<test_globals>().limit;
+	rv["globals ms"] = test_ms(t0);
+	t0 = std::chrono::steady_clock::now();
+	for(int i=0;i<times;++i) sum += static_cast<std::int64_t>(php::ini("phpext.limit"));
+	rv["ini ms"] = test_ms(t0);
+	rv["sum"] = sum;
+	return rv;
+}
+// 须在 fork 之前 (模块启动时) 创建
+static std::unique_ptr<php::shm_cache> test_cache;
+static void test_shm_exit(int) {
+	_exit(0);
+}
+// 单分段的小容量缓存: CLOCK 淘汰、整页回收、过期及锁持有者退出后的恢复
+static php::array test_shm_cache_small() {
+	php::shm_cache cache(256 * 1024, 1);
+	php::array rv(8);
+	char key[32];
+	// 同规格 (1024 字节块) 的数据写满全部页, 首次淘汰时的项数即容量
+	std::string data(900, 'a');
+	std::uint64_t evictions = cache.stats().evictions;
+	int cap = 0;
+	for(int i=0; cache.stats().evictions == evictions; ++i) {
+		test_expect(cache.set_raw(key, std::sprintf(key, "a%d", i), data.c_str(), data.size()), "shm_cache set");
+		cap = i;
+	}
+	rv["capacity"] = cap;
+	test_expect(cap > 0 && cache.stats().entries == static_cast<std::size_t>(cap), "shm_cache capacity");
+	cache.clear();
+	for(int i=0;i<cap;++i) {
+		data.assign(900, 'a' + i % 26);
+		cache.set_raw(key, std::sprintf(key, "a%d", i), data.c_str(), data.size());
+	}
+	evictions = cache.stats().evictions;
+	test_expect(cache.stats().entries == static_cast<std::size_t>(cap), "shm_cache fill");
+	// 访问过的项在 CLOCK 扫描中保留一轮, 写入新项仅淘汰一项未访问的
+	std::string out;
+	test_expect(cache.get_raw(key, std::sprintf(key, "a%d", 0), out), "shm_cache hot");
+	cache.set_raw("extra", 5, data.c_str(), data.size());
+	test_expect(cache.stats().evictions == evictions + 1 && cache.exists(key, std::sprintf(key, "a%d", 0)) && cache.exists("extra", 5), "shm_cache clock");
+	// 其他规格 (8192 字节块) 无空闲块且无可淘汰的同规格数据时整页回收: 淘汰一整页 (容量为页内项数的整数倍), 其余数据不变
+	std::string big(8000, 'b');
+	evictions = cache.stats().evictions;
+	test_expect(cache.set_raw("big", 3, big.c_str(), big.size()), "shm_cache reassign");
+	int page = static_cast<int>(cache.stats().evictions - evictions);
+	rv["reassign evictions"] = page;
+	test_expect(page > 0 && cap % page == 0, "shm_cache reassign evictions");
+	test_expect(cache.get_raw("big", 3, out) && out == big, "shm_cache reassign value");
+	int survivors = cache.exists("extra", 5) ? 1 : 0;
+	for(int i=0;i<cap;++i) {
+		if(!cache.get_raw(key, std::sprintf(key, "a%d", i), out)) continue;
+		++survivors;
+		test_expect(out == std::string(900, 'a' + i % 26), "shm_cache survivor");
+	}
+	rv["survivors"] = survivors;
+	test_expect(survivors == cap - page && cache.stats().entries == static_cast<std::size_t>(survivors) + 1, "shm_cache entries");
+	// 过期
+	std::uint64_t expired = cache.stats().expired;
+	cache.set_raw("ttl", 3, "x", 1, 1);
+	test_expect(cache.exists("ttl", 3), "shm_cache ttl");
+	::sleep(2);
+	test_expect(!cache.exists("ttl", 3) && cache.stats().expired == expired + 1, "shm_cache expired");
+	// 子进程在持有锁 (复制数据) 时退出: 下次加锁时清空该分段, 之后可继续使用
+	cache.clear();
+	std::string large(cache.max_item() - 5, 'l');
+	int attempts = 0;
+	bool recovered = false;
+	while(!recovered && attempts < 200) {
+		test_expect(cache.set_raw("large", 5, large.c_str(), large.size()), "shm_cache large");
+		pid_t pid = fork();
+		if(pid == 0) {
+			::signal(SIGALRM, test_shm_exit);
+			struct itimerval t = {{0, 0}, {0, 500 + attempts * 50}};
+			setitimer(ITIMER_REAL, &t, nullptr);
+			std::string copy;
+			while(true) cache.get_raw("large", 5, copy);
+		}
+		waitpid(pid, nullptr, 0);
+		++attempts;
+		recovered = !cache.exists("large", 5);
+	}
+	rv["recover attempts"] = attempts;
+	test_expect(recovered, "shm_cache owner died");
+	test_expect(cache.set_raw("after", 5, "y", 1) && cache.get_raw("after", 5, out) && out == "y" && cache.stats().entries == 1, "shm_cache recovered");
+	return rv;
+}
+php::value test_function_23(php::parameters& params) {
+	int procs = params[0], keys = params[1];
+	test_cache->clear();
+	// 各子进程写入不同的键, 父进程读取
+	std::vector<pid_t> pids;
+	for(int p=0;p<procs;++p) {
+		pid_t pid = fork();
+		if(pid == 0) {
+			char key[32];
+			for(int i=0;i<keys;++i) {
+				php::array v(2);
+				v["proc"] = p;
+				v["index"] = i;
+				test_cache->set(key, std::sprintf(key, "%d:%d", p, i), v);
+			}
+			_exit(0);
+		}
+		pids.push_back(pid);
+	}
+	for(auto i=pids.begin(); i!=pids.end(); ++i) waitpid(*i, nullptr, 0);
+	int found = 0;
+	char key[32];
+	auto t0 = std::chrono::steady_clock::now();
+	for(int p=0;p<procs;++p) {
+		for(int i=0;i<keys;++i) {
+			php::value val;
+			if(!test_cache->get(key, std::sprintf(key, "%d:%d", p, i), val)) continue;
+			++found;
+			php::array expect(2);
+			expect["proc"] = p;
+			expect["index"] = i;
+			test_expect(zend_is_identical(val, expect), "shm_cache value");
+		}
+	}
+	php::array rv(8);
+	rv["get ms"] = test_ms(t0);
+	// 索引按最小规格块计算, 全部写入的键 (远小于容量) 均可读取
+	test_expect(found == procs * keys, "shm_cache found");
+	rv["found"] = found;
+	php::shm_cache::stats_t st = test_cache->stats();
+	rv["entries"] = st.entries;
+	rv["memory"] = st.memory;
+	rv["evictions"] = st.evictions;
+	test_expect(st.entries == static_cast<std::size_t>(procs * keys) && st.evictions == 0, "shm_cache stats");
+	rv["small"] = test_shm_cache_small();
+	return rv;
+}
+// 小容量 (4 项) 缓存: 按字节淘汰最久未使用的项, 当前请求中读取过的数据淘汰后仍可使用
+static php::array test_lru_cache_small() {
+	auto item = [] (int i) -> php::value {
+		return php::string(std::string(200, 'a' + i));
+	};
+	char key[8];
+	std::size_t bytes;
+	{
+		php::lru_cache one(1024 * 1024);
+		one.set("k0", 2, item(0));
+		bytes = one.memory();
+	}
+	php::lru_cache cache(bytes * 4 + bytes / 2);
+	for(int i=0;i<4;++i) cache.set(key, std::sprintf(key, "k%d", i), item(i));
+	test_expect(cache.size() == 4 && cache.memory() == bytes * 4 && cache.evictions() == 0, "lru_cache fill");
+	// 读取 k0 使其成为最近使用, 之后依次淘汰 k1, k2
+	php::value held;
+	test_expect(cache.get("k0", 2, held) && zend_is_identical(held, item(0)), "lru_cache get");
+	cache.set("k4", 2, item(4));
+	test_expect(cache.evictions() == 1 && !cache.exists("k1", 2) && cache.exists("k0", 2), "lru_cache evict k1");
+	cache.set("k5", 2, item(5));
+	test_expect(cache.evictions() == 2 && !cache.exists("k2", 2), "lru_cache evict k2");
+	for(const char* k : {"k0", "k3", "k4", "k5"}) test_expect(cache.exists(k, 2), std::string("lru_cache survivor ") + k);
+	// 替换已存在的项不淘汰其他项; 超过容量的单项被拒绝且不影响已有数据
+	cache.set("k3", 2, item(3));
+	test_expect(cache.size() == 4 && cache.evictions() == 2, "lru_cache replace");
+	test_expect(!cache.set("big", 3, php::string(std::string(bytes * 5, 'x'))) && cache.size() == 4 && cache.evictions() == 2, "lru_cache oversize");
+	// 写入新项淘汰全部旧数据 (含已读取的 k0): 释放延迟至下一请求, 已读取的值不受影响
+	for(int i=6;i<10;++i) cache.set(key, std::sprintf(key, "k%d", i), item(i));
+	test_expect(cache.evictions() == 6 && !cache.exists("k0", 2) && cache.memory() == bytes * 4, "lru_cache evict all");
+	test_expect(zend_is_identical(held, item(0)), "lru_cache retired value");
+	php::array rv(4);
+	rv["item bytes"] = bytes;
+	rv["evictions"] = static_cast<std::int64_t>(cache.evictions());
+	return rv;
+}
+php::value test_function_24(php::parameters& params) {
+	php::array data = params[0];
+	int times = params[1];
+	php::lru_cache& cache = php::lru_cache::named("test", 1024 * 1024);
+	php::array rv(8);
+	php::value val;
+	rv["cached"] = cache.get("data", val); // 前一请求写入的数据
+	test_expect(cache.set("data", data), "lru_cache set");
+	test_expect(cache.get("data", val) && zend_is_identical(val, data), "lru_cache get");
+	auto t0 = std::chrono::steady_clock::now();
+	for(int i=0;i<times;++i) cache.get("data", val);
+	rv["get"] = test_ms(t0);
+	php::string packed = php::msgpack_pack(data);
+	t0 = std::chrono::steady_clock::now();
+	for(int i=0;i<times;++i) php::msgpack_unpack(packed);
+	rv["msgpack_unpack"] = test_ms(t0);
+	rv["size"] = cache.size();
+	rv["memory"] = cache.memory();
+	rv["small"] = test_lru_cache_small();
+	return rv;
+}
+php::value test_function_25(php::parameters& params) {
+	php::array data = params[0];
+	php::string path = params[1];
+	int times = params[2];
+	php::array rv(8);
+	auto t0 = std::chrono::steady_clock::now();
+	php::snapshot_builder(data).save(std::string(path.c_str(), path.size()));
+	rv["build"] = test_ms(t0);
+	// 物化的值引用映射内存, 快照保留至进程结束
+	static std::unique_ptr<php::snapshot> snap;
+	t0 = std::chrono::steady_clock::now();
+	snap.reset(new php::snapshot(std::string(path.c_str(), path.size())));
+	rv["load"] = test_ms(t0);
+	rv["size"] = snap->size();
+	test_expect(zend_is_identical(snap->root().to_value(), data), "snapshot");
+	int found = 0;
+	t0 = std::chrono::steady_clock::now();
+	for(int i=0;i<times;++i) if(snap->root()["key_1"]["name"]) ++found;
+	rv["lookup"] = test_ms(t0);
+	test_expect(found == times, "snapshot lookup");
+	// 单字符、字母加数字、空串等非数字键按字符串查找, 规范的数字字符串键按整数下标查找
+	const char* keys[] = {"a", "k1", "", "7", "-3", "07", "1a", "-"};
+	php::array kv(8);
+	for(int i=0;i<8;++i) kv.set(php::string(keys[i]), i + 1);
+	std::string kpath = std::string(path.c_str(), path.size()) + ".keys";
+	php::snapshot_builder(kv).save(kpath);
+	{
+		php::snapshot ks(kpath);
+		for(int i=0;i<8;++i) {
+			test_expect(ks.root()[keys[i]].to_integer() == i + 1, std::string("snapshot key \"") + keys[i] + "\"");
+			test_expect(ks.root()[php::string(keys[i])].to_integer() == i + 1, std::string("snapshot string key \"") + keys[i] + "\"");
+		}
+		test_expect(ks.root()[7].to_integer() == 4 && ks.root()[-3].to_integer() == 5, "snapshot integer key");
+		test_expect(!ks.root()["b"] && !ks.root()["k2"] && !ks.root()["8"], "snapshot missing key");
+	}
+	::unlink(kpath.c_str());
+	php::string packed = php::msgpack_pack(data);
+	t0 = std::chrono::steady_clock::now();
+	for(int i=0;i<times/1000;++i) php::msgpack_unpack(packed);
+	rv["msgpack_unpack (1/1000)"] = test_ms(t0);
+	return rv;
+}
+// 启动基准: 1000 个合成类, 环境变量 PHPEXT_TEST_LAZY=1 时延迟声明
+template <int N>
+class test_synthetic: public php::class_base {
+public:
+	php::value id(php::parameters& params) {
+		return N;
+	}
+	php::value update(php::parameters& params) {
+		set("value", params[0]);
+		return nullptr;
+	}
+	php::value reset(php::parameters& params) {
+		set("value", 0);
+		return nullptr;
+	}
+};
+template <int B, int N>
+struct test_synthetic_register {
+	static void add(php::extension_entry& ext, bool lazy) {
+		test_synthetic_register<B, N / 2>::add(ext, lazy);
+		test_synthetic_register<B + N / 2, N - N / 2>::add(ext, lazy);
+	}
+};
+template <int B>
+struct test_synthetic_register<B, 1> {
+	static void add(php::extension_entry& ext, bool lazy) {
+		php::class_entry<test_synthetic<B>> c("phpext_synthetic_" + std::to_string(B));
+		c.constant({"ID", B});
+		c.property({"value", 0});
+		c.method<&test_synthetic<B>::id>("id");
+		c.method<&test_synthetic<B>::update>("update");
+		c.method<&test_synthetic<B>::reset>("reset");
+		if(lazy) ext.add_lazy(std::move(c));
+		else ext.add(std::move(c));
+	}
+};
+static bool test_startup_lazy = false;
+static std::chrono::steady_clock::time_point test_startup_t0;
+static double test_startup_ms;
+static long test_startup_rss0, test_startup_rss;
+// 当前常驻内存 (KB), 取自 /proc/self/statm 第二项 (页数)
+static long test_rss() {
+	long size = 0, resident = 0;
+	std::FILE* f = std::fopen("/proc/self/statm", "r");
+	if(f == nullptr) return 0;
+	if(std::fscanf(f, "%ld %ld", &size, &resident) != 2) resident = 0;
+	std::fclose(f);
+	return resident * (::sysconf(_SC_PAGESIZE) / 1024);
+}
+php::value test_function_26(php::parameters& params) {
+	php::array rv(8);
+	rv["lazy"] = test_startup_lazy;
+	// 自模块加载至模块启动回调 (含其间其他模块的启动, 两种模式相同)
+	rv["startup ms"] = test_startup_ms;
+	rv["startup rss kb"] = test_startup_rss - test_startup_rss0;
+	std::size_t pending = php::class_entry_base::pending();
+	rv["pending"] = pending;
+	auto t0 = std::chrono::steady_clock::now();
+	// 延迟模式下经自动加载完成声明
+	php::value obj(php::CLASS(php::string("phpext_synthetic_500", 20)));
+	rv["first use ms"] = test_ms(t0);
+	test_expect(obj.instanceof(php::CLASS(php::string("phpext_synthetic_500", 20))), "synthetic class instance");
+	rv["pending after"] = php::class_entry_base::pending();
+	// 延迟模式: 已使用的类完成声明 (1000 个中至少一个); 非延迟模式: 不存在未声明的类
+	test_expect(test_startup_lazy ? php::class_entry_base::pending() < 1000 && php::class_entry_base::pending() <= pending : pending == 0, "lazy declaration");
+	return rv;
+}
+// 延迟任务执行统计 (请求结束后执行, 由下一次调用读取并检查)
+struct test_deferred_stats {
+	bool                     queued;
+	std::size_t              ran;
+	std::size_t              dropped;
+	std::vector<std::string> errors; // 失败的任务名 (按执行顺序)
+};
+static test_deferred_stats test_deferred, test_deferred_expect;
+php::value test_function_27(php::parameters& params) {
+	php::callable cb = params[0];
+	int n = params[1];
+	// 上一请求中加入的任务: 预算 8 个, PHP 回调先于原生任务执行, 超出的被丢弃
+	php::array rv(4), errors(test_deferred.errors.size());
+	rv["ran"] = test_deferred.ran;
+	rv["dropped"] = test_deferred.dropped;
+	for(std::size_t i=0;i<test_deferred.errors.size();++i) errors[i] = test_deferred.errors[i];
+	rv["errors"] = errors;
+	if(test_deferred_expect.queued) {
+		test_expect(test_deferred.ran == test_deferred_expect.ran, "deferred tasks ran");
+		test_expect(test_deferred.dropped == test_deferred_expect.dropped, "deferred tasks dropped");
+		test_expect(test_deferred.errors == test_deferred_expect.errors, "deferred task errors");
+	}
+	test_deferred = test_deferred_stats();
+	test_deferred_expect = test_deferred_stats();
+
+	std::size_t size = php::deferred::size();
+	for(int i=0;i<n;++i) {
+		php::deferred::defer("php_" + std::to_string(i), php::callable([cb, i] (php::parameters&) -> php::value {
+			++test_deferred.ran;
+			return cb.call({i});
+		}));
+	}
+	php::deferred::defer("native", [] () {
+		++test_deferred.ran;
+	});
+	php::deferred::defer("native_error", [] () {
+		++test_deferred.ran;
+		throw std::runtime_error("native task failed");
+	});
+	test_expect(php::deferred::size() == size + n + 2, "deferred queue size");
+	// 回调于第 4 个 (下标 3) 任务抛出异常
+	std::size_t total = n + 2, ran = std::min<std::size_t>(total, 8);
+	test_deferred_expect.queued = true;
+	test_deferred_expect.ran = ran;
+	test_deferred_expect.dropped = total - ran;
+	if(n > 3 && ran > 3) test_deferred_expect.errors.push_back("php_3");
+	if(ran == total) test_deferred_expect.errors.push_back("native_error");
+	return rv;
+}
+// 线程池中执行的计算 (仅访问 std::string)
+static std::string test_fnv_rounds(const std::string& data, int rounds) {
+	std::uint64_t h = 14695981039346656037ull;
+	for(int r=0;r<rounds;++r) {
+		for(auto i=data.begin(); i!=data.end(); ++i) {
+			h ^= static_cast<unsigned char>(*i);
+			h *= 1099511628211ull;
+		}
+	}
+	return std::to_string(h);
+}
+php::value test_function_28(php::parameters& params) {
+	php::string data = params[0];
+	int tasks = params[1];
+	int rounds = params[2];
+	std::string input(data.c_str(), data.size());
+	// 第四个参数为真时等待全部任务完成, 否则返回未完成的 future
+	bool wait = params.length() > 3 && params[3].to_boolean();
+	php::array rv(4), futures(tasks);
+	php::string expect = test_fnv_rounds(input, rounds);
+	auto t0 = std::chrono::steady_clock::now();
+	for(int i=0;i<tasks;++i) test_expect(php::string(test_fnv_rounds(input, rounds)) == expect, "serial result");
+	rv["serial ms"] = test_ms(t0);
+	// 并行耗时含提交及等待全部完成
+	t0 = std::chrono::steady_clock::now();
+	for(int i=0;i<tasks;++i) {
+		futures[i] = php::thread_pool_future::async([input, rounds] () -> std::string {
+			return test_fnv_rounds(input, rounds);
+		});
+	}
+	if(wait) {
+		for(int i=0;i<tasks;++i) {
+			php::string r = php::object(futures[i]).call("wait");
+			test_expect(r == expect, "future result");
+		}
+		rv["parallel ms"] = test_ms(t0);
+	}
+	rv["futures"] = futures;
+	rv["expect"] = expect;
+	return rv;
+}
+// 时间轮: 随机定时器 (含跨层、超出范围、取消、重复) 均于到期 tick 执行
+php::value test_function_29(php::parameters& params) {
+	int count = params[0];
+	php::timer_wheel w;
+	std::uint64_t fired = 0, late = 0, cancelled = 0, repeats = 0, id = 0;
+	std::srand(count);
+	for(int i=0;i<count;++i) {
+		std::uint64_t e = i % 4 == 0 ? 1 + std::rand() % 64 : i % 4 == 1 ? 1 + std::rand() % 300000
+			: i % 4 == 2 ? 1 + std::rand() % (1 << 25) : (1ull << 30) + std::rand() % 1000;
+		id = w.add(e, [&w, e, &fired, &late] () {
+			++fired;
+			if(w.now() != e) ++late;
+		});
+		if(i % 7 == 0 && w.cancel(id)) ++cancelled;
+	}
+	id = w.add(100, [&w, &id, &repeats] () {
+		if(++repeats == 10) w.cancel(id);
+	}, 33);
+	auto t0 = std::chrono::steady_clock::now();
+	w.advance(1ull << 31);
+	php::array rv(6);
+	rv["fired"] = static_cast<std::int64_t>(fired);
+	rv["late"] = static_cast<std::int64_t>(late);
+	rv["cancelled"] = static_cast<std::int64_t>(cancelled);
+	rv["repeats"] = static_cast<std::int64_t>(repeats);
+	rv["pending"] = w.size();
+	rv["advance ms"] = test_ms(t0);
+	test_expect(fired + cancelled == static_cast<std::uint64_t>(count), "timer_wheel fired + cancelled");
+	test_expect(late == 0, "timer_wheel late");
+	test_expect(repeats == 10, "timer_wheel repeats");
+	test_expect(w.size() == 0, "timer_wheel pending");
+	return rv;
+}
+// 差异对比: php::bin2hex / hex2bin / url_encode / url_decode 与内置 bin2hex() / hex2bin() / urlencode() / rawurlencode() / urldecode() / rawurldecode() 结果一致
+php::value test_function_30(php::parameters& params) {
+	int count = params[0];
+	php::callable bin2hex_fn("bin2hex"), hex2bin_fn("hex2bin"), strtoupper_fn("strtoupper");
+	auto php_encode = [] (const std::string& s, bool raw) -> std::string {
+		zend_string* r = raw ? php_raw_url_encode(s.data(), s.size()) : php_url_encode(s.data(), s.size());
+		std::string x(ZSTR_VAL(r), ZSTR_LEN(r));
+		zend_string_release(r);
+		return x;
+	};
+	auto php_decode = [] (std::string s, bool raw) -> std::string {
+		s.resize(raw ? php_raw_url_decode(&s[0], s.size()) : php_url_decode(&s[0], s.size()));
+		return s;
+	};
+	auto encode = [] (const std::string& s, bool raw) -> std::string {
+		php::string r = php::url_encode(s.data(), s.size(), raw);
+		return std::string(r.c_str(), r.size());
+	};
+	auto decode = [] (const std::string& s, bool raw) -> std::string {
+		php::string r = php::url_decode(s.data(), s.size(), raw);
+		return std::string(r.c_str(), r.size());
+	};
+	std::srand(count);
+	std::vector<std::string> samples;
+	// 全部 256 个字节值 (单独及连续), 及覆盖批量 / 尾部路径的各长度随机数据
+	std::string all(256, '\0');
+	for(int i=0;i<256;++i) {
+		all[i] = static_cast<char>(i);
+		samples.push_back(std::string(1, static_cast<char>(i)));
+	}
+	samples.push_back(all);
+	for(int i=0;i<count;++i) {
+		std::string s(i < 100 ? i : std::rand() % 4096, '\0');
+		// 半数样本仅含无需转义的字符, 以覆盖整块直接复制的路径
+		for(auto& c : s) c = static_cast<char>(i % 2 ? std::rand() : 'a' + std::rand() % 26);
+		samples.push_back(s);
+	}
+	for(const auto& s : samples) {
+		const unsigned char* src = reinterpret_cast<const unsigned char*>(s.data());
+		php::string hex = php::bin2hex(src, s.size());
+		test_expect(hex == php::string(bin2hex_fn({php::string(s)})), "bin2hex");
+		test_expect(php::php_hex2bin(reinterpret_cast<const unsigned char*>(hex.c_str()), hex.size()) == php::string(s), "hex2bin");
+		php::string upper = strtoupper_fn({hex});
+		test_expect(php::php_hex2bin(reinterpret_cast<const unsigned char*>(upper.c_str()), upper.size()) == php::string(hex2bin_fn({upper})), "hex2bin (upper)");
+		for(bool raw : {false, true}) {
+			std::string text = php_encode(s, raw);
+			test_expect(encode(s, raw) == text, raw ? "rawurlencode" : "urlencode");
+			test_expect(decode(text, raw) == s, raw ? "rawurldecode" : "urldecode");
+			// 任意输入 (含非法的 '%' 序列) 的解码
+			test_expect(decode(s, raw) == php_decode(s, raw), raw ? "rawurldecode (raw input)" : "urldecode (raw input)");
+		}
+	}
+	// 非法十六进制字符
+	for(std::string s : {"0g", "zz", "12 4", "ab\x80\x81"}) {
+		bool thrown = false;
+		try{
+			php::php_hex2bin(reinterpret_cast<const unsigned char*>(s.data()), s.size());
+		}catch(const php::exception& ex) {
+			thrown = true;
+		}
+		test_expect(thrown, "hex2bin (invalid): " + s);
+	}
+	// 非法 / 不完整的 '%' 序列
+	std::vector<std::string> malformed = {"%", "%%", "%2", "%g0", "%0g", "%%41", "%4%41", "a%", "a%2", "%2B+%2b", "%zz%41+", std::string("%\0" "41", 4)};
+	static const char alphabet[] = "%%%+09afAFgz\x80 ";
+	for(int i=0;i<count;++i) {
+		std::string s(std::rand() % 80, '\0');
+		for(auto& c : s) c = alphabet[std::rand() % (sizeof(alphabet) - 1)];
+		malformed.push_back(s);
+	}
+	for(const auto& s : malformed) {
+		for(bool raw : {false, true}) {
+			test_expect(decode(s, raw) == php_decode(s, raw), (raw ? "rawurldecode (malformed): " : "urldecode (malformed): ") + s);
+			// 原地解码
+			std::string x = s;
+			x.resize(php::url_decode_inplace(&x[0], x.size(), raw));
+			test_expect(x == php_decode(s, raw), (raw ? "rawurldecode (inplace): " : "urldecode (inplace): ") + s);
+		}
+	}
+	return static_cast<std::int64_t>(samples.size() + malformed.size());
+}
 //
+// 数组常量及数组属性默认值 (模块启动时深复制为持久不可变数组)
+static php::array test_table() {
+	php::array table(4), codes(3);
+	codes[0] = 200;
+	codes[1] = 301;
+	codes[2] = 404;
+	table["name"] = "phpext";
+	table["codes"] = codes;
+	table["ratio"] = 0.5;
+	return table;
+}
+// 类的数组常量与数组属性默认值 (PHP < 7.3 以 null 声明后替换默认值): 读取不变, 写入时分离, 不影响常量及之后创建的对象
+php::value test_function_31(php::parameters& params) {
+	php::array expect = test_table();
+	test_expect(zend_is_identical(php::callable("constant")({"test_class_1::CONSTANT_2"}), expect), "class array constant");
+	php::object o1(php::CLASS(php::string("test_class_1")));
+	test_expect(zend_is_identical(o1.get("property_3"), expect), "array property default");
+	php::array p = o1.get("property_3");
+	p["name"] = "changed";
+	php::array codes = p.get(php::string("codes"));
+	codes[3] = 500;
+	p["codes"] = codes;
+	o1.set("property_3", p);
+	php::array changed = o1.get("property_3");
+	test_expect(php::string(changed.get(php::string("name"))) == php::string("changed") && php::array(changed.get(php::string("codes"))).size() == 4, "array property write");
+	php::object o2(php::CLASS(php::string("test_class_1")));
+	test_expect(zend_is_identical(o2.get("property_3"), expect), "array property default after write");
+	test_expect(zend_is_identical(php::callable("constant")({"test_class_1::CONSTANT_2"}), expect), "class array constant after write");
+	return changed;
+}
 class test_class_1: public php::class_base {
 public:
 	// 属性操作方式 1
@@ -117,7 +1368,51 @@ extern "C" {
 		php::class_entry<php::closure> class_closure("ext_closure");
 		class_closure.method<&php::closure::__invoke>("__invoke");
 		ext.add(std::move(class_closure));
+		php::class_entry<php::lru_cache_object> class_lru_cache("phpext_lru_cache");
+		class_lru_cache
+			.method<&php::lru_cache_object::__construct>("__construct")
+			.method<&php::lru_cache_object::get>("get")
+			.method<&php::lru_cache_object::set>("set")
+			.method<&php::lru_cache_object::has>("has")
+			.method<&php::lru_cache_object::remove>("delete")
+			.method<&php::lru_cache_object::clear>("clear")
+			.method<&php::lru_cache_object::stats>("stats");
+		ext.add(std::move(class_lru_cache));
+		php::class_entry<php::thread_pool_future> class_future("phpext_future");
+		class_future
+			.method<&php::thread_pool_future::wait>("wait")
+			.method<&php::thread_pool_future::done>("done")
+			.method<&php::thread_pool_future::cancel>("cancel");
+		ext.add(std::move(class_future));
+		php::class_entry<php::event_loop_object> class_event_loop("phpext_event_loop");
+		class_event_loop
+			.method<&php::event_loop_object::after>("after")
+			.method<&php::event_loop_object::every>("every")
+			.method<&php::event_loop_object::cancel>("cancel")
+			.method<&php::event_loop_object::connect>("connect")
+			.method<&php::event_loop_object::listen>("listen")
+			.method<&php::event_loop_object::run>("run")
+			.method<&php::event_loop_object::run_until>("run_until")
+			.method<&php::event_loop_object::stop>("stop")
+			.method<&php::event_loop_object::now>("now");
+		ext.add(std::move(class_event_loop));
+		php::class_entry<php::event_socket_object> class_event_socket("phpext_event_socket");
+		class_event_socket
+			.method<&php::event_socket_object::on_data>("on_data")
+			.method<&php::event_socket_object::on_close>("on_close")
+			.method<&php::event_socket_object::write>("write")
+			.method<&php::event_socket_object::close>("close")
+			.method<&php::event_socket_object::address>("address")
+			.method<&php::event_socket_object::peer>("peer")
+			.method<&php::event_socket_object::buffered>("buffered");
+		ext.add(std::move(class_event_socket));
+		ext.threads(4);
 
+		// 数组常量: 模块启动时深复制为持久不可变数组 (ZTS 下不支持)
+		php::array table = test_table();
+#ifndef ZTS
+		ext.constant({"CONSTANT_3", table});
+#endif
 		ext
 			.desc({"DESC_1", "DESC_CONTENT_111111111111111111111111"})
 			.desc({"DESC_2", "DESC_CONTENT_22222222222222222222"})
@@ -125,6 +1420,12 @@ extern "C" {
 			.constant({"CONSTANT_2", "THIS_IS_EXTENSION_CONSTANT"})
 			.ini({"config_1", "default_1"})
 			.ini({"config_2", "default_2"})
+			.ini({"phpext.limit", 100}, &test_globals::limit)
+			.ini({"phpext.debug", false}, &test_globals::debug)
+			.ini({"phpext.ratio", 0.75}, &test_globals::ratio)
+			.ini({"phpext.buffer_size", "8M"}, &test_globals::buffer_size)
+			.ini({"phpext.mode", "fast"}, &test_globals::mode, {{"fast", 1}, {"safe", 2}, {"debug", 3}})
+			.ini({"phpext.name", "phpext"}, &test_globals::name)
 			.function<test_function_1>("test_function_1", {
 				{"boolean", php::TYPE::BOOLEAN}, // 基础类型无法强化检查 (用户代码需要自行检查)
 			})
@@ -138,18 +1439,67 @@ extern "C" {
 				{"arg2", php::TYPE::CALLABLE}, // Callable 被“强化”确认类型正确
 			})
 			.function<test_function_5>("test_function_5")
-			.function<test_function_6>("test_function_6");
+			.function<test_function_6>("test_function_6")
+			.function<test_function_7>("test_function_7")
+			.function<test_function_8>("test_function_8")
+			.function<test_function_9>("test_function_9")
+			.function<test_function_10>("test_function_10")
+			.function<test_function_11>("test_function_11")
+			.function<test_function_12>("test_function_12")
+			.function<test_function_13>("test_function_13")
+			.function<test_function_14>("test_function_14")
+			.function<test_function_15>("test_function_15")
+			.function<test_function_16>("test_function_16")
+			.function<test_function_17>("test_function_17")
+			.function<test_function_18>("test_function_18")
+			.function<test_function_19>("test_function_19")
+			.function<test_function_20>("test_function_20")
+			.function<test_function_21>("test_function_21")
+			.function<test_function_22>("test_function_22")
+			.function<test_function_23>("test_function_23")
+			.function<test_function_24>("test_function_24")
+			.function<test_function_25>("test_function_25")
+			.function<test_function_26>("test_function_26")
+			.function<test_function_27>("test_function_27")
+			.function<test_function_28>("test_function_28")
+			.function<test_function_29>("test_function_29")
+			.function<test_function_30>("test_function_30")
+			.function<test_function_31>("test_function_31");
+		ext.declare_globals<test_globals>();
+		const char* lazy = std::getenv("PHPEXT_TEST_LAZY");
+		test_startup_lazy = lazy && std::strcmp(lazy, "1") == 0;
+		test_synthetic_register<0, 1000>::add(ext, test_startup_lazy);
+		ext.on_module_startup([] (php::extension_entry&) -> bool {
+			php::deferred::budget(8, 100);
+			php::deferred::on_error([] (const std::string& name, const std::string& error) {
+				if(error == "budget exceeded") ++test_deferred.dropped;
+				else test_deferred.errors.push_back(name);
+			});
+			test_startup_ms = test_ms(test_startup_t0);
+			test_startup_rss = test_rss();
+			test_cache.reset(new php::shm_cache(16 * 1024 * 1024));
+			return true;
+		});
+		ext.on_request_startup([] (php::extension_entry&) -> bool {
+			test_globals& g = php::extension_entry::globals<test_globals>();
+			++g.requests;
+			g.calls = 0;
+			return true;
+		});
 
-		// php::class_entry<test_class_1> class_test_1("test_class_1");
-		// class_test_1.constant({"CONSTANT_1", 333333});
-		// class_test_1.constant({"CONSTANT_1", "THIS_IS_CLASS_CONSTANT"});
-		// class_test_1.property({"property_1", 123456});
-		// class_test_1.property({"property_2", nullptr});
-		// class_test_1.method<&test_class_1::method_1>("method_1");
-		// class_test_1.method<&test_class_1::method_2>("method_2");
-		// class_test_1.method<&test_class_1::method_3>("method_3");
-		// ext.add(std::move(class_test_1));
+		php::class_entry<test_class_1> class_test_1("test_class_1");
+		class_test_1.constant({"CONSTANT_1", 333333});
+		class_test_1.property({"property_1", 123456});
+		class_test_1.property({"property_2", nullptr});
+		class_test_1.constant({"CONSTANT_2", table});
+		class_test_1.property({"property_3", table});
+		class_test_1.method<&test_class_1::method_1>("method_1");
+		class_test_1.method<&test_class_1::method_2>("method_2");
+		class_test_1.method<&test_class_1::method_3>("method_3");
+		ext.add(std::move(class_test_1));
 
+		test_startup_rss0 = test_rss();
+		test_startup_t0 = std::chrono::steady_clock::now();
 		return ext;
 	}
 };
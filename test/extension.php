@@ -75,3 +75,264 @@ test_function_4(new DateTime(), function(/*$json*/) {
 // var_dump($obj->property_2);
 // echo "    method_3:\n";
 // var_dump($obj->method_3());
+// echo "========================================================\n";
+// echo "test_function_7:\n";
+// echo "--------------------------------------------------------\n";
+// foreach(["", "a", "123456789", str_repeat("abcdefghijklmnopqrstuvwxyz", 1000)] as $s) {
+// 	var_dump(test_function_7($s) === crc32($s));
+// }
+// echo "========================================================\n";
+// echo "test_function_8:\n";
+// echo "--------------------------------------------------------\n";
+// foreach([64, 1024, 1024 * 1024] as $size) {
+// 	echo $size, ": ", json_encode(test_function_8($size, intval(64 * 1024 * 1024 / $size))), "\n";
+// }
+// echo "========================================================\n";
+// echo "test_function_9:\n";
+// echo "--------------------------------------------------------\n";
+// class test_serializable implements JsonSerializable {
+// 	public $a = 1;
+// 	protected $b = 2;
+// 	function jsonSerialize() { return ["self" => $this->a, "x" => [1.5, -0.0, 1e20]]; }
+// }
+// $ref = [1, 2];
+// $ref[] = &$ref;
+// foreach([null, true, 123, -1.25, 0.1, 1e15, 1e300, NAN, "a/b\"c\n\x01 中文 \u{2028}", "\xff",
+// 	[1, 2, 3], [1 => 1, 2 => 2], ["a" => new DateTime("2000-01-01"), "b" => new test_serializable()],
+// 	$ref, array_fill(0, 1000, str_repeat("abcdefghijklmnopqrstuvwxyz", 4))] as $v) {
+// 	echo json_encode(test_function_9($v, 1000)), "\n";
+// }
+// echo "========================================================\n";
+// echo "test_function_10:\n";
+// echo "--------------------------------------------------------\n";
+// $items = [];
+// for($i=0;$i<2000;++$i) $items[] = ["id" => $i, "name" => "item $i", "tags" => ["a", "b", "c"], "extra" => str_repeat("x", 32)];
+// $json = json_encode(["meta" => ["total" => 2000], "items" => $items]);
+// echo json_encode(test_function_10($json, ["items", 1234, "tags", 2], 100)), "\n";
+// var_dump(test_function_10($json, ["items", 3], 1)["value"] === json_decode($json, true)["items"][3]);
+// echo "========================================================\n";
+// echo "test_function_11:\n";
+// echo "--------------------------------------------------------\n";
+// $lines = [null, 123, -1.5e3, "a\u{4e2d}\u{1f600}/\n", [1, [2, [3]]], ["k" => ["x" => true, "0" => false]], $items];
+// $ndjson = implode("\n", array_map("json_encode", $lines)) . "\n";
+// foreach([1, 7, 4096] as $chunk) {
+// 	var_dump(test_function_11($ndjson, $chunk) === array_map(function($line) { return json_decode(json_encode($line), true); }, $lines));
+// }
+// try {
+// 	test_function_11("[1, 2", 1);
+// } catch(Error $e) {
+// 	echo get_class($e), ": ", $e->getMessage(), " (", json_last_error(), ")\n";
+// }
+// echo "========================================================\n";
+// echo "test_function_12:\n";
+// echo "--------------------------------------------------------\n";
+// echo test_function_12(2, true, 1)["json"], "\n";
+// $r = test_function_12(1000, false, 100);
+// unset($r["json"]);
+// echo json_encode($r), "\n";
+// echo "========================================================\n";
+// echo "test_function_13:\n";
+// echo "--------------------------------------------------------\n";
+// $rows = [];
+// for($i=0;$i<1000;++$i) $rows[] = ["id" => $i, "score" => $i / 7, "name" => "user $i", "active" => $i % 2 == 0, "tags" => ["x", "y"], "meta" => null];
+// foreach([[1, -1, 255, -33, 65536, PHP_INT_MAX, PHP_INT_MIN, 0.5, "", str_repeat("a", 70000), [3 => "a", "b" => [true, false, null]]], $rows] as $data) {
+// 	echo json_encode(test_function_13($data, 100)), "\n";
+// }
+// echo "========================================================\n";
+// echo "test_function_14:\n";
+// echo "--------------------------------------------------------\n";
+// foreach(["http://user:pw@example.com:8080/p/a/t/h?id=123&name=a%20b&x[]=1&flag#frag", "//example.com/path?a=1", "localhost:80", "http://[::1]:443/", "http://host:99999/", "//host:80abc", "file:///c:/x", ""] as $url) {
+// 	$r = test_function_14($url, 100000);
+// 	if($r) {
+// 		parse_str(parse_url($url, PHP_URL_QUERY), $args);
+// 		var_dump($r["args"], $args);
+// 	}
+// 	echo json_encode($r), "\n";
+// }
+// echo "========================================================\n";
+// echo "test_function_15:\n";
+// echo "--------------------------------------------------------\n";
+// foreach(["Content-Type", "X-Forwarded-For-Some-Long-Header-Name", str_repeat("AbCdEfGh\xC3\x80", 512)] as $str) {
+// 	$r = test_function_15($str, 100000);
+// 	var_dump($r["lower"] === strtolower($str), $r["upper"] === strtoupper($str));
+// 	unset($r["lower"], $r["upper"]);
+// 	echo json_encode($r), "\n";
+// }
+// echo "========================================================\n";
+// echo "test_function_16:\n";
+// echo "--------------------------------------------------------\n";
+// foreach([16, 256, 64 * 1024] as $size) {
+// 	echo $size, ": ", json_encode(test_function_16(random_bytes($size), intval(64 * 1024 * 1024 / $size))), "\n";
+// }
+// echo "========================================================\n";
+// echo "test_function_17:\n";
+// echo "--------------------------------------------------------\n";
+// $inputs = [];
+// for($i=0;$i<1000;++$i) $inputs[] = "etag:" . $i . ":" . str_repeat("x", $i % 130);
+// $r = test_function_17($inputs, 100);
+// unset($r["md5"], $r["sha1"]);
+// echo json_encode($r), "\n";
+// echo "========================================================\n";
+// echo "test_function_18:\n";
+// echo "--------------------------------------------------------\n";
+// foreach(["2024-02-29T12:34:56.789012+08:00", "1969-12-31T23:59:59.5Z", "2020-06-01 08:00:00-05:30", "2020-06-01T00:00:00Z", "2024-02-30T00:00:00Z"] as $iso) {
+// 	$r = test_function_18($iso, 100000);
+// 	if($r) {
+// 		var_dump($r["datetime"] == new DateTime($iso));
+// 		var_dump($r["local"]->getTimezone()->getName() === date_default_timezone_get(), $r["local"] == $r["datetime"]);
+// 		foreach(["datetime", "local", "ms"] as $key) $r[$key] = $r[$key]->format(DATE_RFC3339_EXTENDED);
+// 	}
+// 	echo json_encode($r), "\n";
+// }
+// echo "========================================================\n";
+// echo "test_function_19:\n";
+// echo "--------------------------------------------------------\n";
+// echo json_encode(test_function_19(["0", "-9223372036854775808", "9223372036854775808", "1f", "zz", "1.5", ".5e-3", "2.2250738585072014e-308", "17976931348623157e292"], 36, 1)), "\n";
+// $floats = [];
+// for($i=0;$i<10000;++$i) $floats[] = (string) (mt_rand() / mt_getrandmax() * pow(10, mt_rand(-20, 20)));
+// $r = test_function_19($floats, 10, 100);
+// var_dump($r["float"] === array_map("floatval", $floats), $r["float_batch"] === count($floats));
+// unset($r["integer"], $r["float"]);
+// echo json_encode($r), "\n";
+// echo "========================================================\n";
+// echo "test_function_20:\n";
+// echo "--------------------------------------------------------\n";
+// ini_set("serialize_precision", -1);
+// echo json_encode(test_function_20(1000000)), "\n";
+// echo "========================================================\n";
+// echo "test_function_21:\n";
+// echo "--------------------------------------------------------\n";
+// test_function_21(0);
+// echo json_encode(test_function_21(10000000)), "\n";
+// echo "========================================================\n";
+// echo "test_function_22:\n";
+// echo "--------------------------------------------------------\n";
+// echo json_encode(test_function_22(1000000)), "\n";
+// var_dump(ini_set("phpext.limit", "12a"), ini_set("phpext.mode", "other"), ini_set("phpext.buffer_size", "-1K"));
+// var_dump(ini_set("phpext.limit", "200"), ini_set("phpext.debug", "yes"), ini_set("phpext.buffer_size", "64k"), ini_set("phpext.mode", "SAFE"), ini_set("phpext.name", "changed"));
+// echo json_encode(test_function_22(0)), "\n";
+// ini_restore("phpext.limit");
+// echo json_encode(test_function_22(0)), "\n";
+// echo "========================================================\n";
+// echo "test_function_23:\n";
+// echo "--------------------------------------------------------\n";
+// // found == entries == 80000, evictions == 0; small: 小容量缓存的 CLOCK 淘汰、整页回收、过期及锁持有者退出后的恢复 (约 2 秒)
+// echo json_encode(test_function_23(8, 10000)), "\n";
+// echo "========================================================\n";
+// echo "test_function_24:\n";
+// echo "--------------------------------------------------------\n";
+// $data = [];
+// for($i=0;$i<1000;++$i) $data["key_".$i] = ["id" => $i, "name" => "name_".$i, "tags" => ["a", "b", "c"]];
+// // small: 4 项容量的缓存依次淘汰最久未使用的项, 已读取的值在淘汰后仍可使用
+// echo json_encode(test_function_24($data, 100000)), "\n";
+// $cache = new phpext_lru_cache("routes", 64 * 1024);
+// var_dump($cache->set("a", [1, 2, ["x" => "y"]]), $cache->get("a"), $cache->get("b", "default"), $cache->has("a"));
+// $a = $cache->get("a");
+// $a[] = 4; // 分离为请求内副本
+// var_dump($cache->delete("a"), $cache->has("a"), $a);
+// for($i=0;$i<1000;++$i) $cache->set("k".$i, str_repeat("x", 1000));
+// var_dump($cache->stats());
+// echo "========================================================\n";
+// echo "CONSTANT_3:\n";
+// echo "--------------------------------------------------------\n";
+// var_dump(CONSTANT_3);
+// $c = CONSTANT_3;
+// $c["codes"][] = 500; // 分离为请求内副本, 常量不变
+// var_dump($c["codes"], CONSTANT_3["codes"]);
+// $t0 = microtime(true);
+// for($i=0;$i<1000000;++$i) $c = CONSTANT_3;
+// echo "constant: ", (microtime(true) - $t0) * 1000, "ms\n";
+// echo "========================================================\n";
+// echo "test_function_25:\n";
+// echo "--------------------------------------------------------\n";
+// $data = [];
+// for($i=0;$i<1000;++$i) $data["key_".$i] = ["id" => $i, "name" => "name_".$i, "score" => $i / 10, "tags" => ["a", "b", "c"]];
+// echo json_encode(test_function_25($data, "/tmp/phpext_snapshot.bin", 1000000)), "\n";
+// echo "========================================================\n";
+// echo "test_function_26:\n";
+// echo "--------------------------------------------------------\n";
+// // 分别以 PHPEXT_TEST_LAZY=0 / PHPEXT_TEST_LAZY=1 运行比较
+// echo json_encode(test_function_26()), "\n";
+// var_dump(class_exists("phpext_synthetic_1", false), class_exists("phpext_synthetic_1"), phpext_synthetic_1::ID);
+// $o = new phpext_synthetic_2();
+// $o->update(10);
+// var_dump($o->id(), $o->value, $o instanceof phpext_synthetic_2);
+// echo "========================================================\n";
+// echo "test_function_27:\n";
+// echo "--------------------------------------------------------\n";
+// // 任务于请求结束后执行; 预算 8 个任务, 第 3 个抛出异常, 余下被丢弃并报告
+// // 返回并检查上一请求中任务的执行统计 (FPM / 内置服务器下再次请求): ran 8, dropped 4, errors ["php_3"]
+// echo json_encode(test_function_27(function($i) {
+// 	if($i == 3) throw new Exception("php task failed");
+// 	echo "deferred php task: ", $i, "\n";
+// }, 10)), "\n";
+// echo "========================================================\n";
+// echo "test_function_28:\n";
+// echo "--------------------------------------------------------\n";
+// $r = test_function_28(str_repeat("abcdefgh", 1024 * 128), 8, 4, true);
+// echo "serial: ", $r["serial ms"], "ms, parallel: ", $r["parallel ms"], "ms\n";
+// $r = test_function_28(str_repeat("x", 1024 * 1024), 16, 64);
+// var_dump($r["futures"][0]->wait(0.001), $r["futures"][15]->cancel(), $r["futures"][15]->done());
+// try { $r["futures"][15]->wait(); } catch(Error $e) { echo $e->getMessage(), "\n"; }
+// // 余下未完成的任务于请求结束时取消
+// echo "========================================================\n";
+// echo "test_function_29:\n";
+// echo "--------------------------------------------------------\n";
+// // fired + cancelled == 10000, late == 0, repeats == 10, pending == 0
+// echo json_encode(test_function_29(10000)), "\n";
+// // 回环测试: TCP / Unix 回显服务
+// $loop = new phpext_event_loop();
+// $path = sys_get_temp_dir() . "/phpext_event_loop.sock";
+// @unlink($path);
+// foreach(["tcp://127.0.0.1:0", "unix://" . $path] as $address) {
+// 	$server = $loop->listen($address, function($conn) {
+// 		$conn->on_data(function($conn, $data) { $conn->write($data); });
+// 	});
+// 	$payload = str_repeat("0123456789abcdef", 256 * 1024); // 4MB, 写缓冲
+// 	$received = "";
+// 	$closed = false;
+// 	$client = $loop->connect(strpos($address, "unix://") === 0 ? $address : $server->address(), function($conn, $error) use($payload) {
+// 		var_dump($error);
+// 		echo $conn->address(), " -> ", $conn->peer(), "\n";
+// 		$conn->write($payload);
+// 	});
+// 	$client->on_data(function($conn, $data) use(&$received, $payload) {
+// 		$received .= $data;
+// 		if(strlen($received) == strlen($payload)) $conn->close();
+// 	});
+// 	$client->on_close(function($conn, $error) use(&$closed) { $closed = true; });
+// 	var_dump($loop->run_until(function() use(&$closed) { return $closed; }, 5), $received === $payload);
+// 	$server->close();
+// }
+// var_dump(file_exists($path));
+// // 连接被拒绝
+// $loop->connect("127.0.0.1:1", function($conn, $error) { echo $error, "\n"; });
+// $loop->run();
+// // 定时器: 10, 30 (20 被取消), 每 5ms 执行 4 次
+// $t0 = $loop->now();
+// $loop->after(30, function() { echo "after 30\n"; });
+// $loop->after(10, function() { echo "after 10\n"; });
+// $loop->cancel($loop->after(20, function() { echo "after 20\n"; }));
+// $n = 0;
+// $id = $loop->every(5, function() use($loop, &$n, &$id) { if(++$n == 4) $loop->cancel($id); });
+// $loop->run();
+// echo $n, " ", $loop->now() - $t0, "ms\n";
+// $loop->after(1000, function() {});
+// var_dump($loop->run_until(function() { return false; }, 0.05));
+// // 销毁时关闭全部套接字且不执行回调 (含回调持有套接字自身的循环引用), Unix 套接字文件随之删除
+// $server = $loop->listen("unix://" . $path, function($conn) {});
+// $server->on_close(function($conn, $error) use($server) { echo "not called\n"; });
+// unset($server, $loop);
+// var_dump(file_exists($path));
+// echo "========================================================\n";
+// echo "test_function_30:\n";
+// echo "--------------------------------------------------------\n";
+// echo test_function_30(1000), "\n";
+// echo "========================================================\n";
+// echo "test_function_31:\n";
+// echo "--------------------------------------------------------\n";
+// // 类的数组常量与数组属性默认值: 写入对象属性时分离, 常量及新对象的默认值不变
+// var_dump(test_function_31());
+// $o = new test_class_1();
+// $o->property_3["codes"][] = 500;
+// var_dump($o->property_3["codes"], (new test_class_1())->property_3["codes"], test_class_1::CONSTANT_2["codes"]);